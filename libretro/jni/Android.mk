@@ -24,6 +24,6 @@ CORE_DIR = ../..
 include $(CORE_DIR)/libretro/Makefile.common
 
 LOCAL_SRC_FILES += $(SOURCES_CXX) $(SOURCES_C)
-LOCAL_CXXFLAGS += -DANDROID -D__LIBRETRO__ -DINLINE=inline -DHAVE_STDINT_H -DHAVE_INTTYPES_H -DNST_NO_ZLIB -fexceptions $(INCFLAGS)
+LOCAL_CXXFLAGS += -DANDROID -D__LIBRETRO__ -DINLINE=inline -DHAVE_STDINT_H -DHAVE_INTTYPES_H -DNST_NO_ZLIB -DNST_NO_THREADS -fexceptions $(INCFLAGS)
 
 include $(BUILD_SHARED_LIBRARY)
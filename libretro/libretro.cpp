@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <sstream>
 #include <fstream>
+#include <vector>
 
 #include "../source/core/api/NstApiMachine.hpp"
 #include "../source/core/api/NstApiEmulator.hpp"
@@ -16,6 +17,7 @@
 #include "../source/core/api/NstApiCartridge.hpp"
 #include "../source/core/api/NstApiUser.hpp"
 #include "../source/core/api/NstApiFds.hpp"
+#include "../source/core/api/NstApiMemory.hpp"
 
 #define NST_VERSION "1.48-WIP"
 
@@ -42,8 +44,16 @@ extern "C" void linearFree(void* mem);
 #endif
 static uint32_t* video_buffer = NULL;
 
-static int16_t audio_buffer[(44100 / 50)];
-static int16_t audio_stereo_buffer[2 * (44100 / 50)];
+#define SAMPLERATE 44100
+
+// NTSC and PAL/Dendy frame rates as exact fractions of the master clocks
+#define FPS_NTSC_NUM 39375000
+#define FPS_NTSC_DEN 655171
+#define FPS_PAL_NUM  26601712
+#define FPS_PAL_DEN  531960
+
+static int16_t audio_buffer[2 * (SAMPLERATE / 50 + 1)];
+static uint64_t audio_frac;
 static Api::Emulator emulator;
 static Api::Machine *machine;
 static Api::Fds *fds;
@@ -66,6 +76,9 @@ static Api::Machine::FavoredSystem favsystem;
 
 static void *sram;
 static unsigned long sram_size;
+static size_t state_size;
+static const size_t state_headroom = 0x2000;
+static std::vector<char> state_scratch;
 static bool is_pal;
 static bool dbpresent;
 static unsigned char *custpal[64*3];
@@ -226,6 +239,8 @@ void retro_init(void)
 
    machine = new Api::Machine(emulator);
    input = new Api::Input::Controllers;
+   video = new Api::Video::Output(video_buffer, video_width * sizeof(uint32_t));
+   audio = new Api::Sound::Output(audio_buffer);
    Api::User::fileIoCallback.Set(file_io_callback, 0);
 
    if (environ_cb(RETRO_ENVIRONMENT_GET_LOG_INTERFACE, &log))
@@ -283,7 +298,10 @@ void retro_get_system_info(struct retro_system_info *info)
 
 void retro_get_system_av_info(struct retro_system_av_info *info)
 {
-   const retro_system_timing timing = { is_pal ? 50.0 : 60.0, 44100.0 };
+   const retro_system_timing timing = {
+      is_pal ? double(FPS_PAL_NUM) / FPS_PAL_DEN : double(FPS_NTSC_NUM) / FPS_NTSC_DEN,
+      SAMPLERATE
+   };
    info->timing = timing;
 
    // It's better if the size is based on NTSC_WIDTH if the filter is on
@@ -307,6 +325,7 @@ void retro_set_environment(retro_environment_t cb)
       { "nestopia_palette", "Palette; consumer|canonical|alternative|rgb|yuv-v3|unsaturated-v6|pal|raw|custom" },
       { "nestopia_nospritelimit", "Remove 8-sprites-per-scanline hardware limit; disabled|enabled" },
       { "nestopia_fds_auto_insert", "Automatically insert first FDS disk on reset; enabled|disabled" },
+      { "nestopia_fds_fast_load", "Fast FDS disk loading; disabled|enabled" },
       { "nestopia_overscan_v", "Mask Overscan (Vertical); enabled|disabled" },
       { "nestopia_overscan_h", "Mask Overscan (Horizontal); disabled|enabled" },
       { "nestopia_aspect" ,  "Preferred aspect ratio; 8:7 PAR|4:3" },
@@ -507,8 +526,7 @@ static void check_variables(void)
          machine.SetMode(Api::Machine::NTSC);
       }
    }
-   if (audio) delete audio;
-   audio = new Api::Sound::Output(audio_buffer, is_pal ? 44100 / 50 : 44100 / 60);
+   audio_frac = 0;
 
    var.key = "nestopia_genie_distortion";
 
@@ -547,6 +565,11 @@ static void check_variables(void)
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var))
       fds_auto_insert = (strcmp(var.value, "enabled") == 0);
    
+   var.key = "nestopia_fds_fast_load";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var))
+      Api::Fds(emulator).SetFastLoad(strcmp(var.value, "enabled") == 0);
+   
    var.key = "nestopia_blargg_ntsc_filter";
 
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var))
@@ -689,6 +712,7 @@ static void check_variables(void)
    }
    
    pitch = video_width * 4;
+   ::video->pitch = pitch;
    
    renderState.filter = filter;
    renderState.width = video_width;
@@ -708,24 +732,24 @@ static void check_variables(void)
 void retro_run(void)
 {
    update_input();
+
+   // exact sample count for this frame, the APU renders stereo in place
+   const uint64_t num = is_pal ? FPS_PAL_NUM : FPS_NTSC_NUM;
+   audio_frac += uint64_t(SAMPLERATE) * (is_pal ? FPS_PAL_DEN : FPS_NTSC_DEN);
+   const unsigned frames = unsigned(audio_frac / num);
+   audio_frac %= num;
+
+   audio->length[0] = frames;
    emulator.Execute(video, audio, input);
 
    if (Api::Input(emulator).GetConnectedController(1) == 5)
       draw_crosshair(crossx, crossy);
    
-   unsigned frames = is_pal ? 44100 / 50 : 44100 / 60;
-   for (unsigned i = 0; i < frames; i++)
-      audio_stereo_buffer[(i << 1) + 0] = audio_stereo_buffer[(i << 1) + 1] = audio_buffer[i];
-   audio_batch_cb(audio_stereo_buffer, frames);
+   audio_batch_cb(audio_buffer, frames);
    
    bool updated = false;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
-   {
       check_variables();
-      delete video;
-      video = 0;
-      video = new Api::Video::Output(video_buffer, video_width * sizeof(uint32_t));
-   }
    
    // Absolute mess of inline if statements...
    video_cb(video_buffer + (overscan_v ? ((overscan_h ? 8 : 0) + (blargg_ntsc ? Api::Video::Output::NTSC_WIDTH : Api::Video::Output::WIDTH) * 8) : (overscan_h ? 8 : 0) + 0),
@@ -961,8 +985,8 @@ bool retro_load_game(const struct retro_game_info *info)
 
    Api::Sound isound(emulator);
    isound.SetSampleBits(16);
-   isound.SetSampleRate(44100);
-   isound.SetSpeaker(Api::Sound::SPEAKER_MONO);
+   isound.SetSampleRate(SAMPLERATE);
+   isound.SetSpeaker(Api::Sound::SPEAKER_STEREO);
 
    if (dbpresent)
    {
@@ -987,8 +1011,8 @@ bool retro_load_game(const struct retro_game_info *info)
    if (fds_auto_insert && machine->Is(Nes::Api::Machine::DISK))
       fds->InsertDisk(0, 0);
    
-   video = new Api::Video::Output(video_buffer, video_width * sizeof(uint32_t));
-   
+   state_size = 0;
+
    if (log_cb)
       log_cb(RETRO_LOG_INFO, "[Nestopia]: Machine is %s.\n", is_pal ? "PAL" : "NTSC");
 
@@ -1000,6 +1024,7 @@ void retro_unload_game(void)
    machine->Unload();
    sram = 0;
    sram_size = 0;
+   state_size = 0;
 }
 
 unsigned retro_get_region(void)
@@ -1012,49 +1037,157 @@ bool retro_load_game_special(unsigned, const struct retro_game_info *, size_t)
    return false;
 }
 
+// Seekable stream buffer over a fixed block of memory, used to write and
+// read states in place. The core seeks back to patch chunk lengths, so the
+// end of the output is the furthest position written.
+class state_streambuf : public std::streambuf
+{
+public:
+   state_streambuf(char *data, size_t size) : high(0)
+   {
+      setp(data, data + size);
+      setg(data, data, data + size);
+   }
+
+   size_t written()
+   {
+      update();
+      return high;
+   }
+
+protected:
+   pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+   {
+      update();
+
+      char *const base = eback();
+      const off_type size = egptr() - base;
+      const bool out = (which & std::ios_base::out) != 0;
+
+      off_type pos = off;
+
+      if (dir == std::ios_base::cur)
+         pos += out ? pptr() - pbase() : gptr() - base;
+      else if (dir == std::ios_base::end)
+         pos += out ? off_type(high) : size;
+
+      if (pos < 0 || pos > size)
+         return pos_type(off_type(-1));
+
+      if (out)
+      {
+         setp(base, base + size);
+         pbump(int(pos));
+      }
+
+      if (which & std::ios_base::in)
+         setg(base, base + pos, base + size);
+
+      return pos_type(pos);
+   }
+
+   pos_type seekpos(pos_type pos, std::ios_base::openmode which)
+   {
+      return seekoff(off_type(pos), std::ios_base::beg, which);
+   }
+
+private:
+   void update()
+   {
+      const size_t pos = pptr() - pbase();
+      if (pos > high)
+         high = pos;
+   }
+
+   size_t high;
+};
+
 size_t retro_serialize_size(void)
 {
-   std::stringstream ss;
-   if (machine->SaveState(ss, Api::Machine::NO_COMPRESSION))
-      return 0;
-   return ss.str().size();
+   // The size is measured once per game and kept, run-ahead asks for it
+   // every frame. A state can grow afterwards (disk changes, expansion
+   // devices), so the reported size leaves headroom. It is measured again
+   // if a state ever outgrows it.
+   if (!state_size)
+   {
+      if (state_scratch.empty())
+         state_scratch.resize(0x10000);
+
+      for (;;)
+      {
+         state_streambuf buf(&state_scratch[0], state_scratch.size());
+         std::ostream out(&buf);
+
+         if (NES_SUCCEEDED(machine->SaveState(out, Api::Machine::NO_COMPRESSION)))
+         {
+            state_size = buf.written() + state_headroom;
+            break;
+         }
+
+         if (out.good() || state_scratch.size() >= 0x1000000)
+            return 0;
+
+         state_scratch.resize(state_scratch.size() * 2);
+      }
+   }
+
+   return state_size;
 }
 
 bool retro_serialize(void *data, size_t size)
 {
-   std::stringstream ss;
-   if (machine->SaveState(ss, Api::Machine::NO_COMPRESSION))
-      return false;
+   state_streambuf buf(static_cast<char*>(data), size);
+   std::ostream out(&buf);
 
-   std::string state = ss.str();
-   if (state.size() > size)
+   if (NES_FAILED(machine->SaveState(out, Api::Machine::NO_COMPRESSION)))
+   {
+      state_size = 0;
       return false;
+   }
+
+   // Clear the unused headroom so equal machine states serialize to
+   // equal buffers, netplay compares them.
+   memset(static_cast<char*>(data) + buf.written(), 0, size - buf.written());
 
-   std::copy(state.begin(), state.end(), reinterpret_cast<char*>(data));
    return true;
 }
 
 bool retro_unserialize(const void *data, size_t size)
 {
-   std::stringstream ss(std::string(reinterpret_cast<const char*>(data),
-            reinterpret_cast<const char*>(data) + size));
-   return !machine->LoadState(ss);
+   state_streambuf buf(const_cast<char*>(static_cast<const char*>(data)), size);
+   std::istream in(&buf);
+
+   return NES_SUCCEEDED(machine->LoadState(in));
 }
 
 void *retro_get_memory_data(unsigned id)
 {
-   if (id != RETRO_MEMORY_SAVE_RAM)
-      return 0;
+   switch (id)
+   {
+      case RETRO_MEMORY_SAVE_RAM:
+         return sram;
+      case RETRO_MEMORY_SYSTEM_RAM:
+         return (void*)Api::Memory(emulator).GetData(Api::Memory::CPU_RAM);
+      case RETRO_MEMORY_VIDEO_RAM:
+         return (void*)Api::Memory(emulator).GetData(Api::Memory::VIDEO_RAM);
+   }
 
-   return sram;
+   return 0;
 }
 
 size_t retro_get_memory_size(unsigned id)
 {
-   if (id != RETRO_MEMORY_SAVE_RAM)
-      return 0;
+   switch (id)
+   {
+      case RETRO_MEMORY_SAVE_RAM:
+         return sram_size;
+      case RETRO_MEMORY_SYSTEM_RAM:
+         return Api::Memory(emulator).GetSize(Api::Memory::CPU_RAM);
+      case RETRO_MEMORY_VIDEO_RAM:
+         return Api::Memory(emulator).GetSize(Api::Memory::VIDEO_RAM);
+   }
 
-   return sram_size;
+   return 0;
 }
 
 void retro_cheat_reset(void)
@@ -25,6 +25,7 @@
 #include <cstring>
 #include "NstCpu.hpp"
 #include "NstState.hpp"
+#include "NstThread.hpp"
 #include "api/NstApiSound.hpp"
 #include "NstSoundRenderer.inl"
 
@@ -192,21 +193,208 @@ namespace Nes
 			}
 		};
 
+		// Synthesis of a write-only expansion chip on a worker thread. The
+		// emulation thread mixes the internal channels into 'mix' and logs
+		// every chip register write tagged with the index of the first sample
+		// it affects. The worker replays the log and renders the chip into
+		// 'ext', and both halves are summed in order when the frame ends.
+
+		struct Apu::Deferred
+		{
+			enum
+			{
+				LOG_SIZE = 0x400,
+				MARK_INTERVAL = 0x200,
+				MASK = Sound::Buffer::MASK,
+				MARK = 0xFFFF,
+				QUIT = 0xFFFE
+			};
+
+			Deferred();
+			~Deferred();
+
+			bool Start();
+			void Log(uint,uint);
+			void Wait();
+
+			static void NST_CALL Run(void*,uint);
+
+			struct Entry
+			{
+				dword index;
+				word address;
+				word data;
+			};
+
+			dword pending;
+			dword combined;
+			dword marked;
+			dword logPos;
+			dword published;
+			dword consumed;
+			Channel* channel;
+			Thread::Signal logged;
+			Thread::Signal done;
+			Thread::Task task;
+			bool running;
+			Entry log[LOG_SIZE];
+			Channel::Sample mix[Sound::Buffer::SIZE];
+			Channel::Sample ext[Sound::Buffer::SIZE];
+		};
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Apu::Deferred::Deferred()
+		:
+		pending   (0),
+		combined  (0),
+		marked    (0),
+		logPos    (0),
+		published (0),
+		consumed  (0),
+		channel   (NULL),
+		running   (false)
+		{
+		}
+
+		Apu::Deferred::~Deferred()
+		{
+			if (running)
+			{
+				Log( QUIT, 0 );
+				task.Join();
+			}
+		}
+
+		bool Apu::Deferred::Start()
+		{
+			running = task.Start( Run, this );
+			return running;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		void Apu::Deferred::Log(const uint address,const uint data)
+		{
+			while (logPos - consumed >= LOG_SIZE)
+				consumed = done.Wait( consumed );
+
+			Entry& entry = log[logPos & (LOG_SIZE-1)];
+
+			entry.index = pending;
+			entry.address = address;
+			entry.data = data;
+
+			// plain register writes are handed over in batches to keep the
+			// worker from waking up for each one of them
+
+			if (++logPos - published >= LOG_SIZE/4 || address >= QUIT)
+			{
+				published = logPos;
+				logged.Set( published );
+			}
+		}
+
+		void Apu::Deferred::Wait()
+		{
+			marked = pending;
+			Log( MARK, 0 );
+
+			while (consumed != logPos)
+				consumed = done.Wait( consumed );
+		}
+
+		void NST_CALL Apu::Deferred::Run(void* data,uint)
+		{
+			Deferred& deferred = *static_cast<Deferred*>(data);
+
+			dword rendered = 0;
+			dword read = 0;
+
+			for (;;)
+			{
+				const dword written = deferred.logged.Wait( read );
+
+				do
+				{
+					const Entry& entry = deferred.log[read++ & (LOG_SIZE-1)];
+
+					if (entry.address == QUIT)
+						return;
+
+					while (rendered != entry.index)
+					{
+						const dword offset = rendered & MASK;
+						const dword length = NST_MIN(entry.index - rendered,Sound::Buffer::SIZE - offset);
+
+						deferred.channel->Render( deferred.ext + offset, length );
+						rendered += length;
+					}
+
+					if (entry.address != MARK)
+						deferred.channel->Write( entry.address, entry.data );
+				}
+				while (read != written);
+
+				deferred.done.Set( read );
+			}
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("s", on)
 		#endif
 
 		Apu::Apu(Cpu& c)
 		:
-		cpu        (c),
-		extChannel (NULL),
-		buffer     (16)
+		updater       (&Apu::SyncOff),
+		cpu           (c),
+		extChannel    (NULL),
+		extDeferrable (false),
+		deferred      (NULL),
+		buffer        (16)
 		{
 			NST_COMPILE_ASSERT( CPU_RP2A03 == 0 && CPU_RP2A07 == 1 && CPU_DENDY == 2 );
 
 			PowerOff();
 		}
 
+		Apu::~Apu()
+		{
+			delete deferred;
+		}
+
+		Result Apu::SetExpansionThread(const bool enable)
+		{
+			if (enable == (deferred != NULL))
+				return RESULT_NOP;
+
+			if (deferred)
+			{
+				EndDeferred();
+
+				delete deferred;
+				deferred = NULL;
+			}
+			else
+			{
+				deferred = new Deferred;
+
+				if (!deferred->Start())
+				{
+					delete deferred;
+					deferred = NULL;
+
+					return RESULT_ERR_UNSUPPORTED;
+				}
+			}
+
+			return RESULT_OK;
+		}
+
 		void Apu::PowerOff()
 		{
 			Reset( false, true );
@@ -219,6 +407,8 @@ namespace Nes
 
 		void Apu::Reset(const bool on,const bool hard)
 		{
+			EndDeferred();
+
 			if (on)
 				UpdateSettings();
 
@@ -652,21 +842,28 @@ namespace Nes
 
 			if (cycles.rateCounter < target)
 			{
-				Cycle rateCounter = cycles.rateCounter;
-				const Cycle rate = cycles.rate;
-
-				do
+				if (extChannel)
+				{
+					RenderExt( target, Cpu::CYCLE_MAX );
+				}
+				else
 				{
-					buffer << GetSample();
+					Cycle rateCounter = cycles.rateCounter;
+					const Cycle rate = cycles.rate;
 
-					if (cycles.frameCounter <= rateCounter)
-						ClockFrameCounter();
+					do
+					{
+						buffer << GetSample();
 
-					rateCounter += rate;
-				}
-				while (rateCounter < target);
+						if (cycles.frameCounter <= rateCounter)
+							ClockFrameCounter();
 
-				cycles.rateCounter = rateCounter;
+						rateCounter += rate;
+					}
+					while (rateCounter < target);
+
+					cycles.rateCounter = rateCounter;
+				}
 			}
 
 			if (cycles.frameCounter < target)
@@ -676,32 +873,60 @@ namespace Nes
 			}
 		}
 
-		void NST_FASTCALL Apu::SyncOnExt(const Cycle target)
+		Cycle Apu::RenderExt(const Cycle target,Cycle extCounter)
 		{
-			NST_ASSERT( (stream && settings.audible) && (cycles.rate && cycles.fixed) && extChannel );
+			NST_ASSERT( extChannel && cycles.rateCounter < target );
 
-			Cycle extCounter = cycles.extCounter;
+			// The internal channels are mixed one sample at a time, but the
+			// expansion chip is asked for each run of samples up to its next
+			// clock event in a single call. Neither side affects the other
+			// within a sync, so the result is the same as interleaving them.
 
-			if (cycles.rateCounter < target)
+			Channel::Sample mix[Channel::RENDER_BLOCK];
+			Channel::Sample ext[Channel::RENDER_BLOCK];
+
+			Cycle rateCounter = cycles.rateCounter;
+
+			do
 			{
-				Cycle rateCounter = cycles.rateCounter;
+				Cycle sampled;
+				uint length = 0;
 
 				do
 				{
-					buffer << GetSample();
-
-					if (extCounter <= rateCounter)
-						extCounter = extChannel->Clock( extCounter, cycles.fixed, rateCounter );
+					mix[length++] = GetInternalSample();
+					sampled = rateCounter;
 
 					if (cycles.frameCounter <= rateCounter)
 						ClockFrameCounter();
 
 					rateCounter += cycles.rate;
 				}
-				while (rateCounter < target);
+				while (rateCounter < target && extCounter > sampled && length < Channel::RENDER_BLOCK);
 
-				cycles.rateCounter = rateCounter;
+				extChannel->Render( ext, length );
+
+				if (extCounter <= sampled)
+					extCounter = extChannel->Clock( extCounter, cycles.fixed, sampled );
+
+				for (uint i=0; i < length; ++i)
+					buffer << Clamp<Channel::OUTPUT_MIN,Channel::OUTPUT_MAX>(mix[i] + ext[i]);
 			}
+			while (rateCounter < target);
+
+			cycles.rateCounter = rateCounter;
+
+			return extCounter;
+		}
+
+		void NST_FASTCALL Apu::SyncOnExt(const Cycle target)
+		{
+			NST_ASSERT( (stream && settings.audible) && (cycles.rate && cycles.fixed) && extChannel );
+
+			Cycle extCounter = cycles.extCounter;
+
+			if (cycles.rateCounter < target)
+				extCounter = RenderExt( target, extCounter );
 
 			if (extCounter <= target)
 			{
@@ -720,6 +945,68 @@ namespace Nes
 			}
 		}
 
+		void NST_FASTCALL Apu::SyncOnDeferred(const Cycle target)
+		{
+			NST_ASSERT( (stream && settings.audible) && (cycles.rate && cycles.fixed) && (cycles.extCounter == Cpu::CYCLE_MAX) && deferred );
+
+			if (cycles.rateCounter < target)
+			{
+				Deferred& queue = *deferred;
+				Cycle rateCounter = cycles.rateCounter;
+				const Cycle rate = cycles.rate;
+
+				do
+				{
+					if (queue.pending - queue.combined == Sound::Buffer::SIZE)
+						CombineDeferred();
+
+					queue.mix[queue.pending++ & Deferred::MASK] = GetInternalSample();
+
+					if (cycles.frameCounter <= rateCounter)
+						ClockFrameCounter();
+
+					rateCounter += rate;
+				}
+				while (rateCounter < target);
+
+				cycles.rateCounter = rateCounter;
+
+				if (queue.pending - queue.marked >= Deferred::MARK_INTERVAL)
+				{
+					queue.marked = queue.pending;
+					queue.Log( Deferred::MARK, 0 );
+				}
+			}
+
+			if (cycles.frameCounter < target)
+			{
+				ClockFrameCounter();
+				NST_ASSERT( cycles.frameCounter >= target );
+			}
+		}
+
+		void Apu::CombineDeferred()
+		{
+			Deferred& queue = *deferred;
+
+			queue.Wait();
+
+			for (; queue.combined != queue.pending; ++queue.combined)
+			{
+				const uint i = queue.combined & Deferred::MASK;
+				buffer << Clamp<Channel::OUTPUT_MIN,Channel::OUTPUT_MAX>(queue.mix[i] + queue.ext[i]);
+			}
+		}
+
+		void Apu::EndDeferred()
+		{
+			if (updater == &Apu::SyncOnDeferred)
+			{
+				CombineDeferred();
+				updater = &Apu::SyncOn;
+			}
+		}
+
 		void NST_FASTCALL Apu::SyncOff(const Cycle target)
 		{
 			NST_ASSERT( !(stream && settings.audible) && cycles.fixed );
@@ -740,13 +1027,22 @@ namespace Nes
 
 		void Apu::BeginFrame(Sound::Output* output)
 		{
+			EndDeferred();
+
 			stream = output;
 			updater = (output && settings.audible ? (cycles.extCounter == Cpu::CYCLE_MAX ? &Apu::SyncOn : &Apu::SyncOnExt) : &Apu::SyncOff);
+
+			if (updater == &Apu::SyncOn && deferred && extChannel && extDeferrable)
+			{
+				deferred->channel = extChannel;
+				updater = &Apu::SyncOnDeferred;
+			}
 		}
 
 		inline void Apu::Update(const Cycle target)
 		{
 			NST_ASSERT( cycles.fixed );
+			NST_PROFILE_TIME( cpu.GetProfiler(), TIME_APU );
 			(*this.*updater)( target * cycles.fixed );
 		}
 
@@ -828,6 +1124,8 @@ namespace Nes
 
 		void Apu::EndFrame()
 		{
+			EndDeferred();
+
 			NST_ASSERT( (stream && settings.audible) == (updater != &Apu::SyncOff) );
 
 			if (updater != &Apu::SyncOff)
@@ -836,7 +1134,10 @@ namespace Nes
 
 				if (Sound::Output::lockCallback( *stream ))
 				{
+					NST_PROFILE_TIME( cpu.GetProfiler(), TIME_APU );
+
 					streamed = stream->length[0] + stream->length[1];
+					NST_PROFILE_COUNT( cpu.GetProfiler(), APU_SAMPLES, streamed );
 
 					if (settings.bits == 16)
 					{
@@ -896,7 +1197,7 @@ namespace Nes
 		#endif
 
 		Apu::Settings::Settings()
-		: rate(44100), bits(16), speed(0), muted(false), transpose(false), stereo(false), audible(true)
+		: rate(44100), bits(16), speed(0), muted(false), transpose(false), genie(false), stereo(false), audible(true)
 		{
 			for (uint i=0; i < MAX_CHANNELS; ++i)
 				volumes[i] = Channel::DEFAULT_VOLUME;
@@ -1164,12 +1465,14 @@ namespace Nes
 		{
 			if (apu.extChannel == this)
 			{
+				apu.EndDeferred();
 				apu.extChannel = NULL;
+				apu.extDeferrable = false;
 				apu.UpdateVolumes();
 			}
 		}
 
-		void Apu::Channel::Connect(bool audible)
+		void Apu::Channel::Connect(bool audible,bool deferrable)
 		{
 			NST_ASSERT( apu.extChannel == NULL );
 
@@ -1179,6 +1482,7 @@ namespace Nes
 				apu.UpdateVolumes();
 
 			apu.extChannel = this;
+			apu.extDeferrable = deferrable;
 		}
 
 		void Apu::Channel::GetOscillatorClock(Cycle& rate,uint& fixed) const
@@ -1226,11 +1530,37 @@ namespace Nes
 			apu.Update();
 		}
 
+		void Apu::Channel::Render(Sample* samples,uint length)
+		{
+			for (; length; --length)
+				*samples++ = GetSample();
+		}
+
 		Cycle Apu::Channel::Clock(Cycle,Cycle,Cycle)
 		{
 			return Cpu::CYCLE_MAX;
 		}
 
+		void Apu::Channel::Write(uint,uint)
+		{
+			// Only writes logged through Defer() are replayed here, and every
+			// channel that calls Defer() overrides this. Channels that write
+			// their registers directly never get here.
+		}
+
+		bool Apu::Channel::Defer(const uint address,const uint data) const
+		{
+			NST_ASSERT( address < Deferred::QUIT );
+
+			if (apu.updater == &Apu::SyncOnDeferred && apu.deferred->channel == this)
+			{
+				apu.deferred->Log( address, data );
+				return true;
+			}
+
+			return false;
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("s", on)
 		#endif
@@ -2357,17 +2687,22 @@ namespace Nes
 			cycles.frameIrqRepeat = repeat;
 		}
 
-		NST_NO_INLINE Apu::Channel::Sample Apu::GetSample()
+		inline Apu::Channel::Sample Apu::GetInternalSample()
 		{
 			dword dac[2];
 
+			return dcBlocker.Apply
+			(
+				(0 != (dac[0] = square[0].GetSample() + square[1].GetSample()) ? NLN_SQ_0 / (NLN_SQ_1 / dac[0] + NLN_SQ_2) : 0) +
+				(0 != (dac[1] = triangle.GetSample() + noise.GetSample() + dmc.GetSample()) ? NLN_TND_0 / (NLN_TND_1 / dac[1] + NLN_TND_2) : 0)
+			);
+		}
+
+		NST_NO_INLINE Apu::Channel::Sample Apu::GetSample()
+		{
 			return Clamp<Channel::OUTPUT_MIN,Channel::OUTPUT_MAX>
 			(
-				dcBlocker.Apply
-				(
-					(0 != (dac[0] = square[0].GetSample() + square[1].GetSample()) ? NLN_SQ_0 / (NLN_SQ_1 / dac[0] + NLN_SQ_2) : 0) +
-					(0 != (dac[1] = triangle.GetSample() + noise.GetSample() + dmc.GetSample()) ? NLN_TND_0 / (NLN_TND_1 / dac[1] + NLN_TND_2) : 0)
-				) + (extChannel ? extChannel->GetSample() : 0)
+				GetInternalSample() + (extChannel ? extChannel->GetSample() : 0)
 			);
 		}
 
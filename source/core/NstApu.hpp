@@ -50,6 +50,7 @@ namespace Nes
 		public:
 
 			explicit Apu(Cpu&);
+			~Apu();
 
 			void  Reset(bool);
 			void  PowerOff();
@@ -69,6 +70,7 @@ namespace Nes
 			void   SetAutoTranspose(bool);
 			void   SetGenie(bool);
 			void   EnableStereo(bool);
+			Result SetExpansionThread(bool);
 
 			void SaveState(State::Saver&,dword) const;
 			void LoadState(State::Loader&);
@@ -83,7 +85,8 @@ namespace Nes
 				~Channel();
 
 				void  Update() const;
-				void  Connect(bool);
+				void  Connect(bool,bool=false);
+				bool  Defer(uint,uint) const;
 				dword GetSampleRate() const;
 				uint  GetVolume(uint) const;
 				void  GetOscillatorClock(Cycle&,uint&) const;
@@ -118,13 +121,16 @@ namespace Nes
 					OUTPUT_MAX     = +32767,
 					OUTPUT_MUL     =  256,
 					OUTPUT_DECAY   =  OUTPUT_MUL / 4 - 1,
-					DEFAULT_VOLUME =  85
+					DEFAULT_VOLUME =  85,
+					RENDER_BLOCK   =  0x100
 				};
 
 				virtual void Reset() = 0;
 				virtual Sample GetSample() = 0;
+				virtual void Render(Sample*,uint);
 				virtual Cycle Clock(Cycle,Cycle,Cycle);
 				virtual bool UpdateSettings() = 0;
+				virtual void Write(uint,uint);
 
 				class LengthCounter
 				{
@@ -245,6 +251,8 @@ namespace Nes
 
 			typedef void (NST_FASTCALL Apu::*Updater)(Cycle);
 
+			struct Deferred;
+
 			inline void Update(Cycle);
 			void Update();
 			void UpdateLatency();
@@ -295,11 +303,18 @@ namespace Nes
 			NES_DECL_PEEK( 4015 );
 			NES_DECL_PEEK( 40xx );
 
+			inline Channel::Sample GetInternalSample();
 			NST_NO_INLINE Channel::Sample GetSample();
 
-			void NST_FASTCALL SyncOn    (Cycle);
-			void NST_FASTCALL SyncOnExt (Cycle);
-			void NST_FASTCALL SyncOff   (Cycle);
+			void NST_FASTCALL SyncOn         (Cycle);
+			void NST_FASTCALL SyncOnExt      (Cycle);
+			void NST_FASTCALL SyncOnDeferred (Cycle);
+			void NST_FASTCALL SyncOff        (Cycle);
+
+			NST_NO_INLINE Cycle RenderExt(Cycle,Cycle);
+
+			NST_NO_INLINE void CombineDeferred();
+			void EndDeferred();
 
 			NST_NO_INLINE void ClockFrameIRQ(Cycle);
 			NST_NO_INLINE void ClockFrameCounter();
@@ -617,6 +632,8 @@ namespace Nes
 			Noise noise;
 			Dmc dmc;
 			Channel* extChannel;
+			bool extDeferrable;
+			Deferred* deferred;
 			Channel::DcBlocker dcBlocker;
 			Sound::Output* stream;
 			Sound::Buffer buffer;
@@ -663,6 +680,11 @@ namespace Nes
 			{
 				return settings.audible && !settings.muted;
 			}
+
+			bool IsExpansionThreaded() const
+			{
+				return deferred != NULL;
+			}
 		};
 	}
 }
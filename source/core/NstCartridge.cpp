@@ -217,6 +217,11 @@ namespace Nes
 			}
 		}
 
+		const byte* Cartridge::GetWram(dword& size) const
+		{
+			return board->GetWram( size );
+		}
+
 		Result Cartridge::SetupBoard
 		(
 			Ram& prg,
@@ -496,5 +501,21 @@ namespace Nes
 			if (vs)
 				vs->VSync();
 		}
+
+		void Cartridge::Journal()
+		{
+			savefile.SetJournaling( true );
+
+			try
+			{
+				board->Save( savefile );
+			}
+			catch (...)
+			{
+				Log::Flush( "Cartridge: warning, save data journaling failed!" NST_LINEBREAK );
+			}
+
+			savefile.SetJournaling( false );
+		}
 	}
 }
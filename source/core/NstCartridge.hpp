@@ -105,6 +105,7 @@ namespace Nes
 			void SaveState(State::Saver&,dword) const;
 			void Destroy();
 			void VSync();
+			void Journal();
 
 			uint GetDesiredController(uint) const;
 			uint GetDesiredAdapter() const;
@@ -113,6 +114,7 @@ namespace Nes
 			System GetDesiredSystem(Region,CpuModel*,PpuModel*) const;
 
 			ExternalDevice QueryExternalDevice(ExternalDeviceType);
+			const byte* GetWram(dword&) const;
 
 			Boards::Board* board;
 			VsSystem* vs;
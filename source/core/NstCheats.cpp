@@ -22,7 +22,6 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
-#include <algorithm>
 #include "NstCpu.hpp"
 #include "NstCheats.hpp"
 
@@ -71,42 +70,64 @@ namespace Nes
 						else
 						{
 							*it = code;
+							CompileRamCodes();
 							return RESULT_WARN_DATA_REPLACED;
 						}
 					}
 				}
+
+				CompileRamCodes();
 			}
 			else
 			{
-				const HiCode code = {address,data,compare,useCompare,NULL};
-
-				HiCode* it = hiCodes.Begin();
+				HiCode** it = hiCodes.Begin();
 
-				for (const HiCode* const end=hiCodes.End(); ; ++it)
+				for (HiCode* const* const end=hiCodes.End(); ; ++it)
 				{
-					if (it == end || it->address > address)
-					{
-						it = hiCodes.Insert( it, code );
-						break;
-					}
-					else if (it->address == address)
+					if (it == end || (*it)->address > address)
 					{
-						if (it->data == code.data && it->useCompare == code.useCompare && (!code.useCompare || it->compare == code.compare))
+						HiCode* const code = new HiCode;
+
+						code->address = address;
+						code->data = data;
+						code->compare = compare;
+						code->useCompare = useCompare;
+						code->port = NULL;
+
+						try
 						{
-							return RESULT_NOP;
+							it = hiCodes.Insert( it, code );
 						}
-						else
+						catch (...)
 						{
-							it->data = code.data;
-							it->compare = code.compare;
-							it->useCompare = code.useCompare;
-							return RESULT_WARN_DATA_REPLACED;
+							delete code;
+							throw;
 						}
+
+						break;
+					}
+					else if ((*it)->address == address)
+					{
+						HiCode& code = **it;
+
+						if (code.data == data && code.useCompare == useCompare && (!useCompare || code.compare == compare))
+							return RESULT_NOP;
+
+						Unmap( code );
+
+						code.data = data;
+						code.compare = compare;
+						code.useCompare = useCompare;
+
+						if (activate)
+							Map( code );
+
+						return RESULT_WARN_DATA_REPLACED;
 					}
 				}
 
 				if (activate)
-					Map( *it );
+					Map( **it );
 			}
 
 			return RESULT_OK;
@@ -117,12 +138,14 @@ namespace Nes
 			if (loCodes.Size() > index)
 			{
 				loCodes.Erase( loCodes.Begin() + index );
+				CompileRamCodes();
 				return RESULT_OK;
 			}
 			else if (hiCodes.Size() > (index -= loCodes.Size()))
 			{
-				HiCode* const it = hiCodes.Begin() + index;
-				cpu.Unlink( it->address, this, &Cheats::Peek_Wizard, &Cheats::Poke_Wizard );
+				HiCode** const it = hiCodes.Begin() + index;
+				Unmap( **it );
+				delete *it;
 				hiCodes.Erase( it );
 				return RESULT_OK;
 			}
@@ -135,23 +158,55 @@ namespace Nes
 		void Cheats::Reset()
 		{
 			loCodes.Defrag();
+			ramCodes.Defrag();
 			hiCodes.Defrag();
 
-			for (HiCode *it=hiCodes.Begin(), *const end=hiCodes.End(); it != end; ++it)
-				Map( *it );
+			for (HiCode** it=hiCodes.Begin(), *const *const end=hiCodes.End(); it != end; ++it)
+				Map( **it );
 		}
 
 		void Cheats::Map(HiCode& code)
 		{
-			code.port = cpu.Link( code.address, Cpu::LEVEL_HIGH, this, &Cheats::Peek_Wizard, &Cheats::Poke_Wizard );
+			if (frameLocked)
+				code.port = cpu.Link( code.address, Cpu::LEVEL_HIGH, &code, &HiCode::Peek_Locked, &HiCode::Poke_Port );
+			else if (code.useCompare)
+				code.port = cpu.Link( code.address, Cpu::LEVEL_HIGH, &code, &HiCode::Peek_Compare, &HiCode::Poke_Port );
+			else
+				code.port = cpu.Link( code.address, Cpu::LEVEL_HIGH, &code, &HiCode::Peek_Data, &HiCode::Poke_Port );
+		}
+
+		void Cheats::Unmap(HiCode& code)
+		{
+			cpu.Unlink( code.address, &code, &HiCode::Peek_Data, &HiCode::Poke_Port );
+			cpu.Unlink( code.address, &code, &HiCode::Peek_Compare, &HiCode::Poke_Port );
+			cpu.Unlink( code.address, &code, &HiCode::Peek_Locked, &HiCode::Poke_Port );
+		}
+
+		void Cheats::CompileRamCodes()
+		{
+			ramCodes.Resize( loCodes.Size() );
+
+			RamCode* NST_RESTRICT dst = ramCodes.Begin();
+
+			for (const LoCode* NST_RESTRICT it=loCodes.Begin(), *const end=loCodes.End(); it != end; ++it, ++dst)
+			{
+				dst->offset = it->address & (Cpu::RAM_SIZE-1);
+				dst->data = it->data;
+				dst->compare = it->useCompare ? it->compare : 0x00;
+				dst->mask = it->useCompare ? 0xFF : 0x00;
+			}
 		}
 
 		void Cheats::ClearCodes()
 		{
 			loCodes.Destroy();
+			ramCodes.Destroy();
 
-			for (const HiCode *it=hiCodes.Begin(), *const end=hiCodes.End(); it != end; ++it)
-				cpu.Unlink( it->address, this, &Cheats::Peek_Wizard, &Cheats::Poke_Wizard );
+			for (HiCode** it=hiCodes.Begin(), *const *const end=hiCodes.End(); it != end; ++it)
+			{
+				Unmap( **it );
+				delete *it;
+			}
 
 			hiCodes.Destroy();
 		}
@@ -183,7 +238,7 @@ namespace Nes
 			}
 			else if (hiCodes.Size() > (index -= loCodes.Size()))
 			{
-				const HiCode* NST_RESTRICT code = hiCodes.Begin() + index;
+				const HiCode* NST_RESTRICT code = hiCodes[index];
 
 				if (address)
 					*address = code->address;
@@ -211,64 +266,51 @@ namespace Nes
 
 		void Cheats::BeginFrame(bool frameLock)
 		{
-			frameLocked = frameLock;
+			if (bool(frameLocked) != frameLock)
+			{
+				for (HiCode** it=hiCodes.Begin(), *const *const end=hiCodes.End(); it != end; ++it)
+					Unmap( **it );
+
+				frameLocked = frameLock;
+
+				for (HiCode** it=hiCodes.Begin(), *const *const end=hiCodes.End(); it != end; ++it)
+					Map( **it );
+			}
 
 			if (!frameLock)
 			{
-				for (const LoCode* NST_RESTRICT it=loCodes.Begin(), *const end=loCodes.End(); it != end; ++it)
-				{
-					const uint address = it->address & (Cpu::RAM_SIZE-1);
+				byte* const NST_RESTRICT ram = cpu.GetRam();
 
-					if (!it->useCompare || cpu.GetRam()[address] == it->compare)
-						cpu.GetRam()[address] = it->data;
+				for (const RamCode* NST_RESTRICT it=ramCodes.Begin(), *const end=ramCodes.End(); it != end; ++it)
+				{
+					if ((ram[it->offset] & it->mask) == it->compare)
+					{
+						ram[it->offset] = it->data;
+						cpu.CountWrite( 0x0000 );
+					}
 				}
 			}
 		}
 
-		inline bool Cheats::HiCode::operator < (const Cheats::HiCode& c) const
+		NES_PEEK(Cheats::HiCode,Data)
 		{
-			return address < c.address;
+			return data;
 		}
 
-		inline bool Cheats::HiCode::operator < (Address a) const
+		NES_PEEK_A(Cheats::HiCode,Compare)
 		{
-			return address < a;
+			const uint value = port->Peek( address );
+			return value == compare ? data : value;
 		}
 
-		inline bool operator < (Address a,const Cheats::HiCode& c)
+		NES_PEEK_A(Cheats::HiCode,Locked)
 		{
-			return a < c.address;
+			return port->Peek( address );
 		}
 
-		NES_PEEK_A(Cheats,Wizard)
+		NES_POKE_AD(Cheats::HiCode,Port)
 		{
-			NST_ASSERT( address >= 0x2000 );
-
-			const HiCode* const NST_RESTRICT code = std::lower_bound( hiCodes.Begin(), hiCodes.End(), address );
-
-			if (!frameLocked)
-			{
-				if (code->useCompare)
-				{
-					const uint data = code->port->Peek( address );
-
-					if (code->compare != data)
-						return data;
-				}
-
-				return code->data;
-			}
-			else
-			{
-				return code->port->Peek( address );
-			}
-		}
-
-		NES_POKE_AD(Cheats,Wizard)
-		{
-			NST_ASSERT( address >= 0x2000 );
-
-			return std::lower_bound( hiCodes.Begin(), hiCodes.End(), address )->port->Poke( address, data );
+			port->Poke( address, data );
 		}
 	}
 }
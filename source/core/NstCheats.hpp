@@ -54,9 +54,6 @@ namespace Nes
 
 		private:
 
-			NES_DECL_PEEK( Wizard );
-			NES_DECL_POKE( Wizard );
-
 			struct LoCode
 			{
 				word address;
@@ -65,10 +62,22 @@ namespace Nes
 				ibool useCompare;
 			};
 
-			struct HiCode
+			struct RamCode
+			{
+				word offset;
+				byte data;
+				byte compare;
+				byte mask;
+			};
+
+			class HiCode
 			{
-				inline bool operator < (const HiCode&) const;
-				inline bool operator < (Address) const;
+			public:
+
+				NES_DECL_PEEK( Data );
+				NES_DECL_PEEK( Compare );
+				NES_DECL_PEEK( Locked );
+				NES_DECL_POKE( Port );
 
 				word address;
 				byte data;
@@ -77,16 +86,18 @@ namespace Nes
 				const Io::Port* port;
 			};
 
-			inline friend bool operator < (Address,const HiCode&);
-
 			typedef Vector<LoCode> LoCodes;
-			typedef Vector<HiCode> HiCodes;
+			typedef Vector<RamCode> RamCodes;
+			typedef Vector<HiCode*> HiCodes;
 
 			void Map(HiCode&);
+			void Unmap(HiCode&);
+			void CompileRamCodes();
 
 			Cpu& cpu;
 			ibool frameLocked;
 			LoCodes loCodes;
+			RamCodes ramCodes;
 			HiCodes hiCodes;
 
 		public:
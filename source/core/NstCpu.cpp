@@ -33,8 +33,6 @@ namespace Nes
 {
 	namespace Core
 	{
-		dword Cpu::logged = 0;
-
 		void (Cpu::*const Cpu::opcodes[0x100])() =
 		{
 			&Cpu::op0x00, &Cpu::op0x01, &Cpu::op0x02, &Cpu::op0x03,
@@ -154,6 +152,7 @@ namespace Nes
 		apu   ( *this ),
 		map   ( this, &Cpu::Peek_Overflow, &Cpu::Poke_Overflow )
 		{
+			fetch.direct = false;
 			cycles.UpdateTable( GetModel() );
 			Reset( false, false );
 		}
@@ -172,6 +171,40 @@ namespace Nes
 			ram.powerstate = powerstate;
 		}
 
+		void Cpu::SetDirectFetch(bool direct)
+		{
+			fetch.direct = direct;
+
+			if (!direct)
+				fetch.Reset();
+		}
+
+		bool Cpu::GetDirectFetch() const
+		{
+			return fetch.direct;
+		}
+
+		void Cpu::SetFetchBank(const Address address,const byte* const* bank,const Io::Port& port)
+		{
+			NST_ASSERT( address >= 0x8000 && address <= 0xFFFF && !(address & (SIZE_8K-1)) );
+
+			const uint index = address >> Fetch::BANK_SHIFT;
+			fetch.banks[index] = NULL;
+
+			if (fetch.direct)
+			{
+				// only plain reads of the bank may bypass the map
+
+				for (uint i=address, n=address+SIZE_8K; i < n; ++i)
+				{
+					if (!map[i].SameReader( port ))
+						return;
+				}
+
+				fetch.banks[index] = bank;
+			}
+		}
+
 		void Cpu::Reset(bool hard)
 		{
 			Reset( true, hard );
@@ -182,6 +215,7 @@ namespace Nes
 			if (!on || hard)
 			{
 				ram.Reset( GetModel() );
+				++map.writes[0];
 
 				a = 0x00;
 				x = 0x00;
@@ -212,9 +246,13 @@ namespace Nes
 			cycles.frame  = (model == CPU_RP2A03 ? PPU_RP2C02_HVSYNC : model == CPU_RP2A07 ? PPU_RP2C07_HVSYNC : PPU_DENDY_HVSYNC);
 
 			interrupt.Reset();
+			fetch.Reset();
 			hooks.Clear();
 			linker.Clear();
 
+			event.hook.Unset();
+			event.clock = CYCLE_MAX;
+
 			if (on)
 			{
 				map( 0x0000, 0x07FF ).Set( &ram, &Ram::Peek_Ram_0, &Ram::Poke_Ram_0 );
@@ -270,6 +308,12 @@ namespace Nes
 			hooks.Remove( hook );
 		}
 
+		void Cpu::SetEvent(const Hook& hook)
+		{
+			event.hook = hook;
+			event.clock = CYCLE_MAX;
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
@@ -350,7 +394,7 @@ namespace Nes
 				state.Begin( AsciiId<'R','E','G'>::V ).Write( data ).End();
 			}
 
-			state.Begin( AsciiId<'R','A','M'>::V ).Compress( ram.mem ).End();
+			state.Begin( AsciiId<'R','A','M'>::V ).Compress( ram.mem, RAM_SIZE, GetWriteCount(0x0000) + GetWriteCount(0x10000) ).End();
 
 			{
 				const byte data[5] =
@@ -405,6 +449,7 @@ namespace Nes
 						case AsciiId<'R','A','M'>::V:
 
 							state.Uncompress( ram.mem );
+							++map.writes[0];
 							break;
 
 						case AsciiId<'F','R','M'>::V:
@@ -741,9 +786,23 @@ namespace Nes
 			low = 0;
 		}
 
+		void Cpu::Fetch::Reset()
+		{
+			for (uint i=0; i < NUM_BANKS; ++i)
+				banks[i] = NULL;
+		}
+
 		template<typename T,typename U>
 		Cpu::IoMap::IoMap(Cpu* cpu,T peek,U poke)
-		: Io::Map<SIZE_64K>( cpu, peek, poke ) {}
+		:
+		Io::Map<SIZE_64K>( cpu, peek, poke )
+	#ifdef NST_PROFILER
+		,profiler( cpu->profiler )
+	#endif
+		{
+			for (uint i=0; i < NUM_WRITE_BANKS; ++i)
+				writes[i] = 0;
+		}
 
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
@@ -752,18 +811,22 @@ namespace Nes
 		inline uint Cpu::IoMap::Peek8(const uint address) const
 		{
 			NST_ASSERT( address < FULL_SIZE );
+			NST_PROFILE_COUNT( profiler, MAPPER_READS, address >= 0x4020 );
 			return ports[address].Peek( address );
 		}
 
 		inline uint Cpu::IoMap::Peek16(const uint address) const
 		{
 			NST_ASSERT( address < FULL_SIZE-1 );
+			NST_PROFILE_COUNT( profiler, MAPPER_READS, address >= 0x4020 ? 2 : 0 );
 			return ports[address].Peek( address ) | ports[address + 1].Peek( address + 1 ) << 8;
 		}
 
 		inline void Cpu::IoMap::Poke8(const uint address,const uint data) const
 		{
 			NST_ASSERT( address < FULL_SIZE );
+			NST_PROFILE_COUNT( profiler, MAPPER_WRITES, address >= 0x4020 );
+			++writes[address >> WRITE_BANK_SHIFT];
 			ports[address].Poke( address, data );
 		}
 
@@ -833,14 +896,23 @@ namespace Nes
 
 		inline uint Cpu::FetchPc8()
 		{
-			const uint data = map.Peek8( pc );
+			const byte* const* const bank = fetch.banks[pc >> Fetch::BANK_SHIFT];
+			const uint data = bank ? (*bank)[pc & (SIZE_8K-1)] : map.Peek8( pc );
 			++pc;
 			return data;
 		}
 
 		inline uint Cpu::FetchPc16()
 		{
-			const uint data = map.Peek16( pc );
+			const byte* const* const bank = fetch.banks[pc >> Fetch::BANK_SHIFT];
+			const uint offset = pc & (SIZE_8K-1);
+
+			const uint data =
+			(
+				bank && offset != SIZE_8K-1 ? (*bank)[offset] | uint((*bank)[offset+1]) << 8 :
+				map.Peek16( pc )
+			);
+
 			pc += 2;
 			return data;
 		}
@@ -1147,6 +1219,7 @@ namespace Nes
 		inline void Cpu::StoreZpg(const uint address,const uint data)
 		{
 			ram.mem[address] = data;
+			++map.writes[0];
 		}
 
 		////////////////////////////////////////////////////////////////////////////////////////
@@ -1161,6 +1234,7 @@ namespace Nes
 			sp = (sp - 1) & 0xFF;
 
 			ram.mem[0x100+p] = data;
+			++map.writes[0];
 		}
 
 		NST_FORCE_INLINE void Cpu::Push16(const uint data)
@@ -1173,6 +1247,7 @@ namespace Nes
 
 			ram.mem[0x100+p1] = data & 0xFF;
 			ram.mem[0x100+p0] = data >> 8;
+			++map.writes[0];
 		}
 
 		inline uint Cpu::Pull8()
@@ -1874,6 +1949,8 @@ namespace Nes
 
 			Clock();
 
+			NST_PROFILE_TIME( profiler, TIME_CPU );
+
 			switch (hooks.Size())
 			{
 				case 0:  Run0(); break;
@@ -1889,6 +1966,12 @@ namespace Nes
 			for (const Hook *hook = hooks.Ptr(), *const end = hook+hooks.Size(); hook != end; ++hook)
 				hook->Execute();
 
+			if (event.clock <= cycles.count)
+				ExecuteEvent();
+
+			if (event.clock != CYCLE_MAX)
+				event.clock = (event.clock > cycles.frame ? event.clock - cycles.frame : 0);
+
 			NST_ASSERT( cycles.count >= cycles.frame && interrupt.nmiClock >= cycles.frame );
 
 			cycles.count -= cycles.frame;
@@ -1901,13 +1984,27 @@ namespace Nes
 				interrupt.irqClock = (interrupt.irqClock > cycles.frame ? interrupt.irqClock - cycles.frame : 0);
 		}
 
+		void Cpu::ExecuteEvent()
+		{
+			// the hook reschedules itself if needed
+
+			event.clock = CYCLE_MAX;
+			event.hook.Execute();
+		}
+
 		void Cpu::Clock()
 		{
+			if (event.clock <= cycles.count)
+				ExecuteEvent();
+
 			Cycle clock = apu.Clock();
 
 			if (clock > cycles.frame)
 				clock = cycles.frame;
 
+			if (clock > event.clock)
+				clock = event.clock;
+
 			if (cycles.count < interrupt.nmiClock)
 			{
 				if (clock > interrupt.nmiClock)
@@ -1940,6 +2037,7 @@ namespace Nes
 
 		inline void Cpu::ExecuteOp()
 		{
+			NST_PROFILE_COUNT( profiler, CPU_INSTRUCTIONS, 1 );
 			cycles.offset = cycles.count;
 			(*this.*opcodes[opcode=FetchPc8()])();
 		}
@@ -1969,6 +2067,7 @@ namespace Nes
 				{
 					ExecuteOp();
 					hook.Execute();
+					NST_PROFILE_COUNT( profiler, CPU_HOOKS, 1 );
 				}
 				while (cycles.count < cycles.round);
 
@@ -1997,6 +2096,8 @@ namespace Nes
 						(++hook)->Execute();
 					}
 					while (hook != last);
+
+					NST_PROFILE_COUNT( profiler, CPU_HOOKS, hooks.Size() );
 				}
 				while (cycles.count < cycles.round);
 
@@ -26,8 +26,10 @@
 #define NST_CPU_H
 
 #include "NstAssert.hpp"
+#include "NstHook.hpp"
 #include "NstIoMap.hpp"
 #include "NstApu.hpp"
+#include "NstProfiler.hpp"
 
 #ifdef NST_PRAGMA_ONCE
 #pragma once
@@ -37,8 +39,6 @@ namespace Nes
 {
 	namespace Core
 	{
-		class Hook;
-
 		class Cpu
 		{
 		public:
@@ -67,6 +67,9 @@ namespace Nes
 
 			void Reset(bool);
 			void SetRamPowerState(uint);
+			void SetDirectFetch(bool);
+			bool GetDirectFetch() const;
+			void SetFetchBank(Address,const byte* const*,const Io::Port&);
 			void Boot(bool);
 			void ExecuteFrame(Sound::Output*);
 			void EndFrame();
@@ -89,13 +92,14 @@ namespace Nes
 			void SetModel(CpuModel);
 			void AddHook(const Hook&);
 			void RemoveHook(const Hook&);
+			void SetEvent(const Hook&);
 
 			void SaveState(State::Saver&,dword,dword) const;
 			void LoadState(State::Loader&,dword,dword,dword);
 
 		private:
 
-			static void NotifyOp(const char (&)[4],dword);
+			void NotifyOp(const char (&)[4],dword);
 
 			enum
 			{
@@ -128,6 +132,7 @@ namespace Nes
 			void DoISR(uint);
 			uint FetchIRQISRVector();
 			void Clock();
+			void ExecuteEvent();
 
 			void Run0();
 			void Run1();
@@ -417,6 +422,12 @@ namespace Nes
 				word capacity;
 			};
 
+			struct Event
+			{
+				Hook hook;
+				Cycle clock;
+			};
+
 			struct Ram
 			{
 				typedef byte (&Ref)[RAM_SIZE];
@@ -445,6 +456,38 @@ namespace Nes
 				inline uint Peek8(uint) const;
 				inline uint Peek16(uint) const;
 				inline void Poke8(uint,uint) const;
+
+				enum
+				{
+					WRITE_BANK_SHIFT = 13,
+					NUM_WRITE_BANKS = (FULL_SIZE + SIZE_8K - 1) / SIZE_8K
+				};
+
+				mutable dword writes[NUM_WRITE_BANKS];
+
+			#ifdef NST_PROFILER
+				Profiler& profiler;
+			#endif
+			};
+
+			struct Fetch
+			{
+				enum
+				{
+					BANK_SHIFT = 13,
+					NUM_BANKS = (IoMap::FULL_SIZE + SIZE_8K - 1) / SIZE_8K
+				};
+
+				void Reset();
+
+				void Unmap(uint first,uint last)
+				{
+					for (first >>= BANK_SHIFT, last >>= BANK_SHIFT; first <= last; ++first)
+						banks[first] = NULL;
+				}
+
+				const byte* const* banks[NUM_BANKS];
+				bool direct;
 			};
 
 			class Linker
@@ -479,6 +522,7 @@ namespace Nes
 			Flags flags;
 			Interrupt interrupt;
 			Hooks hooks;
+			Event event;
 			uint opcode;
 			word jammed;
 			word model;
@@ -486,9 +530,13 @@ namespace Nes
 			qaword ticks;
 			Ram ram;
 			Apu apu;
+		#ifdef NST_PROFILER
+			Profiler profiler;
+		#endif
 			IoMap map;
+			Fetch fetch;
 
-			static dword logged;
+			dword logged;
 			static void (Cpu::*const opcodes[0x100])();
 			static const byte writeClocks[0x100];
 
@@ -499,6 +547,13 @@ namespace Nes
 				return apu;
 			}
 
+		#ifdef NST_PROFILER
+			Profiler& GetProfiler()
+			{
+				return profiler;
+			}
+		#endif
+
 			Cycle Update(uint readAddress=0)
 			{
 				apu.ClockDMA( readAddress );
@@ -546,6 +601,11 @@ namespace Nes
 				return cycles.count;
 			}
 
+			uint GetPc() const
+			{
+				return pc;
+			}
+
 			void StealCycles(Cycle count)
 			{
 				cycles.count += count;
@@ -562,6 +622,14 @@ namespace Nes
 				cycles.NextRound( count );
 			}
 
+			void ScheduleEvent(Cycle clock)
+			{
+				NST_ASSERT( event.hook || clock == CYCLE_MAX );
+
+				event.clock = clock;
+				cycles.NextRound( clock );
+			}
+
 			Ram::Ref GetRam()
 			{
 				return ram.mem;
@@ -572,25 +640,39 @@ namespace Nes
 				return ram.mem;
 			}
 
+			dword GetWriteCount(Address address) const
+			{
+				return map.writes[address >> IoMap::WRITE_BANK_SHIFT];
+			}
+
+			void CountWrite(Address address)
+			{
+				++map.writes[address >> IoMap::WRITE_BANK_SHIFT];
+			}
+
 			Io::Port& Map(Address address)
 			{
+				fetch.Unmap( address, address );
 				return map( address );
 			}
 
 			IoMap::Section Map(Address first,Address last)
 			{
+				fetch.Unmap( first, last );
 				return map( first, last );
 			}
 
 			template<typename T,typename U,typename V>
 			const Io::Port* Link(Address address,Level level,T t,U u,V v)
 			{
+				fetch.Unmap( address, address );
 				return linker.Add( address, level, Io::Port(t,u,v), map );
 			}
 
 			template<typename T,typename U,typename V>
 			void Unlink(Address address,T t,U u,V v)
 			{
+				fetch.Unmap( address, address );
 				linker.Remove( address, Io::Port(t,u,v), map );
 			}
 		};
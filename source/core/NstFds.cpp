@@ -162,12 +162,13 @@ namespace Nes
 
 		Fds::Fds(Context& context)
 		:
-		Image   (DISK),
-		disks   (context.stream),
-		adapter (context.cpu,disks.sides),
-		cpu     (context.cpu),
-		ppu     (context.ppu),
-		sound   (context.apu)
+		Image    (DISK),
+		disks    (context.stream),
+		adapter  (context.cpu,disks.sides),
+		cpu      (context.cpu),
+		ppu      (context.ppu),
+		sound    (context.apu),
+		fastLoad (false)
 		{
 			if (!bios.Available())
 				throw RESULT_ERR_MISSING_BIOS;
@@ -186,6 +187,12 @@ namespace Nes
 				disks.sides.Save();
 		}
 
+		void Fds::Journal()
+		{
+			if (!disks.writeProtected)
+				disks.sides.Journal();
+		}
+
 		void Fds::Reset(const bool hard)
 		{
 			disks.mounting = 0;
@@ -238,6 +245,12 @@ namespace Nes
 			return true;
 		}
 
+		const byte* Fds::GetWram(dword& size) const
+		{
+			size = SIZE_32K;
+			return ram.mem;
+		}
+
 		void Fds::SetBios(std::istream* stream)
 		{
 			bios.Set( stream );
@@ -253,6 +266,16 @@ namespace Nes
 			return bios.Available();
 		}
 
+		void Fds::SetFastLoad(bool enable)
+		{
+			fastLoad = enable;
+		}
+
+		bool Fds::IsFastLoad() const
+		{
+			return fastLoad;
+		}
+
 		Region Fds::GetDesiredRegion() const
 		{
 			return REGION_NTSC;
@@ -364,6 +387,7 @@ namespace Nes
 
 						io.ctrl = data[0];
 						io.port = data[1];
+						fastLoad = data[2] & 0x1U;
 						break;
 					}
 
@@ -461,7 +485,7 @@ namespace Nes
 				{
 					io.ctrl,
 					io.port,
-					0,
+					fastLoad ? 0x1U : 0x0U,
 					0
 				};
 
@@ -698,6 +722,23 @@ namespace Nes
 			}
 		}
 
+		void Fds::Disks::Sides::Journal() const
+		{
+			file.SetJournaling( true );
+
+			try
+			{
+				const uint header = HasHeader() ? HEADER_SIZE : 0;
+				file.Save( File::DISK, data - header, header + count * dword(SIDE_SIZE) );
+			}
+			catch (...)
+			{
+				Log::Flush( "Fds: warning, disk journaling failed!" NST_LINEBREAK );
+			}
+
+			file.SetJournaling( false );
+		}
+
 		Fds::Disks::Disks(std::istream& stream)
 		:
 		sides          (stream),
@@ -810,6 +851,7 @@ namespace Nes
 			length = 0;
 			in = 0;
 			out = 0;
+			fast = 0;
 			status = STATUS_EJECTED|STATUS_UNREADY|STATUS_PROTECTED|OPEN_BUS;
 		}
 
@@ -953,7 +995,7 @@ namespace Nes
 		#pragma optimize("", on)
 		#endif
 
-		NST_SINGLE_CALL void Fds::Unit::Drive::Write(uint reg)
+		NST_SINGLE_CALL void Fds::Unit::Drive::Write(uint reg,bool accelerate)
 		{
 			ctrl = reg;
 
@@ -964,11 +1006,27 @@ namespace Nes
 			}
 			else if (!(reg & CTRL_STOP | count) && io)
 			{
-				count = CLK_MOTOR;
+				// Fast-load is decided once per motor start so that the
+				// mirroring writes a game does on its own won't affect
+				// a transfer already in progress.
+
+				fast = accelerate ? FAST_ON : 0;
+				count = fast ? CLK_FAST : CLK_MOTOR;
 				headPos = 0;
 			}
 		}
 
+		inline void Fds::Unit::Drive::Acknowledge()
+		{
+			if (fast & uint(FAST_PENDING))
+			{
+				fast = FAST_ON;
+
+				if (count > CLK_FAST)
+					count = CLK_FAST;
+			}
+		}
+
 		ibool Fds::Unit::Drive::Advance(uint& timer)
 		{
 			NST_ASSERT( io && !count );
@@ -994,6 +1052,7 @@ namespace Nes
 							// removes the CRC value at the end of each block.
 							// No choice but to fall back on the BIOS.
 
+							fast = 0;
 							in = *stream | 0x100U;
 
 							if (ctrl & uint(CTRL_CRC))
@@ -1071,7 +1130,12 @@ namespace Nes
 						}
 
 						if (ctrl & uint(CTRL_IO_MODE))
+						{
+							if (fast)
+								count = CLK_FAST;
+
 							return false;
+						}
 
 						NST_VERIFY( !(ctrl & uint(CTRL_GEN_IRQ)) );
 
@@ -1141,11 +1205,15 @@ namespace Nes
 
 				uint irq = ctrl & uint(CTRL_GEN_IRQ);
 				timer |= irq >> 6;
+
+				if (irq && fast)
+					fast = FAST_ON|FAST_PENDING;
+
 				return irq;
 			}
 			else if (headPos)
 			{
-				count = CLK_REWIND;
+				count = fast ? CLK_FAST : CLK_REWIND;
 				headPos = 0;
 				status |= uint(STATUS_UNREADY);
 			}
@@ -1256,7 +1324,7 @@ namespace Nes
 					unit.drive.count >> 0 & 0xFF,
 					unit.drive.count >> 8 & 0xFF,
 					unit.drive.count >> 16,
-					unit.drive.in >> 8
+					unit.drive.in >> 8 | unit.drive.fast << 1
 				};
 
 				state.Begin( AsciiId<'D','R','V'>::V ).Write( data ).End();
@@ -1292,6 +1360,7 @@ namespace Nes
 					unit.drive.gap = data[8] | data[9] << 8;
 					unit.drive.length = data[10] | data[11] << 8;
 					unit.drive.count = data[12] | data[13] << 8 | dword(data[14]) << 16;
+					unit.drive.fast = data[15] >> 1 & (Unit::Drive::FAST_ON|Unit::Drive::FAST_PENDING);
 
 					if (unit.drive.dataPos > SIDE_SIZE)
 						unit.drive.dataPos = SIDE_SIZE;
@@ -1319,7 +1388,7 @@ namespace Nes
 			unit.drive.status |= uint(Unit::Drive::STATUS_PROTECTED);
 		}
 
-		NST_SINGLE_CALL void Fds::Adapter::Write(uint reg)
+		NST_SINGLE_CALL void Fds::Adapter::Write(uint reg,bool fast)
 		{
 			Update();
 
@@ -1328,13 +1397,14 @@ namespace Nes
 			if (!unit.status)
 				ClearIRQ();
 
-			unit.drive.Write( reg );
+			unit.drive.Write( reg, fast );
 		}
 
 		NST_SINGLE_CALL uint Fds::Adapter::Read()
 		{
 			Update();
 
+			unit.drive.Acknowledge();
 			unit.status &= Unit::STATUS_PENDING_IRQ;
 
 			if (!unit.status)
@@ -1381,6 +1451,7 @@ namespace Nes
 			Update();
 
 			unit.drive.out = data;
+			unit.drive.Acknowledge();
 			unit.status &= Unit::STATUS_PENDING_IRQ;
 
 			if (!unit.status)
@@ -1464,7 +1535,7 @@ namespace Nes
 
 		NES_POKE_D(Fds,4025)
 		{
-			adapter.Write( data );
+			adapter.Write( data, fastLoad && cpu.GetPc() >= BIOS_ADDRESS );
 			ppu.SetMirroring( (data & CTRL1_NMT_HORIZONTAL) ? Ppu::NMT_H : Ppu::NMT_V );
 		}
 
@@ -1986,13 +2057,13 @@ namespace Nes
 			return rateCycles;
 		}
 
-		NST_SINGLE_CALL dword Fds::Sound::GetModulation() const
+		NST_SINGLE_CALL dword Fds::Sound::GetModulation(const uint sweep) const
 		{
 			if (dword pos = envelopes.units[SWEEP].Gain())
 			{
-				pos = (pos * (((modulator.sweep & REG5_MOD_SWEEP) - (modulator.sweep & REG5_MOD_NEGATE)))) & 0xFFF;
+				pos = (pos * (((sweep & REG5_MOD_SWEEP) - (sweep & REG5_MOD_NEGATE)))) & 0xFFF;
 
-				if (modulator.sweep & REG5_MOD_NEGATE)
+				if (sweep & REG5_MOD_NEGATE)
 				{
 					pos >>= 4;
 
@@ -2023,36 +2094,80 @@ namespace Nes
 			return wave.length;
 		}
 
+		inline void Fds::Sound::ClockModulator()
+		{
+			for (modulator.timer -= modulator.length * modulator.rate; modulator.timer & Modulator::TIMER_CARRY; modulator.timer += modulator.clock)
+			{
+				const uint value = modulator.pos >> 1;
+				modulator.pos = (modulator.pos + 1U) & 0x3F;
+				modulator.sweep = (modulator.table[value] != 0x80) ? (modulator.sweep + modulator.table[value]) & 0x7FU : 0x00U;
+			}
+		}
+
+		inline dword Fds::Sound::ClockWave(const uint sweep)
+		{
+			const dword pos = wave.pos;
+			wave.pos = (wave.pos + dword(qaword(GetModulation( sweep )) * wave.frame / wave.clock) + Wave::SIZE * wave.rate) % (Wave::SIZE * wave.rate);
+
+			if (wave.pos < pos)
+				wave.volume = envelopes.units[VOLUME].Output();
+
+			return wave.volume * volume * wave.table[(wave.pos / wave.rate) & 0x3F] / 30;
+		}
+
 		Fds::Sound::Sample Fds::Sound::GetSample()
 		{
 			NST_ASSERT( modulator.active == CanModulate() && bool(active) == CanOutput() );
 
 			if (modulator.active)
-			{
-				for (modulator.timer -= modulator.length * modulator.rate; modulator.timer & Modulator::TIMER_CARRY; modulator.timer += modulator.clock)
-				{
-					const uint value = modulator.pos >> 1;
-					modulator.pos = (modulator.pos + 1U) & 0x3F;
-					modulator.sweep = (modulator.table[value] != 0x80) ? (modulator.sweep + modulator.table[value]) & 0x7FU : 0x00U;
-				}
-			}
+				ClockModulator();
 
 			dword sample = 0;
 
 			if (active)
-			{
-				const dword pos = wave.pos;
-				wave.pos = (wave.pos + dword(qaword(GetModulation()) * wave.frame / wave.clock) + Wave::SIZE * wave.rate) % (Wave::SIZE * wave.rate);
+				sample = ClockWave( modulator.sweep );
+
+			amp = (amp * 2 + sample) / 3;
 
-				if (wave.pos < pos)
-					wave.volume = envelopes.units[VOLUME].Output();
+			return dcBlocker.Apply( amp * output / DEFAULT_VOLUME );
+		}
 
-				sample = wave.volume * volume * wave.table[(wave.pos / wave.rate) & 0x3F] / 30;
+		void Fds::Sound::Render(Sample* const NST_RESTRICT samples,const uint length)
+		{
+			NST_ASSERT( modulator.active == CanModulate() && bool(active) == CanOutput() );
+
+			// the modulator is run over the block first and leaves the sweep
+			// it reached for each sample, which the carrier then reads back
+
+			if (modulator.active)
+			{
+				for (uint i=0; i < length; ++i)
+				{
+					ClockModulator();
+					samples[i] = modulator.sweep;
+				}
+			}
+			else
+			{
+				for (uint i=0; i < length; ++i)
+					samples[i] = modulator.sweep;
 			}
 
-			amp = (amp * 2 + sample) / 3;
+			if (active)
+			{
+				for (uint i=0; i < length; ++i)
+					samples[i] = ClockWave( samples[i] );
+			}
+			else
+			{
+				std::memset( samples, 0, sizeof(Sample) * length );
+			}
 
-			return dcBlocker.Apply( amp * output / DEFAULT_VOLUME );
+			for (uint i=0; i < length; ++i)
+			{
+				amp = (amp * 2 + dword(samples[i])) / 3;
+				samples[i] = dcBlocker.Apply( amp * output / DEFAULT_VOLUME );
+			}
 		}
 	}
 }
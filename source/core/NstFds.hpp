@@ -55,6 +55,9 @@ namespace Nes
 			static Result GetBios(std::ostream&);
 			static bool HasBios();
 
+			void SetFastLoad(bool);
+			bool IsFastLoad() const;
+
 			class Sound : public Apu::Channel
 			{
 			public:
@@ -86,6 +89,7 @@ namespace Nes
 				void Reset();
 				bool UpdateSettings();
 				Sample GetSample();
+				void Render(Sample*,uint);
 				Cycle Clock(Cycle,Cycle,Cycle);
 
 			private:
@@ -93,7 +97,9 @@ namespace Nes
 				bool CanOutput() const;
 				inline bool CanModulate() const;
 
-				NST_SINGLE_CALL dword GetModulation() const;
+				inline void ClockModulator();
+				inline dword ClockWave(uint);
+				NST_SINGLE_CALL dword GetModulation(uint) const;
 
 				enum
 				{
@@ -232,6 +238,8 @@ namespace Nes
 			void LoadState(State::Loader&);
 			void SaveState(State::Saver&,dword) const;
 			bool PowerOff();
+			void Journal();
+			const byte* GetWram(dword&) const;
 
 			NES_DECL_PEEK( Nop  );
 			NES_DECL_POKE( Nop  );
@@ -261,6 +269,7 @@ namespace Nes
 				MAX_SIDE_SIZE        = 68000,
 				CTRL1_NMT_HORIZONTAL = 0x08,
 				OPEN_BUS             = 0x40,
+				BIOS_ADDRESS         = 0xE000,
 				DOREMIKKO_ID         = 0xA4445245
 			};
 
@@ -283,6 +292,7 @@ namespace Nes
 
 					inline byte* operator [] (uint) const;
 					void Save() const;
+					void Journal() const;
 
 					uint count;
 
@@ -366,7 +376,8 @@ namespace Nes
 					ibool Advance(uint&);
 
 					NST_SINGLE_CALL bool Clock();
-					NST_SINGLE_CALL void Write(uint);
+					NST_SINGLE_CALL void Write(uint,bool);
+					inline void Acknowledge();
 
 					enum
 					{
@@ -379,6 +390,10 @@ namespace Nes
 
 						CLK_MOTOR  = CLK_HEAD/8UL * 100 * CLK_BYTE / 1000,
 						CLK_REWIND = CLK_HEAD/8UL * 135 * CLK_BYTE / 1000,
+						CLK_FAST   = 8,
+
+						FAST_ON      = 0x1,
+						FAST_PENDING = 0x2,
 
 						CTRL_ON        = 0x01,
 						CTRL_STOP      = 0x02,
@@ -412,6 +427,7 @@ namespace Nes
 					byte out;
 					byte ctrl;
 					byte status;
+					byte fast;
 					const Disks::Sides& sides;
 				};
 
@@ -441,7 +457,7 @@ namespace Nes
 
 				inline void Mount(byte*,bool=false);
 
-				NST_SINGLE_CALL void Write(uint);
+				NST_SINGLE_CALL void Write(uint,bool);
 				NST_SINGLE_CALL uint Read();
 				NST_SINGLE_CALL void WriteProtect();
 				NST_SINGLE_CALL uint Activity() const;
@@ -477,6 +493,7 @@ namespace Nes
 
 			class Bios;
 			static Bios bios;
+			bool fastLoad;
 
 		public:
 
@@ -38,10 +38,27 @@ namespace Nes
 
 		struct File::Context
 		{
+			Context()
+			: journaling(false) {}
+
 			Checksum checksum;
 			Vector<byte> data;
+			Vector<byte> shadow;
+			bool journaling;
 		};
 
+		static Api::User::File::Action GetSaveAction(const File::Type type)
+		{
+			return
+			(
+				type == File::EEPROM    ? Api::User::File::SAVE_EEPROM :
+				type == File::TAPE      ? Api::User::File::SAVE_TAPE :
+				type == File::TURBOFILE ? Api::User::File::SAVE_TURBOFILE :
+				type == File::DISK      ? Api::User::File::SAVE_FDS :
+                                          Api::User::File::SAVE_BATTERY
+			);
+		}
+
 		File::File()
 		: context( *new Context )
 		{
@@ -59,6 +76,7 @@ namespace Nes
 			context.checksum.Clear();
 			context.checksum.Compute( data, size );
 			context.data.Destroy();
+			context.shadow.Destroy();
 		}
 
 		void File::Load(byte* data,dword size,Type type) const
@@ -254,6 +272,7 @@ namespace Nes
 			}
 
 			context.checksum.Clear();
+			context.shadow.Destroy();
 
 			for (const LoadBlock* NST_RESTRICT it=loadBlock, *const end=loadBlock+loadBlockCount; it != end; ++it)
 				context.checksum.Compute( it->data, it->size );
@@ -377,6 +396,12 @@ namespace Nes
 		{
 			NST_ASSERT( saveBlock && saveBlockCount );
 
+			if (context.journaling)
+			{
+				Journal( type, saveBlock, saveBlockCount );
+				return;
+			}
+
 			Checksum checksum;
 
 			for (const SaveBlock *NST_RESTRICT it=saveBlock, *const end=saveBlock+saveBlockCount; it != end; ++it)
@@ -509,14 +534,7 @@ namespace Nes
 
 					Saver(Type t,const SaveBlock* s,uint c,const Vector<byte>& o)
 					:
-					action
-					(
-						t == EEPROM    ? SAVE_EEPROM :
-						t == TAPE      ? SAVE_TAPE :
-						t == TURBOFILE ? SAVE_TURBOFILE :
-						t == DISK      ? SAVE_FDS :
-                                         SAVE_BATTERY
-					),
+					action         (GetSaveAction(t)),
 					saveBlock      (s),
 					saveBlockCount (c),
 					original       (o)
@@ -528,5 +546,93 @@ namespace Nes
 				Api::User::fileIoCallback( saver );
 			}
 		}
+
+		void File::SetJournaling(bool journaling) const
+		{
+			context.journaling = journaling;
+		}
+
+		void File::Journal(const Type type,const SaveBlock* const saveBlock,const uint saveBlockCount) const
+		{
+			enum
+			{
+				PAGE = 0x40,
+				GAP = PAGE * 2
+			};
+
+			dword size = 0;
+
+			for (const SaveBlock* NST_RESTRICT it=saveBlock, *const end=saveBlock+saveBlockCount; it != end; ++it)
+				size += it->size;
+
+			if (!size)
+				return;
+
+			const Api::User::File::Action action = GetSaveAction( type );
+
+			if (context.shadow.Size() != size)
+			{
+				// first pass, anything not matching the loaded content goes in as a whole
+
+				context.shadow.Resize( size );
+
+				Checksum checksum;
+
+				for (dword offset=0, i=0; i < saveBlockCount; offset += saveBlock[i].size, ++i)
+				{
+					if (saveBlock[i].size)
+					{
+						std::memcpy( context.shadow.Begin() + offset, saveBlock[i].data, saveBlock[i].size );
+						checksum.Compute( saveBlock[i].data, saveBlock[i].size );
+					}
+				}
+
+				if (checksum != context.checksum)
+					Api::User::journalCallback( action, 0, context.shadow.Begin(), size );
+
+				return;
+			}
+
+			dword first = 0, last = 0;
+			bool dirty = false;
+
+			for (dword offset=0, i=0; i < saveBlockCount; offset += saveBlock[i].size, ++i)
+			{
+				// boards with only some of their chips fitted pass empty blocks
+
+				if (!saveBlock[i].size)
+					continue;
+
+				const byte* const NST_RESTRICT src = saveBlock[i].data;
+				byte* const NST_RESTRICT dst = context.shadow.Begin() + offset;
+
+				for (dword pos=0, length=saveBlock[i].size; pos < length; pos += PAGE)
+				{
+					const dword n = NST_MIN(length-pos,dword(PAGE));
+
+					if (std::memcmp( dst+pos, src+pos, n ) == 0)
+						continue;
+
+					std::memcpy( dst+pos, src+pos, n );
+
+					if (dirty && offset + pos > last + GAP)
+					{
+						Api::User::journalCallback( action, first, &context.shadow[first], last - first );
+						dirty = false;
+					}
+
+					if (!dirty)
+					{
+						dirty = true;
+						first = offset + pos;
+					}
+
+					last = offset + pos + n;
+				}
+			}
+
+			if (dirty)
+				Api::User::journalCallback( action, first, &context.shadow[first], last - first );
+		}
 	}
 }
@@ -72,11 +72,13 @@ namespace Nes
 			void Load(Type,byte*,dword) const;
 			void Load(Type,Vector<byte>&,dword) const;
 			void Save(Type,const byte*,dword) const;
+			void SetJournaling(bool) const;
 
 		private:
 
 			void Load(Type,const LoadBlock*,uint,bool* = NULL) const;
 			void Save(Type,const SaveBlock*,uint) const;
+			void Journal(Type,const SaveBlock*,uint) const;
 
 		public:
 
@@ -97,6 +97,8 @@ namespace Nes
 
 			virtual void VSync() {}
 
+			virtual void Journal() {}
+
 			virtual void LoadState(State::Loader&) {}
 			virtual void SaveState(State::Saver&,dword) const {}
 
@@ -115,6 +117,12 @@ namespace Nes
 				return NULL;
 			}
 
+			virtual const byte* GetWram(dword& size) const
+			{
+				size = 0;
+				return NULL;
+			}
+
 		protected:
 
 			explicit Image(Type);
@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "NstAssert.hpp"
+#include "NstLz.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		namespace Lz
+		{
+			// Byte-oriented LZ77 with a single-probe hash table. Trades ratio
+			// for speed; the block layout is that of LZ4:
+			//
+			// token    - literal length (high nibble), match length - 4 (low nibble)
+			// [length] - 255-continued extension if the nibble is 15
+			// literals
+			// offset   - little-endian 16-bit match distance (absent in the last sequence)
+			// [length] - 255-continued match length extension
+
+			enum
+			{
+				MIN_MATCH     = 4,
+				MAX_OFFSET    = 0xFFFF,
+				LAST_LITERALS = 5,
+				MATCH_LIMIT   = 12,
+				HASH_BITS     = 12,
+				RUN_MASK      = 0xF
+			};
+
+			inline dword Read32(const byte* p)
+			{
+				return p[0] | uint(p[1]) << 8 | dword(p[2]) << 16 | dword(p[3]) << 24;
+			}
+
+			inline uint Hash(dword sequence)
+			{
+				return (sequence * 2654435761U & 0xFFFFFFFF) >> (32 - HASH_BITS);
+			}
+
+			static byte* WriteLength(byte* NST_RESTRICT dst,ulong length)
+			{
+				for (; length >= 0xFF; length -= 0xFF)
+					*dst++ = 0xFF;
+
+				*dst++ = length;
+
+				return dst;
+			}
+
+			static byte* WriteSequence
+			(
+				byte* NST_RESTRICT dst,
+				const byte* const end,
+				const byte* const literals,
+				const ulong numLiterals,
+				const ulong offset,
+				const ulong length
+			)
+			{
+				if (ulong(end - dst) < 1 + 2 + numLiterals + numLiterals / 0xFF + 1 + length / 0xFF + 1)
+					return NULL;
+
+				byte* const token = dst++;
+
+				if (numLiterals >= RUN_MASK)
+				{
+					*token = RUN_MASK << 4;
+					dst = WriteLength( dst, numLiterals - RUN_MASK );
+				}
+				else
+				{
+					*token = numLiterals << 4;
+				}
+
+				for (ulong i=0; i < numLiterals; ++i)
+					dst[i] = literals[i];
+
+				dst += numLiterals;
+
+				if (offset)
+				{
+					*dst++ = offset & 0xFF;
+					*dst++ = offset >> 8;
+
+					if (length - MIN_MATCH >= RUN_MASK)
+					{
+						*token |= RUN_MASK;
+						dst = WriteLength( dst, length - MIN_MATCH - RUN_MASK );
+					}
+					else
+					{
+						*token |= length - MIN_MATCH;
+					}
+				}
+
+				return dst;
+			}
+
+			ulong NST_CALL Compress(const byte* const src,const ulong srcSize,byte* const dst,const ulong dstSize)
+			{
+				if (!srcSize || !dstSize)
+					return 0;
+
+				NST_ASSERT( src && dst );
+
+				dword table[1UL << HASH_BITS] = {0};
+
+				byte* out = dst;
+				byte* const end = dst + dstSize;
+
+				ulong anchor = 0;
+
+				if (srcSize > MATCH_LIMIT)
+				{
+					const ulong matchEnd = srcSize - LAST_LITERALS;
+
+					for (ulong pos=0; pos < srcSize - MATCH_LIMIT; )
+					{
+						const dword sequence = Read32( src + pos );
+						dword& slot = table[Hash( sequence )];
+						const ulong ref = slot;
+						slot = pos + 1;
+
+						if (ref && pos - (ref-1) <= MAX_OFFSET && Read32( src + ref-1 ) == sequence)
+						{
+							ulong length = MIN_MATCH;
+
+							while (pos + length < matchEnd && src[ref-1+length] == src[pos+length])
+								++length;
+
+							out = WriteSequence( out, end, src + anchor, pos - anchor, pos - (ref-1), length );
+
+							if (!out)
+								return 0;
+
+							pos += length;
+							anchor = pos;
+						}
+						else
+						{
+							pos += 1 + ((pos - anchor) >> 6);
+						}
+					}
+				}
+
+				out = WriteSequence( out, end, src + anchor, srcSize - anchor, 0, 0 );
+
+				return out ? out - dst : 0;
+			}
+
+			ulong NST_CALL Uncompress(const byte* const src,const ulong srcSize,byte* const dst,const ulong dstSize)
+			{
+				if (!srcSize || !dstSize)
+					return 0;
+
+				NST_ASSERT( src && dst );
+
+				ulong in = 0, out = 0;
+
+				for (;;)
+				{
+					const uint token = src[in++];
+					ulong length = token >> 4;
+
+					if (length == RUN_MASK)
+					{
+						for (uint next=0xFF; next == 0xFF; length += next)
+						{
+							if (in == srcSize)
+								return 0;
+
+							next = src[in++];
+						}
+					}
+
+					if (length > srcSize - in || length > dstSize - out)
+						return 0;
+
+					for (const ulong stop=in+length; in < stop; )
+						dst[out++] = src[in++];
+
+					if (in == srcSize)
+						break;
+
+					if (srcSize - in < 2)
+						return 0;
+
+					const ulong offset = src[in] | uint(src[in+1]) << 8;
+					in += 2;
+
+					if (!offset || offset > out)
+						return 0;
+
+					length = token & RUN_MASK;
+
+					if (length == RUN_MASK)
+					{
+						for (uint next=0xFF; next == 0xFF; length += next)
+						{
+							if (in == srcSize)
+								return 0;
+
+							next = src[in++];
+						}
+					}
+
+					length += MIN_MATCH;
+
+					if (length > dstSize - out)
+						return 0;
+
+					for (const ulong stop=out+length; out < stop; ++out)
+						dst[out] = dst[out-offset];
+
+					if (in == srcSize)
+						return 0;
+				}
+
+				return out;
+			}
+		}
+	}
+}
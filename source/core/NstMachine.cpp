@@ -25,11 +25,13 @@
 #include "NstMachine.hpp"
 #include "NstCartridge.hpp"
 #include "NstCheats.hpp"
+#include "NstFds.hpp"
 #include "NstNsf.hpp"
 #include "NstImageDatabase.hpp"
 #include "input/NstInpDevice.hpp"
 #include "input/NstInpAdapter.hpp"
 #include "input/NstInpPad.hpp"
+#include "input/NstInpTurboFile.hpp"
 #include "api/NstApiMachine.hpp"
 #include "api/NstApiUser.hpp"
 
@@ -50,8 +52,16 @@ namespace Nes
 		image         (NULL),
 		cheats        (NULL),
 		imageDatabase (NULL),
-		ppu           (cpu)
+		ppu           (cpu),
+		fdsFastLoad   (false),
+		memoryEpoch   (0)
 		{
+			for (uint i=0; i < NUM_MEMORY_WATCHES; ++i)
+			{
+				memoryWatches[i].writes = 0;
+				memoryWatches[i].epoch = 0;
+				memoryWatches[i].generation = 0;
+			}
 		}
 
 		Machine::~Machine()
@@ -121,6 +131,7 @@ namespace Nes
 				case Image::DISK:
 
 					state |= Api::Machine::DISK;
+					static_cast<Fds*>(image)->SetFastLoad( fdsFastLoad );
 					break;
 
 				case Image::SOUND:
@@ -138,12 +149,19 @@ namespace Nes
 
 		Result Machine::Unload()
 		{
+			// loading, unloading, resets and state loads rewrite memory
+			// without going through the counted write paths
+
+			++memoryEpoch;
+
 			if (!image)
 				return RESULT_OK;
 
 			const Result result = PowerOff();
 
 			tracker.Unload();
+			stateReference.Clear();
+			hashCache.Clear();
 
 			Image::Unload( image );
 			image = NULL;
@@ -258,6 +276,8 @@ namespace Nes
 			if (state & Api::Machine::SOUND)
 				hard = true;
 
+			++memoryEpoch;
+
 			try
 			{
 				frame = 0;
@@ -387,6 +407,8 @@ namespace Nes
 		{
 			NST_ASSERT( (state & (Api::Machine::GAME|Api::Machine::ON)) > Api::Machine::ON );
 
+			++memoryEpoch;
+
 			try
 			{
 				if (loader.Begin() != (AsciiId<'N','S','T'>::V | 0x1AUL << 24))
@@ -498,6 +520,7 @@ namespace Nes
 		)
 		{
 			NST_ASSERT( state & Api::Machine::ON );
+			NST_PROFILE_TIME( cpu.GetProfiler(), TIME_MACHINE );
 
 			if (!(state & Api::Machine::SOUND))
 			{
@@ -518,7 +541,10 @@ namespace Nes
 				renderer.bgColor = ppu.output.bgColor;
 
 				if (video)
+				{
+					NST_PROFILE_TIME( cpu.GetProfiler(), TIME_BLIT );
 					renderer.Blit( *video, ppu.GetScreen(), ppu.GetBurstPhase() );
+				}
 
 				cpu.EndFrame();
 
@@ -528,6 +554,15 @@ namespace Nes
 				extPort->EndFrame();
 				expPort->EndFrame();
 
+				if (Api::User::journalCallback)
+				{
+					if (image)
+						image->Journal();
+
+					if (expPort->GetType() == Api::Input::TURBOFILE)
+						static_cast<const Input::TurboFile*>(expPort)->Journal();
+				}
+
 				frame++;
 			}
 			else
@@ -28,6 +28,7 @@
 #include <iosfwd>
 #include "NstCpu.hpp"
 #include "NstPpu.hpp"
+#include "NstState.hpp"
 #include "NstTracker.hpp"
 #include "NstVideoRenderer.hpp"
 
@@ -132,6 +133,24 @@ namespace Nes
 			Tracker tracker;
 			Ppu ppu;
 			Video::Renderer renderer;
+			State::Reference stateReference;
+			State::HashCache hashCache;
+			bool fdsFastLoad;
+
+			enum
+			{
+				NUM_MEMORY_WATCHES = 6
+			};
+
+			struct MemoryWatch
+			{
+				dword writes;
+				dword epoch;
+				dword generation;
+			};
+
+			MemoryWatch memoryWatches[NUM_MEMORY_WATCHES];
+			dword memoryEpoch;
 
 			uint Is(uint a) const
 			{
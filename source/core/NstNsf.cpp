@@ -133,8 +133,11 @@ namespace Nes
 			void Reset();
 			bool UpdateSettings();
 			Sample GetSample();
+			void Render(Sample*,uint);
 			Cycle Clock(Cycle,Cycle,Cycle);
 
+			static void Mix(Channel&,Sample* NST_RESTRICT,Sample* NST_RESTRICT,uint);
+
 			Clocks clocks;
 
 		public:
@@ -545,6 +548,12 @@ namespace Nes
 			return true;
 		}
 
+		const byte* Nsf::GetWram(dword& size) const
+		{
+			size = SIZE_8K;
+			return wrk;
+		}
+
 		Result Nsf::SelectSong(const uint song)
 		{
 			if (song < songs.count)
@@ -604,6 +613,7 @@ namespace Nes
 		void Nsf::InitSong()
 		{
 			std::memset( wrk, 0x00, SIZE_8K );
+			cpu.CountWrite( 0x6000 );
 
 			if (chips && chips->mmc5)
 				chips->mmc5->ClearExRam();
@@ -635,6 +645,7 @@ namespace Nes
 
 			apu.ClearBuffers();
 			std::memset( cpu.GetRam(), 0x00, Cpu::RAM_SIZE );
+			cpu.CountWrite( 0x0000 );
 
 			for (uint i=0x4000; i <= 0x4013; ++i)
 				cpu.Poke( i, 0x00 );
@@ -694,6 +705,36 @@ namespace Nes
 			);
 		}
 
+		void Nsf::Chips::Mix(Channel& chip,Sample* const NST_RESTRICT samples,Sample* const NST_RESTRICT block,const uint length)
+		{
+			chip.Render( block, length );
+
+			for (uint i=0; i < length; ++i)
+				samples[i] += block[i];
+		}
+
+		void Nsf::Chips::Render(Sample* samples,uint length)
+		{
+			Sample block[RENDER_BLOCK];
+
+			while (length)
+			{
+				const uint count = NST_MIN(length,RENDER_BLOCK);
+
+				std::memset( samples, 0, sizeof(Sample) * count );
+
+				if ( mmc5 ) Mix( *mmc5, samples, block, count );
+				if ( vrc6 ) Mix( *vrc6, samples, block, count );
+				if ( vrc7 ) Mix( *vrc7, samples, block, count );
+				if ( fds  ) Mix( *fds,  samples, block, count );
+				if ( s5b  ) Mix( *s5b,  samples, block, count );
+				if ( n163 ) Mix( *n163, samples, block, count );
+
+				samples += count;
+				length -= count;
+			}
+		}
+
 		inline uint Nsf::FetchLast(uint offset) const
 		{
 			NST_ASSERT( offset <= 0xFFF );
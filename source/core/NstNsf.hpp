@@ -54,6 +54,7 @@ namespace Nes
 
 			void Reset(bool);
 			bool PowerOff();
+			const byte* GetWram(dword&) const;
 			void InitSong();
 			Region GetDesiredRegion() const;
 
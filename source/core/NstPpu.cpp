@@ -108,6 +108,15 @@ namespace Nes
 		yuvMap (NULL)
 		{
 			cycles.one = PPU_RP2C02_CC;
+
+			lightSensor.pos = ~0U;
+			lightSensor.luma = LightSensor::PENDING;
+			lightSensor.map = NULL;
+			lightSensor.yuv = false;
+
+			for (uint i=0; i < NUM_WRITE_COUNTS; ++i)
+				writes[i] = 0;
+
 			PowerOff();
 		}
 
@@ -185,6 +194,7 @@ namespace Nes
 
 				std::memcpy( palette.ram, powerUpPalette, Palette::SIZE );
 				std::memset( oam.ram, Oam::GARBAGE, Oam::SIZE );
+				++writes[WRITES_OAM];
 				std::memset( nameTable.ram, NameTable::GARBAGE, NameTable::SIZE );
 
 				io.latch = 0;
@@ -222,6 +232,7 @@ namespace Nes
 				cycles.hClock = HCLOCK_BOOT;
 
 				std::memset( oam.ram, Oam::GARBAGE, Oam::SIZE );
+				++writes[WRITES_OAM];
 			}
 			else
 			{
@@ -271,6 +282,7 @@ namespace Nes
 			oam.mask = 0;
 
 			output.target = NULL;
+			lightSensor.luma = LightSensor::PENDING;
 
 			hActiveHook.Unset();
 			hBlankHook.Unset();
@@ -339,7 +351,7 @@ namespace Nes
 			}
 
 			state.Begin( AsciiId<'P','A','L'>::V ).Compress( palette.ram   ).End();
-			state.Begin( AsciiId<'O','A','M'>::V ).Compress( oam.ram       ).End();
+			state.Begin( AsciiId<'O','A','M'>::V ).Compress( oam.ram, Oam::SIZE, writes[WRITES_OAM] ).End();
 			state.Begin( AsciiId<'N','M','T'>::V ).Compress( nameTable.ram ).End();
 
 			if (model == PPU_RP2C02)
@@ -387,6 +399,7 @@ namespace Nes
 					case AsciiId<'O','A','M'>::V:
 
 						state.Uncompress( oam.ram );
+						++writes[WRITES_OAM];
 						break;
 
 					case AsciiId<'N','M','T'>::V:
@@ -498,6 +511,7 @@ namespace Nes
 
 			oam.limit = oam.buffer + ((oam.spriteLimit || frameLock) ? Oam::STD_LINE_SPRITES*4 : Oam::MAX_LINE_SPRITES*4);
 			output.target = output.pixels;
+			lightSensor.luma = LightSensor::PENDING;
 
 			Cycle frame;
 
@@ -732,6 +746,54 @@ namespace Nes
 			return (scanline+1)-1U < 240 ? scanline * 256 + NST_MIN(cycles.hClock,255) : ~0U;
 		}
 
+		uint Ppu::GetLightSensor(const uint pos,const byte* const map,const bool yuv)
+		{
+			// The sensor sees the target pixel from the moment it's drawn until
+			// the beam has moved PHOSPHOR_DECAY pixels past it. Its brightness
+			// is looked up on the first read inside that window and kept for
+			// the rest of the frame. Each light gun owns its aim point, the
+			// cached value is dropped whenever a different one is asked for.
+
+			if (pos < Video::Screen::PIXELS)
+			{
+				NST_ASSERT( map );
+
+				Update();
+
+				if (GetPixelCycles() - pos - 1 < LightSensor::PHOSPHOR_DECAY)
+				{
+					if (lightSensor.pos != pos || lightSensor.map != map || bool(lightSensor.yuv) != yuv)
+					{
+						lightSensor.pos = pos;
+						lightSensor.map = map;
+						lightSensor.yuv = yuv;
+						lightSensor.luma = LightSensor::PENDING;
+					}
+
+					if (lightSensor.luma == LightSensor::PENDING)
+					{
+						uint pixel = output.pixels[lightSensor.pos];
+
+						if (lightSensor.yuv)
+						{
+							NST_VERIFY( pixel <= 0x3F );
+
+							if (pixel > 0x3F)
+								return lightSensor.luma = pixel;
+
+							pixel = GetYuvColor( pixel );
+						}
+
+						lightSensor.luma = lightSensor.map[pixel];
+					}
+
+					return lightSensor.luma;
+				}
+			}
+
+			return 0;
+		}
+
 		NST_FORCE_INLINE bool Ppu::IsDead() const
 		{
 			return scanline == SCANLINE_VBLANK || !(regs.ctrl[1] & Regs::CTRL1_BG_SP_ENABLED);
@@ -878,6 +940,7 @@ namespace Nes
 			regs.oam = (regs.oam + 1) & 0xFF;
 			io.latch = data;
 			*value = data;
+			++writes[WRITES_OAM];
 		}
 
 		NES_PEEK(Ppu,2004)
@@ -971,6 +1034,7 @@ namespace Nes
 
 				palette.ram[address] = data;
 				output.palette[address] = final;
+				++writes[WRITES_PALETTE];
 
 				if (!(address & 0x3))
 				{
@@ -985,9 +1049,15 @@ namespace Nes
 				address &= 0x3FFF;
 
 				if (address >= 0x2000)
+				{
 					nmt.Poke( address & 0xFFF, data );
+					++writes[WRITES_NMT];
+				}
 				else
+				{
 					chr.Poke( address, data );
+					++writes[WRITES_CHR];
+				}
 			}
 		}
 
@@ -1053,6 +1123,7 @@ namespace Nes
 				}
 
 				io.latch = oamRam[0xFF];
+				++writes[WRITES_OAM];
 			}
 			else do
 			{
@@ -1077,6 +1148,7 @@ namespace Nes
 				byte* const NST_RESTRICT out = oam.ram + regs.oam;
 				regs.oam = (regs.oam + 1) & 0xFF;
 				*out = io.latch;
+				++writes[WRITES_OAM];
 			}
 			while (data & 0xFF);
 		}
@@ -1427,6 +1499,7 @@ namespace Nes
 		NST_NO_INLINE void Ppu::Run()
 		{
 			NST_VERIFY( cycles.count != cycles.hClock );
+			NST_PROFILE_TIME( cpu.GetProfiler(), TIME_PPU );
 
 			if (scanline_sleep >= 0)
 			{
@@ -60,6 +60,22 @@ namespace Nes
 				SCANLINE_VBLANK = 240
 			};
 
+			enum
+			{
+				OAM_SIZE     = 0x100,
+				PALETTE_SIZE = 0x20,
+				NMT_RAM_SIZE = SIZE_2K
+			};
+
+			enum WriteCount
+			{
+				WRITES_NMT,
+				WRITES_CHR,
+				WRITES_OAM,
+				WRITES_PALETTE,
+				NUM_WRITE_COUNTS
+			};
+
 			enum NmtMirroring
 			{
 				NMT_H = 0xC,
@@ -76,6 +92,7 @@ namespace Nes
 			void SetHBlankHook(const Hook&);
 			uint GetPixelCycles() const;
 			void EnableCpuSynchronization();
+			uint GetLightSensor(uint,const byte*,bool);
 
 			void LoadState(State::Loader&);
 			void SaveState(State::Saver&,dword) const;
@@ -314,6 +331,20 @@ namespace Nes
 				uint bgColor;
 			};
 
+			struct LightSensor
+			{
+				enum
+				{
+					PHOSPHOR_DECAY = 384,
+					PENDING = ~0U
+				};
+
+				uint pos;
+				uint luma;
+				const byte* map;
+				ibool yuv;
+			};
+
 			struct Oam
 			{
 				Oam();
@@ -426,6 +457,8 @@ namespace Nes
 			Palette palette;
 			NameTable nameTable;
 			const TileLut tileLut;
+			LightSensor lightSensor;
+			dword writes[NUM_WRITE_COUNTS];
 			Video::Screen screen;
 
 			static const byte yuvMaps[4][0x40];
@@ -480,6 +513,22 @@ namespace Nes
 				return palette;
 			}
 
+			const byte* GetOamRam() const
+			{
+				return oam.ram;
+			}
+
+			const byte* GetNameTableRam() const
+			{
+				return nameTable.ram;
+			}
+
+			dword GetWriteCount(WriteCount i) const
+			{
+				NST_ASSERT( i < NUM_WRITE_COUNTS );
+				return writes[i];
+			}
+
 			uint GetPixel(uint i) const
 			{
 				NST_ASSERT( i < Video::Screen::PIXELS );
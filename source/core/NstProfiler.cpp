@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "NstAssert.hpp"
+
+#ifdef NST_PROFILER
+
+#include <cstring>
+#include "NstProfiler.hpp"
+
+#ifdef NST_WIN32
+
+ #ifndef WIN32_LEAN_AND_MEAN
+ #define WIN32_LEAN_AND_MEAN
+ #endif
+
+ #include <windows.h>
+
+#else
+
+ #include <time.h>
+
+#endif
+
+namespace Nes
+{
+	namespace Core
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Profiler::Profiler()
+		: next(0), size(0), enabled(false)
+		{
+			std::memset( &current, 0, sizeof(current) );
+
+		#ifdef NST_WIN32
+			LARGE_INTEGER count;
+			::QueryPerformanceFrequency( &count );
+			frequency = count.QuadPart;
+		#endif
+		}
+
+		void Profiler::Enable(bool enable)
+		{
+			enabled = enable;
+			std::memset( &current, 0, sizeof(current) );
+		}
+
+		void Profiler::Clear()
+		{
+			next = 0;
+			size = 0;
+			std::memset( &current, 0, sizeof(current) );
+		}
+
+		const Profiler::Sample& Profiler::operator [] (uint i) const
+		{
+			NST_ASSERT( i < size );
+			return samples[(next + NUM_SAMPLES - size + i) % NUM_SAMPLES];
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		void Profiler::EndFrame(dword frame)
+		{
+			if (enabled)
+			{
+				current.frame = frame;
+				samples[next] = current;
+				next = (next + 1) % NUM_SAMPLES;
+
+				if (size < NUM_SAMPLES)
+					++size;
+			}
+
+			std::memset( &current, 0, sizeof(current) );
+		}
+
+		qaword Profiler::Now() const
+		{
+		#ifdef NST_WIN32
+
+			LARGE_INTEGER count;
+			::QueryPerformanceCounter( &count );
+
+			return qaword(count.QuadPart / frequency) * 1000000000 + qaword(count.QuadPart % frequency) * 1000000000 / frequency;
+
+		#else
+
+			timespec time;
+			::clock_gettime( CLOCK_MONOTONIC, &time );
+
+			return qaword(time.tv_sec) * 1000000000 + time.tv_nsec;
+
+		#endif
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_PROFILER_H
+#define NST_PROFILER_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#ifdef NST_PROFILER
+
+ #define NST_PROFILE_COUNT(profiler_,counter_,count_) (profiler_).Count( Nes::Core::Profiler::counter_, count_ )
+ #define NST_PROFILE_TIME(profiler_,timer_) const Nes::Core::Profiler::Scope nstProfile##timer_( profiler_, Nes::Core::Profiler::timer_ )
+
+#else
+
+ #define NST_PROFILE_COUNT(profiler_,counter_,count_) NST_NOP()
+ #define NST_PROFILE_TIME(profiler_,timer_) NST_NOP()
+
+#endif
+
+#ifdef NST_PROFILER
+
+namespace Nes
+{
+	namespace Core
+	{
+		class Profiler
+		{
+		public:
+
+			Profiler();
+
+			enum Counter
+			{
+				CPU_INSTRUCTIONS,
+				CPU_HOOKS,
+				MAPPER_READS,
+				MAPPER_WRITES,
+				APU_SAMPLES,
+				NUM_COUNTERS
+			};
+
+			enum Timer
+			{
+				TIME_FRAME,
+				TIME_MACHINE,
+				TIME_CPU,
+				TIME_PPU,
+				TIME_APU,
+				TIME_BLIT,
+				NUM_TIMERS
+			};
+
+			enum
+			{
+				NUM_SAMPLES = 256
+			};
+
+			struct Sample
+			{
+				dword frame;
+				dword counters[NUM_COUNTERS];
+				dword times[NUM_TIMERS];
+			};
+
+			void Enable(bool);
+			void Clear();
+			void EndFrame(dword);
+
+			const Sample& operator [] (uint) const;
+
+			qaword Now() const;
+
+			class Scope
+			{
+				Profiler& profiler;
+				const uint timer;
+				const qaword start;
+
+			public:
+
+				Scope(Profiler& p,uint t)
+				: profiler(p), timer(t), start(p.enabled ? p.Now() : 0) {}
+
+				~Scope()
+				{
+					if (profiler.enabled)
+						profiler.current.times[timer] += profiler.Now() - start;
+				}
+			};
+
+		private:
+
+			Sample current;
+			Sample samples[NUM_SAMPLES];
+			uint next;
+			uint size;
+			bool enabled;
+		#ifdef NST_WIN32
+			qaword frequency;
+		#endif
+
+		public:
+
+			void Count(Counter counter,dword count)
+			{
+				current.counters[counter] += count;
+			}
+
+			bool Enabled() const
+			{
+				return enabled;
+			}
+
+			uint NumSamples() const
+			{
+				return size;
+			}
+		};
+	}
+}
+
+#endif
+
+#endif
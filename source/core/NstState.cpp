@@ -22,8 +22,12 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <cstring>
 #include "NstState.hpp"
+#include "NstCrc32.hpp"
 #include "NstZlib.hpp"
+#include "NstLz.hpp"
+#include "NstThread.hpp"
 
 namespace Nes
 {
@@ -31,20 +35,80 @@ namespace Nes
 	{
 		namespace State
 		{
-			enum Compression
+			static inline qaword HashPrime(const dword hi,const dword lo)
 			{
-				NO_COMPRESSION,
-				ZLIB_COMPRESSION
-			};
+				return qaword(hi) << 32 | lo;
+			}
+
+			static inline qaword HashPrime1() { return HashPrime( 0x9E3779B1, 0x85EBCA87 ); }
+			static inline qaword HashPrime2() { return HashPrime( 0xC2B2AE3D, 0x27D4EB4F ); }
+			static inline qaword HashPrime3() { return HashPrime( 0x165667B1, 0x9E3779F9 ); }
+			static inline qaword HashPrime4() { return HashPrime( 0x85EBCA77, 0xC2B2AE63 ); }
+			static inline qaword HashPrime5() { return HashPrime( 0x27D4EB2F, 0x165667C5 ); }
+
+			static dword Encode(const uint compression,const byte* const data,const dword length,byte* const buffer,const dword size)
+			{
+				switch (compression)
+				{
+					case ZLIB_COMPRESSION:
+
+						return Zlib::AVAILABLE ? Zlib::Compress( data, length, buffer, size, Zlib::BEST_COMPRESSION ) : 0;
+
+					case LZ_COMPRESSION:
+
+						return Lz::Compress( data, length, buffer, size );
+				}
+
+				return 0;
+			}
 
 			#ifdef NST_MSVC_OPTIMIZE
 			#pragma optimize("s", on)
 			#endif
 
-			Saver::Saver(StdStream p,bool c,bool i,dword append)
-			: stream(p), chunks(CHUNK_RESERVE), useCompression(c), internal(i)
+			Batch::Batch(uint c)
+			: compression(c), ready(false), next(0) {}
+
+			Reference::Reference()
+			: id(0) {}
+
+			Hash::Hash()
+			: length(0), pending(0)
+			{
+				lanes[0] = HashPrime1() + HashPrime2();
+				lanes[1] = HashPrime2();
+				lanes[2] = 0;
+				lanes[3] = 0 - HashPrime1();
+			}
+
+			void Reference::Clear()
+			{
+				blocks.Destroy();
+				data.Destroy();
+				id = 0;
+			}
+
+			Saver::Saver(StdStream p,uint c,bool i,dword append,Batch* b,Reference* r)
+			:
+			stream      (p),
+			chunks      (CHUNK_RESERVE),
+			compression (c),
+			internal    (i),
+			batch       (b),
+			reference   (r),
+			hash        (NULL),
+			hashCache   (NULL),
+			detached    (false),
+			blocks      (0)
 			{
 				NST_COMPILE_ASSERT( CHUNK_RESERVE >= 2 );
+				NST_ASSERT( compression != DELTA_COMPRESSION || (reference && !reference->Empty()) );
+				NST_ASSERT( !batch || batch->ready );
+
+				// with any other compression the blocks of this save become the new reference
+
+				if (reference && compression != DELTA_COMPRESSION)
+					reference->Clear();
 
 				chunks.SetTo(1);
 				chunks.Front() = 0;
@@ -57,6 +121,48 @@ namespace Nes
 				}
 			}
 
+			Saver::Saver(Batch& b)
+			:
+			stream      (),
+			chunks      (CHUNK_RESERVE),
+			compression (b.compression),
+			internal    (false),
+			batch       (&b),
+			reference   (NULL),
+			hash        (NULL),
+			hashCache   (NULL),
+			detached    (true),
+			blocks      (0)
+			{
+				NST_ASSERT( !batch->ready );
+
+				// nothing is written, the blocks are only collected for
+				// compression ahead of the pass that writes the save
+
+				chunks.SetTo(1);
+				chunks.Front() = 0;
+			}
+
+			Saver::Saver(Hash& h,HashCache& c)
+			:
+			stream      (),
+			chunks      (CHUNK_RESERVE),
+			compression (NO_COMPRESSION),
+			internal    (false),
+			batch       (NULL),
+			reference   (NULL),
+			hash        (&h),
+			hashCache   (&c),
+			detached    (true),
+			blocks      (0)
+			{
+				// nothing goes to a stream, chunk ids and data are fed to the
+				// hash in the order a save would write them
+
+				chunks.SetTo(1);
+				chunks.Front() = 0;
+			}
+
 			Saver::~Saver()
 			{
 				NST_VERIFY( chunks.Size() == 1 );
@@ -66,10 +172,227 @@ namespace Nes
 			#pragma optimize("", on)
 			#endif
 
+			// XXH64 with a zero seed, fed the same bytes a save would write
+			// with everything in little-endian order
+
+			inline qaword Hash::Rotate(const qaword value,const uint shift)
+			{
+				return value << shift | value >> (64 - shift);
+			}
+
+			inline qaword Hash::Read(const byte* const data)
+			{
+				return
+				(
+					qaword(data[0] | uint(data[1]) << 8 | dword(data[2]) << 16 | dword(data[3]) << 24) |
+					qaword(data[4] | uint(data[5]) << 8 | dword(data[6]) << 16 | dword(data[7]) << 24) << 32
+				);
+			}
+
+			inline qaword Hash::Round(const qaword lane,const qaword input)
+			{
+				return Rotate( lane + input * HashPrime2(), 31 ) * HashPrime1();
+			}
+
+			void Hash::Consume(const byte* const data)
+			{
+				for (uint i=0; i < 4; ++i)
+					lanes[i] = Round( lanes[i], Read(data + i * 8) );
+			}
+
+			void Hash::Write(const byte* data,dword size)
+			{
+				length += size;
+
+				if (pending)
+				{
+					const dword count = NST_MIN(dword(STRIPE-pending),size);
+
+					std::memcpy( buffer + pending, data, count );
+					pending += count;
+					data += count;
+					size -= count;
+
+					if (pending < STRIPE)
+						return;
+
+					Consume( buffer );
+					pending = 0;
+				}
+
+				for (; size >= STRIPE; data += STRIPE, size -= STRIPE)
+					Consume( data );
+
+				if (size)
+				{
+					std::memcpy( buffer, data, size );
+					pending = size;
+				}
+			}
+
+			void Hash::Write8(const uint data)
+			{
+				const byte bytes[1] = { data & 0xFF };
+				Write( bytes, 1 );
+			}
+
+			void Hash::Write16(const uint data)
+			{
+				const byte bytes[2] = { data & 0xFF, data >> 8 & 0xFF };
+				Write( bytes, 2 );
+			}
+
+			void Hash::Write32(const dword data)
+			{
+				const byte bytes[4] = { data & 0xFF, data >> 8 & 0xFF, data >> 16 & 0xFF, data >> 24 & 0xFF };
+				Write( bytes, 4 );
+			}
+
+			void Hash::Write64(const qaword data)
+			{
+				Write32( data & 0xFFFFFFFF );
+				Write32( data >> 32 );
+			}
+
+			qaword Hash::Digest() const
+			{
+				qaword digest;
+
+				if (length >= STRIPE)
+				{
+					digest = Rotate( lanes[0], 1 ) + Rotate( lanes[1], 7 ) + Rotate( lanes[2], 12 ) + Rotate( lanes[3], 18 );
+
+					for (uint i=0; i < 4; ++i)
+						digest = (digest ^ Round( 0, lanes[i] )) * HashPrime1() + HashPrime4();
+				}
+				else
+				{
+					digest = HashPrime5();
+				}
+
+				digest += length;
+
+				uint i = 0;
+
+				for (; i + 8 <= pending; i += 8)
+					digest = Rotate( digest ^ Round( 0, Read(buffer + i) ), 27 ) * HashPrime1() + HashPrime4();
+
+				if (i + 4 <= pending)
+				{
+					const dword word = buffer[i] | uint(buffer[i+1]) << 8 | dword(buffer[i+2]) << 16 | dword(buffer[i+3]) << 24;
+					digest = Rotate( digest ^ qaword(word) * HashPrime1(), 23 ) * HashPrime2() + HashPrime3();
+					i += 4;
+				}
+
+				for (; i < pending; ++i)
+					digest = Rotate( digest ^ qaword(buffer[i]) * HashPrime5(), 11 ) * HashPrime1();
+
+				digest ^= digest >> 33;
+				digest *= HashPrime2();
+				digest ^= digest >> 29;
+				digest *= HashPrime3();
+				digest ^= digest >> 32;
+
+				return digest;
+			}
+
+			void HashCache::Clear()
+			{
+				entries.Destroy();
+			}
+
+			void Reference::Add(const byte* const input,const dword length)
+			{
+				const Block block =
+				{
+					data.Size(),
+					length
+				};
+
+				blocks.Append( block );
+				data.Append( input, length );
+
+				for (uint i=0; i < 32; i += 8)
+					id = Crc32::Compute( length >> i & 0xFF, id );
+
+				id = Crc32::Compute( input, length, id );
+			}
+
+			void Batch::Add(const byte* const data,const dword length)
+			{
+				NST_ASSERT( !ready && length > 1 );
+
+				const Block block =
+				{
+					length,
+					input.Size(),
+					output.Size(),
+					0
+				};
+
+				blocks.Append( block );
+				input.Append( data, length );
+				output.Resize( output.Size() + length - 1 );
+			}
+
+			void NST_CALL Batch::Compress(void* const data,const uint i)
+			{
+				Batch& batch = *static_cast<Batch*>(data);
+				Block& block = batch.blocks[i];
+
+				block.size = Encode
+				(
+					batch.compression,
+					batch.input.Begin() + block.input,
+					block.length,
+					batch.output.Begin() + block.output,
+					block.length - 1
+				);
+			}
+
+			void Batch::Run()
+			{
+				NST_ASSERT( !ready );
+
+				Thread::Run( Compress, this, blocks.Size() );
+				ready = true;
+			}
+
+			const byte* Batch::Next(const byte* const data,const dword length,dword& size)
+			{
+				NST_ASSERT( ready );
+
+				// the save is expected to repeat the same sequence of blocks
+				// as when the batch was filled, but only this pass is written
+
+				if (next < blocks.Size())
+				{
+					const Block& block = blocks[next++];
+
+					if (block.length == length && std::memcmp( input.Begin() + block.input, data, length ) == 0)
+					{
+						size = block.size;
+						return size ? output.Begin() + block.output : NULL;
+					}
+				}
+
+				NST_DEBUG_MSG("state batch mismatch!");
+
+				return NULL;
+			}
+
 			Saver& Saver::Begin(dword chunk)
 			{
-				stream.Write32( chunk );
-				stream.Write32( 0 );
+				if (!detached)
+				{
+					stream.Write32( chunk );
+					stream.Write32( 0 );
+				}
+				else if (hash)
+				{
+					hash->Write32( chunk );
+				}
+
 				chunks.Append( 0 );
 
 				return *this;
@@ -82,45 +405,132 @@ namespace Nes
 				const dword written = chunks.Pop();
 				chunks.Back() += 4 + 4 + written;
 
-				stream.Seek( -idword(written + 4) );
-				stream.Write32( written );
-				stream.Seek( written );
+				if (!detached)
+				{
+					stream.Seek( -idword(written + 4) );
+					stream.Write32( written );
+					stream.Seek( written );
+				}
 
 				return *this;
 			}
 
+			dword Saver::Length() const
+			{
+				return chunks.Back();
+			}
+
 			Saver& Saver::Write8(uint data)
 			{
 				chunks.Back() += 1;
-				stream.Write8( data );
+
+				if (!detached)
+					stream.Write8( data );
+				else if (hash)
+					hash->Write8( data );
+
 				return *this;
 			}
 
 			Saver& Saver::Write16(uint data)
 			{
 				chunks.Back() += 2;
-				stream.Write16( data );
+
+				if (!detached)
+					stream.Write16( data );
+				else if (hash)
+					hash->Write16( data );
+
 				return *this;
 			}
 
 			Saver& Saver::Write32(dword data)
 			{
 				chunks.Back() += 4;
-				stream.Write32( data );
+
+				if (!detached)
+					stream.Write32( data );
+				else if (hash)
+					hash->Write32( data );
+
 				return *this;
 			}
 
 			Saver& Saver::Write64(qaword data)
 			{
 				chunks.Back() += 8;
-				stream.Write64( data );
+
+				if (!detached)
+					stream.Write64( data );
+				else if (hash)
+					hash->Write64( data );
+
 				return *this;
 			}
 
 			Saver& Saver::Write(const byte* data,dword length)
 			{
 				chunks.Back() += length;
+
+				if (!detached)
+					stream.Write( data, length );
+				else if (hash)
+					hash->Write( data, length );
+
+				return *this;
+			}
+
+			Saver& Saver::Store(const uint type,const byte* const data,const dword length)
+			{
+				chunks.Back() += 1 + length;
+				stream.Write8( type );
 				stream.Write( data, length );
+
+				return *this;
+			}
+
+			Saver& Saver::StoreDelta(const byte* const data,const dword length)
+			{
+				// pages that still match the reference are left out, a set bit
+				// in the map marks a page that follows in full
+
+				const dword index = blocks - 1;
+
+				if (index >= reference->blocks.Size() || reference->blocks[index].length != length)
+					return Store( NO_COMPRESSION, data, length );
+
+				const byte* const base = reference->data.Begin() + reference->blocks[index].offset;
+				const dword pages = Reference::NumPages( length );
+
+				Vector<byte> map( (pages + 7) / 8 );
+				std::memset( map.Begin(), 0, map.Size() );
+
+				dword changed = 0;
+
+				for (dword i=0, offset=0; i < pages; ++i, offset += Reference::PAGE_SIZE)
+				{
+					const dword size = NST_MIN(dword(Reference::PAGE_SIZE),length-offset);
+
+					if (std::memcmp( data + offset, base + offset, size ))
+					{
+						map[i >> 3] |= 1U << (i & 7);
+						changed += size;
+					}
+				}
+
+				chunks.Back() += 1 + 4 + 4 + map.Size() + changed;
+
+				stream.Write8( DELTA_COMPRESSION );
+				stream.Write32( reference->id );
+				stream.Write32( index );
+				stream.Write( map.Begin(), map.Size() );
+
+				for (dword i=0, offset=0; i < pages; ++i, offset += Reference::PAGE_SIZE)
+				{
+					if (map[i >> 3] & (1U << (i & 7)))
+						stream.Write( data + offset, NST_MIN(dword(Reference::PAGE_SIZE),length-offset) );
+				}
+
 				return *this;
 			}
 
@@ -128,22 +538,85 @@ namespace Nes
 			{
 				NST_VERIFY( length );
 
-				if (Zlib::AVAILABLE && useCompression && length > 1)
+				++blocks;
+
+				if (detached)
+				{
+					chunks.Back() += 1 + length;
+
+					if (hash)
+						hash->Write( data, length );
+					else if (compression != NO_COMPRESSION && length > 1)
+						batch->Add( data, length );
+
+					return *this;
+				}
+
+				if (reference)
 				{
-					Vector<byte> buffer( length - 1 );
+					if (compression == DELTA_COMPRESSION)
+						return StoreDelta( data, length );
 
-					if (const dword compressed = Zlib::Compress( data, length, buffer.Begin(), buffer.Size(), Zlib::BEST_COMPRESSION ))
+					reference->Add( data, length );
+				}
+
+				if (compression != NO_COMPRESSION && length > 1)
+				{
+					if (!batch)
 					{
-						chunks.Back() += 1 + compressed;
-						stream.Write8( ZLIB_COMPRESSION );
-						stream.Write( buffer.Begin(), compressed );
-						return *this;
+						Vector<byte> buffer( length - 1 );
+
+						if (const dword compressed = Encode( compression, data, length, buffer.Begin(), buffer.Size() ))
+							return Store( compression, buffer.Begin(), compressed );
+					}
+					else
+					{
+						dword compressed;
+
+						if (const byte* const buffer = batch->Next( data, length, compressed ))
+							return Store( compression, buffer, compressed );
 					}
 				}
 
+				return Store( NO_COMPRESSION, data, length );
+			}
+
+			Saver& Saver::Compress(const byte* const data,const dword length,const dword writes)
+			{
+				if (!hashCache)
+					return Compress( data, length );
+
+				NST_VERIFY( length );
+
+				// the caller counts every write to the block, so while the count
+				// stays put the digest taken by the previous hash still holds
+
+				const dword index = blocks++;
 				chunks.Back() += 1 + length;
-				stream.Write8( NO_COMPRESSION );
-				stream.Write( data, length );
+
+				if (index >= hashCache->entries.Size())
+				{
+					const dword size = hashCache->entries.Size();
+					hashCache->entries.Resize( index + 1 );
+
+					for (dword i=size; i <= index; ++i)
+						hashCache->entries[i].data = NULL;
+				}
+
+				HashCache::Entry& entry = hashCache->entries[index];
+
+				if (entry.data != data || entry.length != length || entry.writes != writes)
+				{
+					Hash block;
+					block.Write( data, length );
+
+					entry.data = data;
+					entry.length = length;
+					entry.writes = writes;
+					entry.digest = block.Digest();
+				}
+
+				hash->Write64( entry.digest );
 
 				return *this;
 			}
@@ -152,8 +625,8 @@ namespace Nes
 			#pragma optimize("s", on)
 			#endif
 
-			Loader::Loader(StdStream p,bool c)
-			: stream(p), chunks(CHUNK_RESERVE), checkCrc(c)
+			Loader::Loader(StdStream p,bool c,const Reference* r)
+			: stream(p), chunks(CHUNK_RESERVE), checkCrc(c), reference(r)
 			{
 				chunks.SetTo(0);
 			}
@@ -213,6 +686,17 @@ namespace Nes
 					stream.Seek( back );
 			}
 
+			void Loader::Seek(const idword offset)
+			{
+				NST_ASSERT( chunks.Size() );
+
+				if (offset > 0 && chunks.Back() < dword(offset))
+					throw RESULT_ERR_CORRUPT_FILE;
+
+				chunks.Back() -= offset;
+				stream.Seek( offset );
+			}
+
 			void Loader::CheckRead(dword length)
 			{
 				if (chunks.Back() >= length)
@@ -262,6 +746,44 @@ namespace Nes
 						Read( data, length );
 						break;
 
+					case LZ_COMPRESSION:
+
+						if (chunks.Back())
+						{
+							Vector<byte> buffer( chunks.Back() );
+							Read( buffer.Begin(), buffer.Size() );
+
+							if (Lz::Uncompress( buffer.Begin(), buffer.Size(), data, length ) == length)
+								break;
+						}
+
+						throw RESULT_ERR_CORRUPT_FILE;
+
+					case DELTA_COMPRESSION:
+					{
+						const dword id = Read32();
+						const dword index = Read32();
+
+						// the state was saved against a reference this machine doesn't hold
+
+						if (!reference || reference->Empty() || reference->id != id || index >= reference->blocks.Size() || reference->blocks[index].length != length)
+							throw RESULT_ERR_INVALID_CRC;
+
+						std::memcpy( data, reference->data.Begin() + reference->blocks[index].offset, length );
+
+						const dword pages = Reference::NumPages( length );
+						Vector<byte> map( (pages + 7) / 8 );
+						Read( map.Begin(), map.Size() );
+
+						for (dword i=0, offset=0; i < pages; ++i, offset += Reference::PAGE_SIZE)
+						{
+							if (map[i >> 3] & (1U << (i & 7)))
+								Read( data + offset, NST_MIN(dword(Reference::PAGE_SIZE),length-offset) );
+						}
+
+						break;
+					}
+
 					case ZLIB_COMPRESSION:
 
 						if (!Zlib::AVAILABLE)
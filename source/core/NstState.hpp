@@ -41,11 +41,152 @@ namespace Nes
 	{
 		namespace State
 		{
+			enum Compression
+			{
+				NO_COMPRESSION,
+				ZLIB_COMPRESSION,
+				LZ_COMPRESSION,
+				DELTA_COMPRESSION
+			};
+
+			class Reference
+			{
+			public:
+
+				Reference();
+
+				void Clear();
+
+			private:
+
+				friend class Saver;
+				friend class Loader;
+
+				enum
+				{
+					PAGE_SHIFT = 6,
+					PAGE_SIZE = 1U << PAGE_SHIFT
+				};
+
+				struct Block
+				{
+					dword offset;
+					dword length;
+				};
+
+				void Add(const byte*,dword);
+
+				static dword NumPages(dword length)
+				{
+					return (length + (PAGE_SIZE-1)) >> PAGE_SHIFT;
+				}
+
+				Vector<Block> blocks;
+				Vector<byte> data;
+				dword id;
+
+			public:
+
+				bool Empty() const
+				{
+					return !blocks.Size();
+				}
+			};
+
+			class Batch
+			{
+			public:
+
+				explicit Batch(uint);
+
+				void Run();
+
+			private:
+
+				friend class Saver;
+
+				struct Block
+				{
+					dword length;
+					dword input;
+					dword output;
+					dword size;
+				};
+
+				void Add(const byte*,dword);
+				const byte* Next(const byte*,dword,dword&);
+
+				static void NST_CALL Compress(void*,uint);
+
+				const uint compression;
+				bool ready;
+				dword next;
+				Vector<Block> blocks;
+				Vector<byte> input;
+				Vector<byte> output;
+			};
+
+			class Hash
+			{
+			public:
+
+				Hash();
+
+				void Write(const byte*,dword);
+				void Write8(uint);
+				void Write16(uint);
+				void Write32(dword);
+				void Write64(qaword);
+
+				qaword Digest() const;
+
+			private:
+
+				enum
+				{
+					STRIPE = 32
+				};
+
+				static inline qaword Rotate(qaword,uint);
+				static inline qaword Read(const byte*);
+				static inline qaword Round(qaword,qaword);
+
+				void Consume(const byte*);
+
+				qaword lanes[4];
+				qaword length;
+				uint pending;
+				byte buffer[STRIPE];
+			};
+
+			class HashCache
+			{
+			public:
+
+				void Clear();
+
+			private:
+
+				friend class Saver;
+
+				struct Entry
+				{
+					const byte* data;
+					dword length;
+					dword writes;
+					qaword digest;
+				};
+
+				Vector<Entry> entries;
+			};
+
 			class Saver
 			{
 			public:
 
-				Saver(StdStream,bool,bool,dword=0);
+				Saver(StdStream,uint,bool,dword=0,Batch* =NULL,Reference* =NULL);
+				explicit Saver(Batch&);
+				Saver(Hash&,HashCache&);
 				~Saver();
 
 				Saver& Begin(dword);
@@ -55,7 +196,9 @@ namespace Nes
 				Saver& Write64(qaword);
 				Saver& Write(const byte*,dword);
 				Saver& Compress(const byte*,dword);
+				Saver& Compress(const byte*,dword,dword);
 				Saver& End();
+				dword  Length() const;
 
 			protected:
 
@@ -63,14 +206,23 @@ namespace Nes
 
 			private:
 
+				Saver& Store(uint,const byte*,dword);
+				Saver& StoreDelta(const byte*,dword);
+
 				enum
 				{
 					CHUNK_RESERVE = 8
 				};
 
 				Vector<dword> chunks;
-				const bool useCompression;
+				const uint compression;
 				const bool internal;
+				Batch* const batch;
+				Reference* const reference;
+				Hash* const hash;
+				HashCache* const hashCache;
+				const bool detached;
+				dword blocks;
 
 			public:
 
@@ -98,7 +250,7 @@ namespace Nes
 			{
 			public:
 
-				Loader(StdStream,bool);
+				Loader(StdStream,bool,const Reference* =NULL);
 				~Loader();
 
 				dword Begin();
@@ -110,6 +262,7 @@ namespace Nes
 				qaword Read64();
 				void  Read(byte*,dword);
 				void  Uncompress(byte*,dword);
+				void  Seek(idword);
 				void  End();
 				void  End(dword);
 
@@ -155,6 +308,7 @@ namespace Nes
 
 				Vector<dword> chunks;
 				const bool checkCrc;
+				const Reference* const reference;
 
 			public:
 
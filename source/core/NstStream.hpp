@@ -109,6 +109,9 @@ namespace Nes
 					NST_ASSERT( stream );
 				}
 
+				Out()
+				: stream(NULL) {}
+
 				void Write(const byte*,dword);
 				void Write8(uint);
 				void Write16(uint);
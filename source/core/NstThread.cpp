@@ -0,0 +1,722 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "NstAssert.hpp"
+#include "NstThread.hpp"
+
+#ifndef NST_NO_THREADS
+
+ #ifdef NST_WIN32
+
+  #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+  #endif
+
+  #include <windows.h>
+  #include <process.h>
+
+ #else
+
+  #include <pthread.h>
+  #include <unistd.h>
+
+ #endif
+
+#endif
+
+namespace Nes
+{
+	namespace Core
+	{
+		namespace Thread
+		{
+			enum
+			{
+				MAX_THREADS = 16
+			};
+
+			struct Work
+			{
+				Job job;
+				void* data;
+				uint first;
+				uint step;
+				uint count;
+
+				void Execute() const
+				{
+					for (uint i=first; i < count; i += step)
+						job( data, i );
+				}
+			};
+
+		#ifndef NST_NO_THREADS
+
+		 #ifdef NST_WIN32
+
+			static unsigned __stdcall Entry(void* work)
+			{
+				static_cast<const Work*>(work)->Execute();
+				return 0;
+			}
+
+			uint NST_CALL Concurrency()
+			{
+				SYSTEM_INFO info;
+				::GetSystemInfo( &info );
+
+				return info.dwNumberOfProcessors > 1 ? info.dwNumberOfProcessors : 1;
+			}
+
+		 #else
+
+			static void* Entry(void* work)
+			{
+				static_cast<const Work*>(work)->Execute();
+				return NULL;
+			}
+
+			uint NST_CALL Concurrency()
+			{
+				const long count = ::sysconf( _SC_NPROCESSORS_ONLN );
+				return count > 1 ? count : 1;
+			}
+
+		 #endif
+
+			void NST_CALL Run(const Job job,void* const data,const uint count)
+			{
+				NST_ASSERT( job );
+
+				uint threads = Concurrency();
+
+				if (threads > count)
+					threads = count;
+
+				if (threads > MAX_THREADS)
+					threads = MAX_THREADS;
+
+				Work work[MAX_THREADS];
+
+			 #ifdef NST_WIN32
+				HANDLE handles[MAX_THREADS];
+			 #else
+				pthread_t handles[MAX_THREADS];
+			 #endif
+
+				bool started[MAX_THREADS];
+
+				for (uint i=0; i < threads; ++i)
+				{
+					work[i].job = job;
+					work[i].data = data;
+					work[i].first = i;
+					work[i].step = threads;
+					work[i].count = count;
+				}
+
+				// the calling thread takes the first share and any share
+				// whose thread couldn't be created
+
+				for (uint i=1; i < threads; ++i)
+				{
+				 #ifdef NST_WIN32
+					handles[i] = reinterpret_cast<HANDLE>(::_beginthreadex( NULL, 0, Entry, work+i, 0, NULL ));
+					started[i] = (handles[i] != NULL);
+				 #else
+					started[i] = (::pthread_create( handles+i, NULL, Entry, work+i ) == 0);
+				 #endif
+				}
+
+				if (threads)
+					work[0].Execute();
+
+				for (uint i=1; i < threads; ++i)
+				{
+					if (started[i])
+					{
+					 #ifdef NST_WIN32
+						::WaitForSingleObject( handles[i], INFINITE );
+						::CloseHandle( handles[i] );
+					 #else
+						::pthread_join( handles[i], NULL );
+					 #endif
+					}
+					else
+					{
+						work[i].Execute();
+					}
+				}
+			}
+
+			// Persistent workers for callers running many small batches. Jobs
+			// are handed out one index at a time so uneven work still spreads
+			// over all threads, and the calling thread joins in as well.
+
+			struct Pool::Impl
+			{
+				explicit Impl(uint);
+				~Impl();
+
+				void Run(Job,void*,uint);
+
+				Job job;
+				void* data;
+				uint count;
+				uint threads;
+				bool quit;
+
+			 #ifdef NST_WIN32
+
+				static unsigned __stdcall Entry(void*);
+				void Claim();
+
+				volatile LONG next;
+				volatile LONG busy;
+				HANDLE start;
+				HANDLE done;
+				HANDLE handles[MAX_THREADS];
+
+			 #else
+
+				static void* Entry(void*);
+				void Claim();
+
+				uint next;
+				uint busy;
+				dword round;
+				pthread_mutex_t mutex;
+				pthread_cond_t start;
+				pthread_cond_t done;
+				pthread_t handles[MAX_THREADS];
+
+			 #endif
+			};
+
+		 #ifdef NST_WIN32
+
+			Pool::Impl::Impl(uint size)
+			:
+			job     (NULL),
+			data    (NULL),
+			count   (0),
+			threads (0),
+			quit    (false),
+			next    (0),
+			busy    (0),
+			start   (::CreateSemaphore( NULL, 0, MAX_THREADS, NULL )),
+			done    (::CreateEvent( NULL, FALSE, FALSE, NULL ))
+			{
+				if (!size)
+					size = Concurrency();
+
+				if (size > MAX_THREADS)
+					size = MAX_THREADS;
+
+				if (start && done)
+				{
+					for (uint i=1; i < size; ++i)
+					{
+						if (HANDLE const handle = reinterpret_cast<HANDLE>(::_beginthreadex( NULL, 0, Entry, this, 0, NULL )))
+							handles[threads++] = handle;
+					}
+				}
+			}
+
+			Pool::Impl::~Impl()
+			{
+				if (threads)
+				{
+					quit = true;
+					::ReleaseSemaphore( start, threads, NULL );
+
+					for (uint i=0; i < threads; ++i)
+					{
+						::WaitForSingleObject( handles[i], INFINITE );
+						::CloseHandle( handles[i] );
+					}
+				}
+
+				if (done)
+					::CloseHandle( done );
+
+				if (start)
+					::CloseHandle( start );
+			}
+
+			void Pool::Impl::Claim()
+			{
+				for (LONG i; (i = ::InterlockedIncrement( &next ) - 1) < LONG(count); )
+					job( data, i );
+			}
+
+			unsigned __stdcall Pool::Impl::Entry(void* p)
+			{
+				Impl& impl = *static_cast<Impl*>(p);
+
+				for (;;)
+				{
+					::WaitForSingleObject( impl.start, INFINITE );
+
+					if (impl.quit)
+						break;
+
+					impl.Claim();
+
+					if (!::InterlockedDecrement( &impl.busy ))
+						::SetEvent( impl.done );
+				}
+
+				return 0;
+			}
+
+			void Pool::Impl::Run(const Job j,void* const d,const uint c)
+			{
+				job = j;
+				data = d;
+				count = c;
+				next = 0;
+				busy = threads;
+
+				if (threads)
+					::ReleaseSemaphore( start, threads, NULL );
+
+				Claim();
+
+				if (threads)
+					::WaitForSingleObject( done, INFINITE );
+			}
+
+		 #else
+
+			Pool::Impl::Impl(uint size)
+			:
+			job     (NULL),
+			data    (NULL),
+			count   (0),
+			threads (0),
+			quit    (false),
+			next    (0),
+			busy    (0),
+			round   (0)
+			{
+				::pthread_mutex_init( &mutex, NULL );
+				::pthread_cond_init( &start, NULL );
+				::pthread_cond_init( &done, NULL );
+
+				if (!size)
+					size = Concurrency();
+
+				if (size > MAX_THREADS)
+					size = MAX_THREADS;
+
+				for (uint i=1; i < size; ++i)
+				{
+					if (::pthread_create( handles+threads, NULL, Entry, this ) == 0)
+						++threads;
+				}
+			}
+
+			Pool::Impl::~Impl()
+			{
+				::pthread_mutex_lock( &mutex );
+				quit = true;
+				::pthread_cond_broadcast( &start );
+				::pthread_mutex_unlock( &mutex );
+
+				for (uint i=0; i < threads; ++i)
+					::pthread_join( handles[i], NULL );
+
+				::pthread_cond_destroy( &done );
+				::pthread_cond_destroy( &start );
+				::pthread_mutex_destroy( &mutex );
+			}
+
+			void Pool::Impl::Claim()
+			{
+				// called and returns with the mutex locked
+
+				while (next < count)
+				{
+					const uint i = next++;
+
+					::pthread_mutex_unlock( &mutex );
+					job( data, i );
+					::pthread_mutex_lock( &mutex );
+				}
+			}
+
+			void* Pool::Impl::Entry(void* p)
+			{
+				Impl& impl = *static_cast<Impl*>(p);
+
+				// every worker has taken part in all rounds before the
+				// current one, so counting from zero is always in step
+
+				dword seen = 0;
+
+				::pthread_mutex_lock( &impl.mutex );
+
+				for (;;)
+				{
+					while (impl.round == seen && !impl.quit)
+						::pthread_cond_wait( &impl.start, &impl.mutex );
+
+					if (impl.quit)
+						break;
+
+					seen = impl.round;
+					impl.Claim();
+
+					if (!--impl.busy)
+						::pthread_cond_signal( &impl.done );
+				}
+
+				::pthread_mutex_unlock( &impl.mutex );
+
+				return NULL;
+			}
+
+			void Pool::Impl::Run(const Job j,void* const d,const uint c)
+			{
+				::pthread_mutex_lock( &mutex );
+
+				job = j;
+				data = d;
+				count = c;
+				next = 0;
+				busy = threads;
+				round++;
+
+				::pthread_cond_broadcast( &start );
+
+				Claim();
+
+				while (busy)
+					::pthread_cond_wait( &done, &mutex );
+
+				::pthread_mutex_unlock( &mutex );
+			}
+
+		 #endif
+
+			Pool::Pool(uint size)
+			: impl(new Impl(size)) {}
+
+			Pool::~Pool()
+			{
+				delete impl;
+			}
+
+			void Pool::Run(const Job job,void* const data,const uint count)
+			{
+				NST_ASSERT( job );
+				impl->Run( job, data, count );
+			}
+
+			uint Pool::Size() const
+			{
+				return impl->threads + 1;
+			}
+
+		 #ifdef NST_WIN32
+
+			struct Signal::Impl
+			{
+				Impl()
+				: value(0), event(::CreateEvent( NULL, FALSE, FALSE, NULL )) {}
+
+				~Impl()
+				{
+					if (event)
+						::CloseHandle( event );
+				}
+
+				volatile LONG value;
+				const HANDLE event;
+			};
+
+			void Signal::Set(const dword value)
+			{
+				::InterlockedExchange( &impl->value, LONG(value) );
+				::SetEvent( impl->event );
+			}
+
+			dword Signal::Get() const
+			{
+				return dword(::InterlockedCompareExchange( &impl->value, 0, 0 ));
+			}
+
+			dword Signal::Wait(const dword past) const
+			{
+				for (;;)
+				{
+					const dword value = Get();
+
+					if (value != past)
+						return value;
+
+					::WaitForSingleObject( impl->event, INFINITE );
+				}
+			}
+
+			struct Task::Impl
+			{
+				static unsigned __stdcall Entry(void*);
+
+				Job job;
+				void* data;
+				HANDLE handle;
+			};
+
+			unsigned __stdcall Task::Impl::Entry(void* p)
+			{
+				Impl& impl = *static_cast<Impl*>(p);
+				impl.job( impl.data, 0 );
+				return 0;
+			}
+
+			bool Task::Start(const Job job,void* const data)
+			{
+				NST_ASSERT( job && !impl->handle );
+
+				impl->job = job;
+				impl->data = data;
+				impl->handle = reinterpret_cast<HANDLE>(::_beginthreadex( NULL, 0, Impl::Entry, impl, 0, NULL ));
+
+				return impl->handle != NULL;
+			}
+
+			void Task::Join()
+			{
+				if (impl->handle)
+				{
+					::WaitForSingleObject( impl->handle, INFINITE );
+					::CloseHandle( impl->handle );
+					impl->handle = NULL;
+				}
+			}
+
+		 #else
+
+			struct Signal::Impl
+			{
+				Impl()
+				: value(0)
+				{
+					::pthread_mutex_init( &mutex, NULL );
+					::pthread_cond_init( &cond, NULL );
+				}
+
+				~Impl()
+				{
+					::pthread_cond_destroy( &cond );
+					::pthread_mutex_destroy( &mutex );
+				}
+
+				dword value;
+				pthread_mutex_t mutex;
+				pthread_cond_t cond;
+			};
+
+			void Signal::Set(const dword value)
+			{
+				::pthread_mutex_lock( &impl->mutex );
+				impl->value = value;
+				::pthread_cond_signal( &impl->cond );
+				::pthread_mutex_unlock( &impl->mutex );
+			}
+
+			dword Signal::Get() const
+			{
+				::pthread_mutex_lock( &impl->mutex );
+				const dword value = impl->value;
+				::pthread_mutex_unlock( &impl->mutex );
+
+				return value;
+			}
+
+			dword Signal::Wait(const dword past) const
+			{
+				::pthread_mutex_lock( &impl->mutex );
+
+				while (impl->value == past)
+					::pthread_cond_wait( &impl->cond, &impl->mutex );
+
+				const dword value = impl->value;
+				::pthread_mutex_unlock( &impl->mutex );
+
+				return value;
+			}
+
+			struct Task::Impl
+			{
+				static void* Entry(void*);
+
+				Job job;
+				void* data;
+				pthread_t handle;
+				bool running;
+			};
+
+			void* Task::Impl::Entry(void* p)
+			{
+				Impl& impl = *static_cast<Impl*>(p);
+				impl.job( impl.data, 0 );
+				return NULL;
+			}
+
+			bool Task::Start(const Job job,void* const data)
+			{
+				NST_ASSERT( job && !impl->running );
+
+				impl->job = job;
+				impl->data = data;
+				impl->running = (::pthread_create( &impl->handle, NULL, Impl::Entry, impl ) == 0);
+
+				return impl->running;
+			}
+
+			void Task::Join()
+			{
+				if (impl->running)
+				{
+					::pthread_join( impl->handle, NULL );
+					impl->running = false;
+				}
+			}
+
+		 #endif
+
+			Signal::Signal()
+			: impl(new Impl) {}
+
+			Signal::~Signal()
+			{
+				delete impl;
+			}
+
+			Task::Task()
+			: impl(new Impl)
+			{
+			 #ifdef NST_WIN32
+				impl->handle = NULL;
+			 #else
+				impl->running = false;
+			 #endif
+			}
+
+			Task::~Task()
+			{
+				Join();
+				delete impl;
+			}
+
+		#else
+
+			uint NST_CALL Concurrency()
+			{
+				return 1;
+			}
+
+			void NST_CALL Run(const Job job,void* const data,const uint count)
+			{
+				NST_ASSERT( job );
+
+				const Work work = {job,data,0,1,count};
+				work.Execute();
+			}
+
+			struct Pool::Impl {};
+
+			Pool::Pool(uint)
+			: impl(NULL) {}
+
+			Pool::~Pool()
+			{
+			}
+
+			void Pool::Run(const Job job,void* const data,const uint count)
+			{
+				Thread::Run( job, data, count );
+			}
+
+			uint Pool::Size() const
+			{
+				return 1;
+			}
+
+			struct Signal::Impl
+			{
+				dword value;
+			};
+
+			Signal::Signal()
+			: impl(new Impl)
+			{
+				impl->value = 0;
+			}
+
+			Signal::~Signal()
+			{
+				delete impl;
+			}
+
+			void Signal::Set(const dword value)
+			{
+				impl->value = value;
+			}
+
+			dword Signal::Get() const
+			{
+				return impl->value;
+			}
+
+			dword Signal::Wait(dword) const
+			{
+				return impl->value;
+			}
+
+			struct Task::Impl {};
+
+			Task::Task()
+			: impl(NULL) {}
+
+			Task::~Task()
+			{
+			}
+
+			bool Task::Start(Job,void*)
+			{
+				return false;
+			}
+
+			void Task::Join()
+			{
+			}
+
+		#endif
+		}
+	}
+}
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_THREAD_H
+#define NST_THREAD_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+namespace Nes
+{
+	namespace Core
+	{
+		namespace Thread
+		{
+			enum
+			{
+			#ifndef NST_NO_THREADS
+				AVAILABLE = 1
+			#else
+				AVAILABLE = 0
+			#endif
+			};
+
+			typedef void (NST_CALL *Job)(void*,uint);
+
+			uint NST_CALL Concurrency();
+			void NST_CALL Run(Job,void*,uint);
+
+			class Pool
+			{
+			public:
+
+				explicit Pool(uint=0);
+				~Pool();
+
+				void Run(Job,void*,uint);
+				uint Size() const;
+
+			private:
+
+				struct Impl;
+				Impl* const impl;
+			};
+
+			// Counter set by one thread and waited on by another. Anything
+			// written before Set() is visible to the waiter once Wait() returns.
+
+			class Signal
+			{
+			public:
+
+				Signal();
+				~Signal();
+
+				void Set(dword);
+				dword Get() const;
+				dword Wait(dword) const;
+
+			private:
+
+				struct Impl;
+				Impl* const impl;
+			};
+
+			// Single background thread running one job until it returns.
+
+			class Task
+			{
+			public:
+
+				Task();
+				~Task();
+
+				bool Start(Job,void*);
+				void Join();
+
+			private:
+
+				struct Impl;
+				Impl* const impl;
+			};
+		}
+	}
+}
+
+#endif
@@ -207,7 +207,7 @@ namespace Nes
 			return result;
 		}
 
-		Result Tracker::RecordMovie(Machine& emulator,std::iostream& stream,const bool append)
+		Result Tracker::RecordMovie(Machine& emulator,std::iostream& stream,const bool append,const dword interval)
 		{
 			if (!emulator.Is(Api::Machine::GAME))
 				return RESULT_ERR_NOT_READY;
@@ -230,7 +230,44 @@ namespace Nes
 					);
 				}
 
-				return movie->Record( stream, append ) ? RESULT_OK : RESULT_NOP;
+				return movie->Record( stream, append, interval ) ? RESULT_OK : RESULT_NOP;
+			}
+			catch (Result r)
+			{
+				result = r;
+			}
+			catch (const std::bad_alloc&)
+			{
+				result = RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				result = RESULT_ERR_GENERIC;
+			}
+
+			StopMovie();
+
+			return result;
+		}
+
+		Result Tracker::SeekMovie(Machine& emulator,const dword frame)
+		{
+			if (!emulator.Is(Api::Machine::ON) || !IsMoviePlaying())
+				return RESULT_ERR_NOT_READY;
+
+			Result result;
+
+			try
+			{
+				dword skip;
+
+				if (!movie->Seek( frame, skip ))
+					return RESULT_ERR_INVALID_PARAM;
+
+				for (result = RESULT_OK; skip && NES_SUCCEEDED(result); --skip)
+					result = Execute( emulator, NULL, NULL, NULL );
+
+				return result;
 			}
 			catch (Result r)
 			{
@@ -74,7 +74,8 @@ namespace Nes
 			bool   IsRewinding() const;
 
 			Result PlayMovie(Machine&,std::istream&);
-			Result RecordMovie(Machine&,std::iostream&,bool);
+			Result RecordMovie(Machine&,std::iostream&,bool,dword);
+			Result SeekMovie(Machine&,dword);
 			void   StopMovie();
 			bool   IsMoviePlaying() const;
 			bool   IsMovieRecording() const;
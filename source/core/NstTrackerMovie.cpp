@@ -25,9 +25,11 @@
 #include <new>
 #include <iostream>
 #include "NstMachine.hpp"
+#include "NstFds.hpp"
 #include "NstState.hpp"
 #include "NstTrackerMovie.hpp"
 #include "NstZlib.hpp"
+#include "api/NstApiMachine.hpp"
 #include "api/NstApiMovie.hpp"
 #include "api/NstApiUser.hpp"
 
@@ -39,6 +41,145 @@ namespace Nes
 		#pragma optimize("s", on)
 		#endif
 
+		struct Tracker::Movie::Index
+		{
+			struct Entry
+			{
+				dword frame;
+				dword offset;
+			};
+
+			Vector<Entry> entries;
+			dword frames;
+
+			Index()
+			: frames(0) {}
+
+			void Add(dword,dword);
+			void Scan(State::Loader&,dword);
+			bool Load(State::Loader&,dword);
+			void Save(State::Saver&) const;
+			const Entry* Find(dword) const;
+		};
+
+		void Tracker::Movie::Index::Add(const dword frame,const dword offset)
+		{
+			const Entry entry = { frame, offset };
+			entries.Append( entry );
+		}
+
+		void Tracker::Movie::Index::Scan(State::Loader& state,const dword length)
+		{
+			entries.Clear();
+			frames = 0;
+
+			for (;;)
+			{
+				const dword offset = length - state.Length();
+				const dword chunk = state.Begin();
+
+				if (!chunk)
+					break;
+
+				if (chunk == AsciiId<'K','E','Y'>::V)
+				{
+					bool key = false;
+					dword count = 0;
+
+					while (const dword subChunk = state.Begin())
+					{
+						if (subChunk == AsciiId<'S','A','V'>::V)
+							key = true;
+						else if (subChunk == AsciiId<'L','E','N'>::V)
+							count = state.Read32();
+
+						state.End();
+					}
+
+					if (key)
+						Add( frames, offset );
+
+					frames += count + 1;
+				}
+
+				state.End();
+			}
+		}
+
+		bool Tracker::Movie::Index::Load(State::Loader& state,const dword length)
+		{
+			entries.Clear();
+			frames = 0;
+
+			const dword remaining = state.Length();
+
+			if (remaining < 4+4+4+4)
+				return false;
+
+			state.Seek( remaining - (4+4) );
+
+			const dword total = state.Read32();
+			const dword count = state.Read32();
+
+			if (!count || count > (remaining - (4+4+4+4)) / 8)
+				return false;
+
+			state.Seek( -idword(4+4 + count * 8 + 4+4) );
+
+			if (state.Read32() != AsciiId<'I','D','X'>::V || state.Read32() != count * 8 + 4+4)
+				return false;
+
+			entries.Resize( count );
+
+			for (dword i=0; i < count; ++i)
+			{
+				entries[i].frame = state.Read32();
+				entries[i].offset = state.Read32();
+
+				if (entries[i].frame >= total || entries[i].offset >= length || (i && entries[i].frame <= entries[i-1].frame))
+				{
+					entries.Clear();
+					return false;
+				}
+			}
+
+			frames = total;
+
+			return true;
+		}
+
+		void Tracker::Movie::Index::Save(State::Saver& state) const
+		{
+			state.Begin( AsciiId<'I','D','X'>::V );
+
+			for (const Entry* it=entries.Begin(), *const end=entries.End(); it != end; ++it)
+				state.Write32( it->frame ).Write32( it->offset );
+
+			state.Write32( frames ).Write32( entries.Size() ).End();
+		}
+
+		const Tracker::Movie::Index::Entry* Tracker::Movie::Index::Find(const dword frame) const
+		{
+			const Entry* it = entries.Begin();
+
+			for (dword count=entries.Size(); count; )
+			{
+				const dword half = count / 2;
+
+				if (it[half].frame <= frame)
+				{
+					it += half + 1;
+					count -= half + 1;
+				}
+				else
+				{
+					count = half;
+				}
+			}
+
+			return it != entries.Begin() ? it - 1 : NULL;
+		}
+
 		class Tracker::Movie::Player
 		{
 		public:
@@ -49,7 +190,7 @@ namespace Nes
 
 		private:
 
-			static dword Validate(State::Loader&,const Cpu&,dword,bool);
+			static dword Validate(State::Loader&,const Cpu&,dword,Fds*,bool);
 
 			enum
 			{
@@ -79,24 +220,48 @@ namespace Nes
 			NES_DECL_PEEK( Port );
 			NES_DECL_POKE( Port );
 
+			dword Offset() const
+			{
+				return length - state.Length();
+			}
+
+			void LoadIndex();
+
 			const Io::Port* ports[2];
 			dword frame;
 			Buffer buffers[2];
 			Loader state;
+			const dword length;
+			const dword start;
+			dword position;
+			ibool indexed;
+			Index index;
 			Cpu& cpu;
 
 		public:
 
-			static dword Validate(std::istream& stream,const Cpu& cpu,dword prgCrc)
+			static dword Validate(std::istream& stream,const Cpu& cpu,dword prgCrc,Fds* fds,Index& index)
 			{
 				Loader state( stream );
-				return Validate( state, cpu, prgCrc, true );
+
+				const dword length = Validate( state, cpu, prgCrc, fds, false );
+
+				index.Scan( state, length );
+				state.End( length );
+
+				return length;
 			}
 
-			Player(std::istream& stream,Cpu& c,const dword prgCrc)
-			: frame(0), state(stream), cpu(c)
+			Player(std::istream& stream,Cpu& c,const dword prgCrc,Fds* const fds)
+			:
+			frame    (0),
+			state    (stream),
+			length   (Validate(state,c,prgCrc,fds,false)),
+			start    (Offset()),
+			position (0),
+			indexed  (false),
+			cpu      (c)
 			{
-				Validate( state, cpu, prgCrc, false );
 				Relink();
 			}
 
@@ -110,6 +275,41 @@ namespace Nes
 				state.End();
 			}
 
+			bool Seek(const dword target,dword& skip)
+			{
+				if (!indexed)
+				{
+					LoadIndex();
+					indexed = true;
+				}
+
+				if (target >= index.frames)
+					return false;
+
+				const Index::Entry* const entry = index.Find( target );
+
+				if (!entry)
+					throw RESULT_ERR_CORRUPT_FILE;
+
+				if (position > target || position < entry->frame)
+				{
+					state.Seek( idword(entry->offset) - idword(Offset()) );
+
+					for (uint i=0; i < 2; ++i)
+					{
+						buffers[i].pos = 0;
+						buffers[i].Clear();
+					}
+
+					frame = 0;
+					position = entry->frame;
+				}
+
+				skip = target - position;
+
+				return true;
+			}
+
 			bool Execute(Machine& emulator,EmuLoadState loadState)
 			{
 				NST_ASSERT( loadState );
@@ -177,6 +377,8 @@ namespace Nes
 					}
 				}
 
+				++position;
+
 				return true;
 			}
 		};
@@ -187,7 +389,7 @@ namespace Nes
 				cpu.Unlink( 0x4016 + i, this, &Player::Peek_Port, &Player::Poke_Port );
 		}
 
-		dword Tracker::Movie::Player::Validate(State::Loader& state,const Cpu& cpu,const dword prgCrc,const bool end)
+		dword Tracker::Movie::Player::Validate(State::Loader& state,const Cpu& cpu,const dword prgCrc,Fds* const fds,const bool end)
 		{
 			if (state.Begin() != (AsciiId<'N','S','V'>::V | 0x1AUL << 24))
 				throw RESULT_ERR_INVALID_FILE;
@@ -196,6 +398,7 @@ namespace Nes
 
 			Region region = REGION_NTSC;
 			dword crc = 0;
+			bool fastLoad = false;
 
 			while (const dword chunk = state.Check())
 			{
@@ -211,6 +414,12 @@ namespace Nes
 					crc = state.Read32();
 					state.End();
 				}
+				else if (chunk == AsciiId<'F','D','L'>::V)
+				{
+					state.Begin();
+					fastLoad = true;
+					state.End();
+				}
 				else if (chunk & 0xFFFFFF00)
 				{
 					break;
@@ -230,9 +439,27 @@ namespace Nes
 			if (crc && prgCrc && crc != prgCrc && Api::User::questionCallback( Api::User::QUESTION_NSV_PRG_CRC_FAIL_CONTINUE ) == Api::User::ANSWER_NO)
 				throw RESULT_ERR_INVALID_CRC;
 
+			// the disk runs in the fast-load mode the movie was made with
+
+			if (fds)
+				fds->SetFastLoad( fastLoad );
+
 			return length;
 		}
 
+		void Tracker::Movie::Player::LoadIndex()
+		{
+			const dword offset = Offset();
+
+			if (!index.Load( state, length ))
+			{
+				state.Seek( idword(start) - idword(Offset()) );
+				index.Scan( state, length );
+			}
+
+			state.Seek( idword(offset) - idword(Offset()) );
+		}
+
 		void Tracker::Movie::Player::Relink()
 		{
 			for (uint i=0; i < 2; ++i)
@@ -292,7 +519,7 @@ namespace Nes
 			struct Saver : State::Saver
 			{
 				Saver(std::ostream& s,dword a)
-				: State::Saver(&s,true,true,a) {}
+				: State::Saver(&s,State::ZLIB_COMPRESSION,true,a) {}
 
 				bool operator == (std::ostream& s) const
 				{
@@ -306,14 +533,23 @@ namespace Nes
 			const Io::Port* ports[2];
 			ibool resync;
 			dword frame;
+			const dword interval;
+			dword elapsed;
 			Buffer buffers[2];
+			Index index;
 			Saver state;
 			Cpu& cpu;
 
 		public:
 
-			Recorder(std::iostream& stream,Cpu& c,const dword prgCrc,const bool append)
-			: resync(true), frame(0), state(stream,append ? Player::Validate(stream,c,prgCrc) : 0), cpu(c)
+			Recorder(std::iostream& stream,Cpu& c,const dword prgCrc,Fds* const fds,const bool append,const dword i)
+			:
+			resync   (true),
+			frame    (0),
+			interval (i),
+			elapsed  (0),
+			state    (stream,append ? Player::Validate(stream,c,prgCrc,fds,index) : 0),
+			cpu      (c)
 			{
 				if (!append)
 				{
@@ -324,6 +560,9 @@ namespace Nes
 
 					if (prgCrc)
 						state.Begin( AsciiId<'C','R','C'>::V ).Write32( prgCrc ).End();
+
+					if (fds && fds->IsFastLoad())
+						state.Begin( AsciiId<'F','D','L'>::V ).End();
 				}
 
 				Relink();
@@ -343,6 +582,9 @@ namespace Nes
 			{
 				EndKey();
 
+				if (index.entries.Size())
+					index.Save( state );
+
 				state.End();
 			}
 
@@ -353,6 +595,9 @@ namespace Nes
 				if (frame == BAD_FRAME)
 					throw RESULT_ERR_OUT_OF_MEMORY;
 
+				if (interval && elapsed >= interval)
+					resync = true;
+
 				if (resync || buffers[0].Size() >= MAX_BUFFER_BLOCK || buffers[1].Size() >= MAX_BUFFER_BLOCK)
 				{
 					EndKey();
@@ -360,6 +605,8 @@ namespace Nes
 				}
 
 				++frame;
+				++elapsed;
+				++index.frames;
 			}
 		};
 
@@ -377,11 +624,16 @@ namespace Nes
 
 		void Tracker::Movie::Recorder::BeginKey(Machine& machine,EmuSaveState saveState)
 		{
+			const dword offset = state.Length();
+
 			state.Begin( AsciiId<'K','E','Y'>::V );
 
 			if (resync)
 			{
 				resync = false;
+				elapsed = 0;
+
+				index.Add( index.frames, offset );
 
 				state.Begin( AsciiId<'S','A','V'>::V );
 				(machine.*saveState)( state );
@@ -461,7 +713,12 @@ namespace Nes
 			Stop();
 		}
 
-		bool Tracker::Movie::Record(std::iostream& stream,const bool append)
+		Fds* Tracker::Movie::GetDisk() const
+		{
+			return emulator.Is(Api::Machine::DISK) ? static_cast<Fds*>(emulator.image) : NULL;
+		}
+
+		bool Tracker::Movie::Record(std::iostream& stream,const bool append,const dword interval)
 		{
 			if (!Zlib::AVAILABLE)
 				throw RESULT_ERR_UNSUPPORTED;
@@ -474,7 +731,7 @@ namespace Nes
 
 			Stop();
 
-			recorder = new Recorder( stream, cpu, prgCrc, append );
+			recorder = new Recorder( stream, cpu, prgCrc, GetDisk(), append, interval );
 
 			Api::Movie::eventCallback( Api::Movie::EVENT_RECORDING );
 
@@ -494,13 +751,21 @@ namespace Nes
 
 			Stop();
 
-			player = new Player( stream, cpu, prgCrc );
+			player = new Player( stream, cpu, prgCrc, GetDisk() );
 
 			Api::Movie::eventCallback( Api::Movie::EVENT_PLAYING );
 
 			return true;
 		}
 
+		bool Tracker::Movie::Seek(const dword frame,dword& skip)
+		{
+			if (!player)
+				throw RESULT_ERR_NOT_READY;
+
+			return player->Seek( frame, skip );
+		}
+
 		void Tracker::Movie::Stop()
 		{
 			Stop( RESULT_OK );
@@ -33,6 +33,8 @@ namespace Nes
 {
 	namespace Core
 	{
+		class Fds;
+
 		class Tracker::Movie
 		{
 			typedef bool (Machine::*EmuLoadState)(State::Loader&,bool);
@@ -44,7 +46,8 @@ namespace Nes
 			~Movie();
 
 			bool Play(std::istream&);
-			bool Record(std::iostream&,bool);
+			bool Record(std::iostream&,bool,dword);
+			bool Seek(dword,dword&);
 			void Stop();
 			void Resync();
 			void Reset();
@@ -53,7 +56,9 @@ namespace Nes
 		private:
 
 			bool Stop(Result);
+			Fds* GetDisk() const;
 
+			struct Index;
 			class Player;
 			class Recorder;
 
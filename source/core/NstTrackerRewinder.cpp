@@ -448,7 +448,7 @@ namespace Nes
 				stream.seekp( 0, std::stringstream::beg );
 				stream.clear();
 
-				State::Saver saver( &static_cast<std::ostream&>(stream), false, true );
+				State::Saver saver( &static_cast<std::ostream&>(stream), State::NO_COMPRESSION, true );
 				(emulator.*saveState)( saver );
 			}
 			else if (loadState)
@@ -25,14 +25,14 @@
 
 switch
 (
-	(b.w[4] != b.w[0] && ((yuv5 - lut.yuv[b.w[0]]) & Lut::YUV_MASK) ? 0x01U : 0x0U) |
-	(b.w[4] != b.w[1] && ((yuv5 - lut.yuv[b.w[1]]) & Lut::YUV_MASK) ? 0x02U : 0x0U) |
-	(b.w[4] != b.w[2] && ((yuv5 - lut.yuv[b.w[2]]) & Lut::YUV_MASK) ? 0x04U : 0x0U) |
-	(b.w[4] != b.w[3] && ((yuv5 - lut.yuv[b.w[3]]) & Lut::YUV_MASK) ? 0x08U : 0x0U) |
-	(b.w[4] != b.w[5] && ((yuv5 - lut.yuv[b.w[5]]) & Lut::YUV_MASK) ? 0x10U : 0x0U) |
-	(b.w[4] != b.w[6] && ((yuv5 - lut.yuv[b.w[6]]) & Lut::YUV_MASK) ? 0x20U : 0x0U) |
-	(b.w[4] != b.w[7] && ((yuv5 - lut.yuv[b.w[7]]) & Lut::YUV_MASK) ? 0x40U : 0x0U) |
-	(b.w[4] != b.w[8] && ((yuv5 - lut.yuv[b.w[8]]) & Lut::YUV_MASK) ? 0x80U : 0x0U)
+	(Differs( flags, b.w[0] ) << 0) |
+	(Differs( flags, b.w[1] ) << 1) |
+	(Differs( flags, b.w[2] ) << 2) |
+	(Differs( flags, b.w[3] ) << 3) |
+	(Differs( flags, b.w[5] ) << 4) |
+	(Differs( flags, b.w[6] ) << 5) |
+	(Differs( flags, b.w[7] ) << 6) |
+	(Differs( flags, b.w[8] ) << 7)
 )
 #define PIXEL00_0     dst[0][0] = b.c[4];
 #define PIXEL00_10    dst[0][0] = Interpolate1<R,G,B>( b.c[4], b.c[0] );
@@ -120,35 +120,31 @@ namespace Nes
 				return ((((c1 & G)*14 + (c2 & G) + (c3 & G)) & (G << 4)) + (((c1 & (R|B))*14 + (c2 & (R|B)) + (c3 & (R|B))) & ((R|B) << 4))) >> 4;
 			}
 
+			inline dword Renderer::FilterHqX::Differs(const dword* row,uint w)
+			{
+				return row[w >> 5] >> (w & 0x1F) & 0x1;
+			}
+
 			inline dword Renderer::FilterHqX::Diff(uint w1,uint w2) const
 			{
-				return (lut.yuv[w1] - lut.yuv[w2] + Lut::YUV_OFFSET) & Lut::YUV_MASK;
+				return Differs( table.edges[w1], w2 );
 			}
 
-			template<typename T>
 			struct Renderer::FilterHqX::Buffer
 			{
 				uint w[10];
 				dword c[10];
 
-				NST_FORCE_INLINE void Convert(const Lut& lut)
+				NST_FORCE_INLINE void Load(const Table& table,uint k,uint pixel)
 				{
-					for (uint k=0; k < 9; ++k)
-						c[k] = lut.rgb[w[k]];
+					w[k] = pixel;
+					c[k] = table.rgb[pixel];
 				}
-			};
 
-			template<>
-			struct Renderer::FilterHqX::Buffer<word>
-			{
-				union
-				{
-					uint w[10];
-					dword c[10];
-				};
-
-				void Convert(const Lut&)
+				NST_FORCE_INLINE void Copy(uint k,uint from)
 				{
+					w[k] = w[from];
+					c[k] = c[from];
 				}
 			};
 
@@ -172,11 +168,15 @@ namespace Nes
 						y > 1      ? WIDTH * sizeof(Input::Pixel) : 0
 					};
 
-					Buffer<T> b;
+					Buffer b;
+
+					b.Load( table, 1, *reinterpret_cast<const Input::Pixel*>(src - lines[0]) );
+					b.Load( table, 4, *reinterpret_cast<const Input::Pixel*>(src) );
+					b.Load( table, 7, *reinterpret_cast<const Input::Pixel*>(src + lines[1]) );
 
-					b.w[2] = (b.w[1] = input.palette[*reinterpret_cast<const Input::Pixel*>(src - lines[0])]);
-					b.w[5] = (b.w[4] = input.palette[*reinterpret_cast<const Input::Pixel*>(src)]);
-					b.w[8] = (b.w[7] = input.palette[*reinterpret_cast<const Input::Pixel*>(src + lines[1])]);
+					b.Copy( 2, 1 );
+					b.Copy( 5, 4 );
+					b.Copy( 8, 7 );
 
 					for (uint x=WIDTH; x; )
 					{
@@ -184,23 +184,21 @@ namespace Nes
 						dst[0] += 2;
 						dst[1] += 2;
 
-						b.w[0] = b.w[1];
-						b.w[1] = b.w[2];
-						b.w[3] = b.w[4];
-						b.w[4] = b.w[5];
-						b.w[6] = b.w[7];
-						b.w[7] = b.w[8];
+						b.Copy( 0, 1 );
+						b.Copy( 1, 2 );
+						b.Copy( 3, 4 );
+						b.Copy( 4, 5 );
+						b.Copy( 6, 7 );
+						b.Copy( 7, 8 );
 
 						if (--x)
 						{
-							b.w[2] = input.palette[*reinterpret_cast<const Input::Pixel*>(src - lines[0])];
-							b.w[5] = input.palette[*reinterpret_cast<const Input::Pixel*>(src)];
-							b.w[8] = input.palette[*reinterpret_cast<const Input::Pixel*>(src + lines[1])];
+							b.Load( table, 2, *reinterpret_cast<const Input::Pixel*>(src - lines[0]) );
+							b.Load( table, 5, *reinterpret_cast<const Input::Pixel*>(src) );
+							b.Load( table, 8, *reinterpret_cast<const Input::Pixel*>(src + lines[1]) );
 						}
 
-						b.Convert( lut );
-
-						const uint yuv5 = lut.yuv[b.w[4]];
+						const dword* const NST_RESTRICT flags = table.flags[b.w[4]];
 
 						#include "NstVideoFilterHq2x.inl"
 					}
@@ -231,11 +229,15 @@ namespace Nes
 						y > 1      ? WIDTH * sizeof(Input::Pixel) : 0
 					};
 
-					Buffer<T> b;
+					Buffer b;
+
+					b.Load( table, 1, *reinterpret_cast<const Input::Pixel*>(src - lines[0]) );
+					b.Load( table, 4, *reinterpret_cast<const Input::Pixel*>(src) );
+					b.Load( table, 7, *reinterpret_cast<const Input::Pixel*>(src + lines[1]) );
 
-					b.w[2] = (b.w[1] = input.palette[*reinterpret_cast<const Input::Pixel*>(src - lines[0])]);
-					b.w[5] = (b.w[4] = input.palette[*reinterpret_cast<const Input::Pixel*>(src)]);
-					b.w[8] = (b.w[7] = input.palette[*reinterpret_cast<const Input::Pixel*>(src + lines[1])]);
+					b.Copy( 2, 1 );
+					b.Copy( 5, 4 );
+					b.Copy( 8, 7 );
 
 					for (uint x=WIDTH; x; )
 					{
@@ -244,23 +246,21 @@ namespace Nes
 						dst[1] += 3;
 						dst[2] += 3;
 
-						b.w[0] = b.w[1];
-						b.w[1] = b.w[2];
-						b.w[3] = b.w[4];
-						b.w[4] = b.w[5];
-						b.w[6] = b.w[7];
-						b.w[7] = b.w[8];
+						b.Copy( 0, 1 );
+						b.Copy( 1, 2 );
+						b.Copy( 3, 4 );
+						b.Copy( 4, 5 );
+						b.Copy( 6, 7 );
+						b.Copy( 7, 8 );
 
 						if (--x)
 						{
-							b.w[2] = input.palette[*reinterpret_cast<const Input::Pixel*>(src - lines[0])];
-							b.w[5] = input.palette[*reinterpret_cast<const Input::Pixel*>(src)];
-							b.w[8] = input.palette[*reinterpret_cast<const Input::Pixel*>(src + lines[1])];
+							b.Load( table, 2, *reinterpret_cast<const Input::Pixel*>(src - lines[0]) );
+							b.Load( table, 5, *reinterpret_cast<const Input::Pixel*>(src) );
+							b.Load( table, 8, *reinterpret_cast<const Input::Pixel*>(src + lines[1]) );
 						}
 
-						b.Convert( lut );
-
-						const uint yuv5 = lut.yuv[b.w[4]];
+						const dword* const NST_RESTRICT flags = table.flags[b.w[4]];
 
 						#include "NstVideoFilterHq3x.inl"
 					}
@@ -293,11 +293,15 @@ namespace Nes
 						y > 1      ? WIDTH * sizeof(Input::Pixel) : 0
 					};
 
-					Buffer<T> b;
+					Buffer b;
+
+					b.Load( table, 1, *reinterpret_cast<const Input::Pixel*>(src - lines[0]) );
+					b.Load( table, 4, *reinterpret_cast<const Input::Pixel*>(src) );
+					b.Load( table, 7, *reinterpret_cast<const Input::Pixel*>(src + lines[1]) );
 
-					b.w[2] = (b.w[1] = input.palette[*reinterpret_cast<const Input::Pixel*>(src - lines[0])]);
-					b.w[5] = (b.w[4] = input.palette[*reinterpret_cast<const Input::Pixel*>(src)]);
-					b.w[8] = (b.w[7] = input.palette[*reinterpret_cast<const Input::Pixel*>(src + lines[1])]);
+					b.Copy( 2, 1 );
+					b.Copy( 5, 4 );
+					b.Copy( 8, 7 );
 
 					for (uint x=WIDTH; x; )
 					{
@@ -307,23 +311,21 @@ namespace Nes
 						dst[2] += 4;
 						dst[3] += 4;
 
-						b.w[0] = b.w[1];
-						b.w[1] = b.w[2];
-						b.w[3] = b.w[4];
-						b.w[4] = b.w[5];
-						b.w[6] = b.w[7];
-						b.w[7] = b.w[8];
+						b.Copy( 0, 1 );
+						b.Copy( 1, 2 );
+						b.Copy( 3, 4 );
+						b.Copy( 4, 5 );
+						b.Copy( 6, 7 );
+						b.Copy( 7, 8 );
 
 						if (--x)
 						{
-							b.w[2] = input.palette[*reinterpret_cast<const Input::Pixel*>(src - lines[0])];
-							b.w[5] = input.palette[*reinterpret_cast<const Input::Pixel*>(src)];
-							b.w[8] = input.palette[*reinterpret_cast<const Input::Pixel*>(src + lines[1])];
+							b.Load( table, 2, *reinterpret_cast<const Input::Pixel*>(src - lines[0]) );
+							b.Load( table, 5, *reinterpret_cast<const Input::Pixel*>(src) );
+							b.Load( table, 8, *reinterpret_cast<const Input::Pixel*>(src + lines[1]) );
 						}
 
-						b.Convert( lut );
-
-						const uint yuv5 = lut.yuv[b.w[4]];
+						const dword* const NST_RESTRICT flags = table.flags[b.w[4]];
 
 						#include "NstVideoFilterHq4x.inl"
 					}
@@ -339,8 +341,7 @@ namespace Nes
 			#pragma optimize("s", on)
 			#endif
 
-			Renderer::FilterHqX::Lut::Lut(const bool bpp32,const byte (&formatShifts)[3],dword* tmp)
-			: rgb(tmp = (bpp32 ? new dword [0x10000] : NULL))
+			Renderer::FilterHqX::Lut::Lut(const bool bpp32,const byte (&formatShifts)[3])
 			{
 				const uint shifts[3] =
 				{
@@ -367,17 +368,35 @@ namespace Nes
 						}
 					}
 				}
+			}
 
-				if (bpp32)
+			void Renderer::FilterHqX::Table::Update(const Lut& lut,const Input::Palette& palette,const bool bpp32)
+			{
+				for (uint i=0; i < PALETTE; ++i)
 				{
-					for (dword i=0; i < 0x10000; ++i)
-						tmp[i] = ((i & 0xF800) << 8) | ((i & 0x07E0) << 5) | ((i & 0x001F) << 3);
+					const dword c = palette[i];
+					rgb[i] = bpp32 ? ((c & 0xF800) << 8) | ((c & 0x07E0) << 5) | ((c & 0x001F) << 3) : c;
 				}
-			}
 
-			Renderer::FilterHqX::Lut::~Lut()
-			{
-				delete [] rgb;
+				for (uint i=0; i < PALETTE; ++i)
+				{
+					for (uint j=0; j < ROW; ++j)
+					{
+						flags[i][j] = 0;
+						edges[i][j] = 0;
+					}
+
+					for (uint j=0; j < PALETTE; ++j)
+					{
+						const dword yuv = lut.yuv[palette[i]] - lut.yuv[palette[j]];
+
+						if (palette[i] != palette[j] && (yuv & Lut::YUV_MASK))
+							flags[i][j >> 5] |= 1UL << (j & 0x1F);
+
+						if ((yuv + Lut::YUV_OFFSET) & Lut::YUV_MASK)
+							edges[i][j >> 5] |= 1UL << (j & 0x1F);
+					}
+				}
 			}
 
 			Renderer::FilterHqX::Path Renderer::FilterHqX::GetPath(const RenderState& state)
@@ -470,6 +489,8 @@ namespace Nes
 				{
 					Filter::Transform( src, dst );
 				}
+
+				table.Update( lut, dst, format.bpp == 32 );
 			}
 
 			#ifdef NST_MSVC_OPTIMIZE
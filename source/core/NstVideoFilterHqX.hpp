@@ -67,6 +67,7 @@ namespace Nes
 				template<dword R,dword G,dword B> static dword Interpolate10(dword,dword,dword);
 
 				inline dword Diff(uint,uint) const;
+				static inline dword Differs(const dword*,uint);
 
 				template<typename T,dword R,dword G,dword B>
 				void Blit2x(const Input&,const Output&) const;
@@ -77,13 +78,11 @@ namespace Nes
 				template<typename T,dword R,dword G,dword B>
 				void Blit4x(const Input&,const Output&) const;
 
-				template<typename T>
 				struct Buffer;
 
 				struct Lut
 				{
-					Lut(bool,const byte (&)[3],dword* = NULL);
-					~Lut();
+					Lut(bool,const byte (&)[3]);
 
 					enum
 					{
@@ -92,11 +91,25 @@ namespace Nes
 					};
 
 					dword yuv[0x10000];
-					const dword* const NST_RESTRICT rgb;
+				};
+
+				struct Table
+				{
+					void Update(const Lut&,const Input::Palette&,bool);
+
+					enum
+					{
+						ROW = PALETTE / 32
+					};
+
+					dword rgb[PALETTE];
+					dword flags[PALETTE][ROW];
+					dword edges[PALETTE][ROW];
 				};
 
 				const Path path;
 				const Lut lut;
+				mutable Table table;
 			};
 		}
 	}
@@ -26,6 +26,7 @@
 #include "NstVideoRenderer.hpp"
 #include "NstVideoFilterNtsc.hpp"
 #include "NstFpuPrecision.hpp"
+#include "../nes_ntsc/nes_ntsc_simd.inl"
 
 namespace Nes
 {
@@ -89,6 +90,30 @@ namespace Nes
 				}
 			}
 
+			#ifdef NES_NTSC_SIMD
+
+			void Renderer::FilterNtsc::BlitSimd(const Input& input,const Output& output,uint phase) const
+			{
+				NST_ASSERT( phase < 3 );
+
+				const Input::Pixel* NST_RESTRICT src = input.pixels;
+				byte* NST_RESTRICT dst = static_cast<byte*>(output.pixels);
+
+				phase &= lut.noFieldMerging;
+
+				for (uint y=HEIGHT; y; --y)
+				{
+					row( lut.simd, phase, this->bgColor, src, NTSC_WIDTH/7-1, dst, depth );
+
+					src += WIDTH;
+					dst += output.pitch;
+
+					phase = (phase + 1) % 3;
+				}
+			}
+
+			#endif
+
 			#ifdef NST_MSVC_OPTIMIZE
 			#pragma optimize("s", on)
 			#endif
@@ -104,6 +129,11 @@ namespace Nes
 
 			Renderer::FilterNtsc::Path Renderer::FilterNtsc::GetPath(const RenderState& state,const Lut& lut)
 			{
+			#ifdef NES_NTSC_SIMD
+				if (nes_ntsc_simd_best() != nes_ntsc_simd_none)
+					return &FilterNtsc::BlitSimd;
+			#endif
+
 				if (state.bits.count == 32)
 				{
 					return &FilterNtsc::BlitType<dword,32>;
@@ -171,6 +201,10 @@ namespace Nes
 				setup.base_palette = NULL;
 
 				::nes_ntsc_init( this, &setup );
+
+			#ifdef NES_NTSC_SIMD
+				::nes_ntsc_simd_pack( simd, this );
+			#endif
 			}
 
 			Renderer::FilterNtsc::FilterNtsc
@@ -188,6 +222,10 @@ namespace Nes
 			Filter (state),
 			path   (GetPath(state,lut)),
 			lut    (palette,sharpness,resolution,bleed,artifacts,fringing,fieldMerging)
+		#ifdef NES_NTSC_SIMD
+			,row   (nes_ntsc_simd_row( nes_ntsc_simd_best() )),
+			depth  (state.bits.count == 32 ? 32 : state.bits.mask.g == 0x07E0 ? 16 : 15)
+		#endif
 			{
 			}
 
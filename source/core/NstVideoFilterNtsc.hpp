@@ -26,6 +26,7 @@
 #define NST_VIDEO_FILTER_NTSC_H
 
 #include "../nes_ntsc/nes_ntsc.h"
+#include "../nes_ntsc/nes_ntsc_simd.h"
 
 #ifdef NST_PRAGMA_ONCE
 #pragma once
@@ -61,6 +62,10 @@ namespace Nes
 				template<typename T,uint BITS>
 				void BlitType(const Input&,const Output&,uint) const;
 
+			#ifdef NES_NTSC_SIMD
+				void BlitSimd(const Input&,const Output&,uint) const;
+			#endif
+
 				class Lut : public nes_ntsc_t
 				{
 					enum
@@ -76,12 +81,21 @@ namespace Nes
 
 					const uint noFieldMerging;
 					const uint black;
+
+				#ifdef NES_NTSC_SIMD
+					nes_ntsc_simd_rgb_t simd[nes_ntsc_simd_table_size];
+				#endif
 				};
 
 				static Path GetPath(const RenderState&,const Lut&);
 
 				const Path path;
 				const Lut lut;
+
+			#ifdef NES_NTSC_SIMD
+				const nes_ntsc_simd_row_t row;
+				const uint depth;
+			#endif
 			};
 		}
 	}
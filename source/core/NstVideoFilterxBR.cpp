@@ -44,10 +44,14 @@ namespace Nes
 			path   (GetPath(state, blend, corner_rounding))
 			{
 				_index = new YUVPixel*[32768];
+				_palette = new YUVPixel[PALETTE];
 
 				//Todo: When a setting is changed before starting a game, "transform" will
 				//not be called for some reason. (This is a quick workaround)
 				initCache();
+
+				for (uint i=0; i < PALETTE; ++i)
+					_palette[i] = *_index[0];
 			}
 
 			/**
@@ -66,6 +70,7 @@ namespace Nes
 			{
 				freeCache();
 				free(_index);
+				delete [] _palette;
 			}
 
 			void Renderer::FilterxBR::freeCache() const
@@ -312,33 +317,33 @@ namespace Nes
 						
 						//Fetches pixels and converts to YUV
 						YUVPixel pa, pb, pc, pd, pe, pf, pg, ph, pi, a1, b1, c1, a0, d0, g0, c4, f4, i4, g5, h5, i5;
-						pa = getPixel(input.palette[src[xm1 + ym1]]);
-						pb = getPixel(input.palette[src[x + ym1]]);
-						pc = getPixel(input.palette[src[x1 + ym1]]);
+						pa = _palette[src[xm1 + ym1]];
+						pb = _palette[src[x + ym1]];
+						pc = _palette[src[x1 + ym1]];
 
-						pd = getPixel(input.palette[src[xm1 + y]]);
-						pe = e0 = e1 = e2 = e3 = e4 = e5 = e6 = e7= e8 = e9 = ea = eb = ec = ed = ee = ef = getPixel(input.palette[src[x + y]]);;
-						pf = getPixel(input.palette[src[x1 + y]]);
+						pd = _palette[src[xm1 + y]];
+						pe = e0 = e1 = e2 = e3 = e4 = e5 = e6 = e7= e8 = e9 = ea = eb = ec = ed = ee = ef = _palette[src[x + y]];;
+						pf = _palette[src[x1 + y]];
 
-						pg = getPixel(input.palette[src[xm1 + y1]]);
-						ph = getPixel(input.palette[src[x + y1]]);
-						pi = getPixel(input.palette[src[x1 + y1]]);
+						pg = _palette[src[xm1 + y1]];
+						ph = _palette[src[x + y1]];
+						pi = _palette[src[x1 + y1]];
 
-						a1 = getPixel(input.palette[src[xm1 + ym2]]);
-						b1 = getPixel(input.palette[src[x + ym2]]);
-						c1 = getPixel(input.palette[src[x1 + ym2]]);
+						a1 = _palette[src[xm1 + ym2]];
+						b1 = _palette[src[x + ym2]];
+						c1 = _palette[src[x1 + ym2]];
 
-						a0 = getPixel(input.palette[src[xm2 + ym1]]);
-						d0 = getPixel(input.palette[src[xm2 + y]]);
-						g0 = getPixel(input.palette[src[xm2 + y1]]);
+						a0 = _palette[src[xm2 + ym1]];
+						d0 = _palette[src[xm2 + y]];
+						g0 = _palette[src[xm2 + y1]];
 
-						c4 = getPixel(input.palette[src[x2 + ym1]]);
-						f4 = getPixel(input.palette[src[x2 + y]]);
-						i4 = getPixel(input.palette[src[x2 + y1]]);
+						c4 = _palette[src[x2 + ym1]];
+						f4 = _palette[src[x2 + y]];
+						i4 = _palette[src[x2 + y1]];
 
-						g5 = getPixel(input.palette[src[xm1 + y2]]);
-						h5 = getPixel(input.palette[src[x + y2]]);
-						i5 = getPixel(input.palette[src[x1 + y2]]);
+						g5 = _palette[src[xm1 + y2]];
+						h5 = _palette[src[x + y2]];
+						i5 = _palette[src[x1 + y2]];
 
 						#pragma endregion
 
@@ -449,33 +454,33 @@ namespace Nes
 						
 						//Fetches pixels and converts to YUV
 						YUVPixel pa, pb, pc, pd, pe, pf, pg, ph, pi, a1, b1, c1, a0, d0, g0, c4, f4, i4, g5, h5, i5;
-						pa = getPixel(input.palette[src[xm1 + ym1]]);
-						pb = getPixel(input.palette[src[x + ym1]]);
-						pc = getPixel(input.palette[src[x1 + ym1]]);
+						pa = _palette[src[xm1 + ym1]];
+						pb = _palette[src[x + ym1]];
+						pc = _palette[src[x1 + ym1]];
 
-						pd = getPixel(input.palette[src[xm1 + y]]);
-						pe = e0 = e1 = e2 = e3 = e4 = e5 = e6 = e7= e8 = getPixel(input.palette[src[x + y]]);;
-						pf = getPixel(input.palette[src[x1 + y]]);
+						pd = _palette[src[xm1 + y]];
+						pe = e0 = e1 = e2 = e3 = e4 = e5 = e6 = e7= e8 = _palette[src[x + y]];;
+						pf = _palette[src[x1 + y]];
 
-						pg = getPixel(input.palette[src[xm1 + y1]]);
-						ph = getPixel(input.palette[src[x + y1]]);
-						pi = getPixel(input.palette[src[x1 + y1]]);
+						pg = _palette[src[xm1 + y1]];
+						ph = _palette[src[x + y1]];
+						pi = _palette[src[x1 + y1]];
 
-						a1 = getPixel(input.palette[src[xm1 + ym2]]);
-						b1 = getPixel(input.palette[src[x + ym2]]);
-						c1 = getPixel(input.palette[src[x1 + ym2]]);
+						a1 = _palette[src[xm1 + ym2]];
+						b1 = _palette[src[x + ym2]];
+						c1 = _palette[src[x1 + ym2]];
 
-						a0 = getPixel(input.palette[src[xm2 + ym1]]);
-						d0 = getPixel(input.palette[src[xm2 + y]]);
-						g0 = getPixel(input.palette[src[xm2 + y1]]);
+						a0 = _palette[src[xm2 + ym1]];
+						d0 = _palette[src[xm2 + y]];
+						g0 = _palette[src[xm2 + y1]];
 
-						c4 = getPixel(input.palette[src[x2 + ym1]]);
-						f4 = getPixel(input.palette[src[x2 + y]]);
-						i4 = getPixel(input.palette[src[x2 + y1]]);
+						c4 = _palette[src[x2 + ym1]];
+						f4 = _palette[src[x2 + y]];
+						i4 = _palette[src[x2 + y1]];
 
-						g5 = getPixel(input.palette[src[xm1 + y2]]);
-						h5 = getPixel(input.palette[src[x + y2]]);
-						i5 = getPixel(input.palette[src[x1 + y2]]);
+						g5 = _palette[src[xm1 + y2]];
+						h5 = _palette[src[x + y2]];
+						i5 = _palette[src[x1 + y2]];
 
 						#pragma endregion
 
@@ -581,33 +586,33 @@ namespace Nes
 						
 						//Fetches pixels and converts to YUV
 						YUVPixel pa, pb, pc, pd, pe, pf, pg, ph, pi, a1, b1, c1, a0, d0, g0, c4, f4, i4, g5, h5, i5;
-						pa = getPixel(input.palette[src[xm1 + ym1]]);
-						pb = getPixel(input.palette[src[x + ym1]]);
-						pc = getPixel(input.palette[src[x1 + ym1]]);
+						pa = _palette[src[xm1 + ym1]];
+						pb = _palette[src[x + ym1]];
+						pc = _palette[src[x1 + ym1]];
 
-						pd = getPixel(input.palette[src[xm1 + y]]);
-						pe = e0 = e1 = e2 = e3 = getPixel(input.palette[src[x + y]]);;
-						pf = getPixel(input.palette[src[x1 + y]]);
+						pd = _palette[src[xm1 + y]];
+						pe = e0 = e1 = e2 = e3 = _palette[src[x + y]];;
+						pf = _palette[src[x1 + y]];
 
-						pg = getPixel(input.palette[src[xm1 + y1]]);
-						ph = getPixel(input.palette[src[x + y1]]);
-						pi = getPixel(input.palette[src[x1 + y1]]);
+						pg = _palette[src[xm1 + y1]];
+						ph = _palette[src[x + y1]];
+						pi = _palette[src[x1 + y1]];
 
-						a1 = getPixel(input.palette[src[xm1 + ym2]]);
-						b1 = getPixel(input.palette[src[x + ym2]]);
-						c1 = getPixel(input.palette[src[x1 + ym2]]);
+						a1 = _palette[src[xm1 + ym2]];
+						b1 = _palette[src[x + ym2]];
+						c1 = _palette[src[x1 + ym2]];
 
-						a0 = getPixel(input.palette[src[xm2 + ym1]]);
-						d0 = getPixel(input.palette[src[xm2 + y]]);
-						g0 = getPixel(input.palette[src[xm2 + y1]]);
+						a0 = _palette[src[xm2 + ym1]];
+						d0 = _palette[src[xm2 + y]];
+						g0 = _palette[src[xm2 + y1]];
 
-						c4 = getPixel(input.palette[src[x2 + ym1]]);
-						f4 = getPixel(input.palette[src[x2 + y]]);
-						i4 = getPixel(input.palette[src[x2 + y1]]);
+						c4 = _palette[src[x2 + ym1]];
+						f4 = _palette[src[x2 + y]];
+						i4 = _palette[src[x2 + y1]];
 
-						g5 = getPixel(input.palette[src[xm1 + y2]]);
-						h5 = getPixel(input.palette[src[x + y2]]);
-						i5 = getPixel(input.palette[src[x1 + y2]]);
+						g5 = _palette[src[xm1 + y2]];
+						h5 = _palette[src[x + y2]];
+						i5 = _palette[src[x1 + y2]];
 
 						#pragma endregion
 
@@ -804,6 +809,11 @@ namespace Nes
 				}
 				else //Assumes "Filter::Transform" spits out '1'-5-5-5
 					Filter::Transform( src, dst );
+
+				//Resolves each palette index once, so the blitters can skip
+				//the palette and the 32KB cache.
+				for (uint i=0; i < PALETTE; ++i)
+					_palette[i] = getPixel(dst[i]);
 			}
 
 			template<dword R_MASK, dword R_SHIFT, dword G_MASK, dword G_SHIFT, dword B_MASK, dword B_SHIFT>
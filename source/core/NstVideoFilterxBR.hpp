@@ -146,6 +146,10 @@ namespace Nes
 				// 
 				YUVPixel** _index;
 
+				//YUV pixels for each of the 512 palette indices, resolved through
+				//the cache above whenever the palette changes.
+				YUVPixel* _palette;
+
 				//Whenever to blend pixels or not. Unblended give a crisper but jagged image
 				const bool _blend;
 
@@ -808,10 +808,11 @@ namespace Nes
 
 					SetState( renderState );
 				}
-				else if (state.update & uint(State::UPDATE_FILTER))
-				{
+
+				// a rebuilt filter has its lookup tables filled in here as well
+
+				if (filter && (state.update & uint(State::UPDATE_FILTER)))
 					filter->Transform( GetPalette(), input.palette );
-				}
 
 				state.update = 0;
 			}
@@ -827,7 +828,7 @@ namespace Nes
 					if (state.update)
 						UpdateFilter( input );
 
-					if (Output::lockCallback( output ))
+					if (filter && Output::lockCallback( output ))
 					{
 						NST_VERIFY( std::labs(output.pitch) >= dword(state.width) << (filter->format.bpp / 16) );
 						
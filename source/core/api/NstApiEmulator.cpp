@@ -22,7 +22,9 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <ostream>
 #include "../NstMachine.hpp"
+#include "../NstCartridge.hpp"
 #include "NstApiEmulator.hpp"
 
 namespace Nes
@@ -54,12 +56,162 @@ namespace Nes
 			Core::Input::Controllers* input
 		)   throw()
 		{
+		#ifdef NST_PROFILER
+
+			Result result;
+
+			{
+				Core::Profiler& profiler = machine.cpu.GetProfiler();
+				NST_PROFILE_TIME( profiler, TIME_FRAME );
+				result = machine.tracker.Execute( machine, video, sound, input );
+			}
+
+			machine.cpu.GetProfiler().EndFrame( machine.tracker.Frame() );
+
+			return result;
+
+		#else
+
 			return machine.tracker.Execute( machine, video, sound, input );
+
+		#endif
 		}
 
 		ulong Emulator::Frame() const throw()
 		{
 			return machine.tracker.Frame();
 		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		#ifdef NST_PROFILER
+
+		Result Emulator::EnableProfiler(bool enable) throw()
+		{
+			Core::Profiler& profiler = machine.cpu.GetProfiler();
+
+			if (profiler.Enabled() == enable)
+				return RESULT_NOP;
+
+			profiler.Enable( enable );
+
+			return RESULT_OK;
+		}
+
+		uint Emulator::GetProfiles(FrameProfile* const profiles,uint count) const throw()
+		{
+			NST_COMPILE_ASSERT( uint(PROFILE_FRAMES) == uint(Core::Profiler::NUM_SAMPLES) );
+
+			const Core::Profiler& profiler = machine.cpu.GetProfiler();
+
+			if (!profiles || count > profiler.NumSamples())
+				count = profiles ? profiler.NumSamples() : 0;
+
+			for (uint i=0, first=profiler.NumSamples()-count; i < count; ++i)
+			{
+				typedef Core::Profiler Profiler;
+
+				const Profiler::Sample& sample = profiler[first+i];
+				FrameProfile& profile = profiles[i];
+
+				profile.frame        = sample.frame;
+				profile.instructions = sample.counters[Profiler::CPU_INSTRUCTIONS];
+				profile.hooks        = sample.counters[Profiler::CPU_HOOKS];
+				profile.mapperReads  = sample.counters[Profiler::MAPPER_READS];
+				profile.mapperWrites = sample.counters[Profiler::MAPPER_WRITES];
+				profile.samples      = sample.counters[Profiler::APU_SAMPLES];
+				profile.frameTime    = sample.times[Profiler::TIME_FRAME];
+				profile.machineTime  = sample.times[Profiler::TIME_MACHINE];
+				profile.cpuTime      = sample.times[Profiler::TIME_CPU];
+				profile.ppuTime      = sample.times[Profiler::TIME_PPU];
+				profile.apuTime      = sample.times[Profiler::TIME_APU];
+				profile.blitTime     = sample.times[Profiler::TIME_BLIT];
+			}
+
+			return count;
+		}
+
+		Result Emulator::SaveProfiles(std::ostream& stream) const throw()
+		{
+			try
+			{
+				FrameProfile profiles[PROFILE_FRAMES];
+				const uint count = GetProfiles( profiles, PROFILE_FRAMES );
+
+				stream << "{\n  \"board\": \"";
+
+				if (machine.Is(Api::Machine::CARTRIDGE))
+				{
+					const Cartridge::Profile::Board& board = static_cast<const Core::Cartridge*>(machine.image)->GetProfile().board;
+
+					for (std::wstring::const_iterator it(board.type.begin()), end(board.type.end()); it != end; ++it)
+					{
+						if (*it >= 0x20 && *it < 0x7F && *it != '"' && *it != '\\')
+							stream << char(*it);
+					}
+
+					stream << "\",\n  \"mapper\": " << board.mapper;
+				}
+				else
+				{
+					stream << "\",\n  \"mapper\": null";
+				}
+
+				stream << ",\n  \"frames\": [";
+
+				for (uint i=0; i < count; ++i)
+				{
+					const FrameProfile& p = profiles[i];
+
+					stream << (i ? ",\n" : "\n")
+					       << "    { \"frame\": "        << p.frame
+					       << ", \"instructions\": "   << p.instructions
+					       << ", \"hooks\": "          << p.hooks
+					       << ", \"mapperReads\": "    << p.mapperReads
+					       << ", \"mapperWrites\": "   << p.mapperWrites
+					       << ", \"samples\": "        << p.samples
+					       << ", \"frameTime\": "      << p.frameTime
+					       << ", \"machineTime\": "    << p.machineTime
+					       << ", \"cpuTime\": "        << p.cpuTime
+					       << ", \"ppuTime\": "        << p.ppuTime
+					       << ", \"apuTime\": "        << p.apuTime
+					       << ", \"blitTime\": "       << p.blitTime
+					       << " }";
+				}
+
+				stream << "\n  ]\n}\n";
+
+				return stream ? RESULT_OK : RESULT_ERR_GENERIC;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+		}
+
+		#else
+
+		Result Emulator::EnableProfiler(bool) throw()
+		{
+			return RESULT_ERR_UNSUPPORTED;
+		}
+
+		uint Emulator::GetProfiles(FrameProfile*,uint) const throw()
+		{
+			return 0;
+		}
+
+		Result Emulator::SaveProfiles(std::ostream&) const throw()
+		{
+			return RESULT_ERR_UNSUPPORTED;
+		}
+
+		#endif
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
 	}
 }
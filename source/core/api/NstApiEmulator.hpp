@@ -25,6 +25,8 @@
 #ifndef NST_API_EMULATOR_H
 #define NST_API_EMULATOR_H
 
+#include <iosfwd>
+
 #ifndef NST_BASE_H
 #include "../NstBase.hpp"
 #endif
@@ -93,6 +95,112 @@ namespace Nes
 			*/
 			ulong Frame() const throw();
 
+			/**
+			* Frame profile.
+			*
+			* Times are in nanoseconds and nest: PPU, APU and blit time is part of
+			* machine time, PPU and APU time spent catching up during instruction
+			* execution is also part of CPU time. Frame time less machine time is
+			* the time spent in the rewinder and movie tracker.
+			*/
+			struct FrameProfile
+			{
+				/**
+				* Frame number.
+				*/
+				ulong frame;
+
+				/**
+				* Executed CPU instructions.
+				*/
+				ulong instructions;
+
+				/**
+				* Per-instruction hook invocations.
+				*/
+				ulong hooks;
+
+				/**
+				* CPU reads in the $4020-$FFFF range.
+				*/
+				ulong mapperReads;
+
+				/**
+				* CPU writes in the $4020-$FFFF range.
+				*/
+				ulong mapperWrites;
+
+				/**
+				* Samples written to the sound output.
+				*/
+				ulong samples;
+
+				/**
+				* Total frame time.
+				*/
+				ulong frameTime;
+
+				/**
+				* Machine time.
+				*/
+				ulong machineTime;
+
+				/**
+				* CPU time.
+				*/
+				ulong cpuTime;
+
+				/**
+				* PPU rendering time.
+				*/
+				ulong ppuTime;
+
+				/**
+				* APU sample generation time.
+				*/
+				ulong apuTime;
+
+				/**
+				* Video filter time.
+				*/
+				ulong blitTime;
+			};
+
+			enum
+			{
+				/**
+				* Number of frame profiles kept.
+				*/
+				PROFILE_FRAMES = 256
+			};
+
+			/**
+			* Enables or disables the frame profiler.
+			*
+			* The profiler is only present in cores built with NST_PROFILER defined.
+			*
+			* @param enable true to enable
+			* @return result code, RESULT_ERR_UNSUPPORTED if not built with the profiler
+			*/
+			Result EnableProfiler(bool enable) throw();
+
+			/**
+			* Returns the most recent frame profiles, oldest first.
+			*
+			* @param profiles array to fill
+			* @param count size of array, at most PROFILE_FRAMES profiles are kept
+			* @return number of profiles written
+			*/
+			uint GetProfiles(FrameProfile* profiles,uint count) const throw();
+
+			/**
+			* Writes the kept frame profiles as JSON.
+			*
+			* @param stream output stream
+			* @return result code, RESULT_ERR_UNSUPPORTED if not built with the profiler
+			*/
+			Result SaveProfiles(std::ostream& stream) const throw();
+
 		private:
 
 			Core::Machine& machine;
@@ -179,6 +179,27 @@ namespace Nes
 			return Core::Fds::HasBios();
 		}
 
+		Result Fds::SetFastLoad(bool enable) throw()
+		{
+			if (IsFastLoadEnabled() == enable)
+				return RESULT_NOP;
+
+			emulator.fdsFastLoad = enable;
+
+			if (emulator.Is(Machine::DISK))
+				static_cast<Core::Fds*>(emulator.image)->SetFastLoad( enable );
+
+			return RESULT_OK;
+		}
+
+		bool Fds::IsFastLoadEnabled() const throw()
+		{
+			if (emulator.Is(Machine::DISK))
+				return static_cast<const Core::Fds*>(emulator.image)->IsFastLoad();
+
+			return emulator.fdsFastLoad;
+		}
+
 		uint Fds::GetNumDisks() const throw()
 		{
 			if (emulator.Is(Machine::DISK))
@@ -122,6 +122,30 @@ namespace Nes
 			*/
 			bool HasBIOS() const throw();
 
+			/**
+			* Enables or disables fast disk loading.
+			*
+			* When enabled, disk transfers started by the BIOS skip the motor spin-up,
+			* rewind and block gap delays and deliver each byte as soon as the previous
+			* one has been taken. Transfers driven by game code, such as copy-protection
+			* loaders, and disks with a non-standard layout always run at normal speed.
+			* Takes effect from the next time the drive motor is started.
+			*
+			* The setting belongs to this emulator instance. The mode in use is stored
+			* in states and movies, and loading one switches the loaded disk to it.
+			*
+			* @param enable true to enable
+			* @return result code
+			*/
+			Result SetFastLoad(bool enable) throw();
+
+			/**
+			* Checks if fast disk loading is enabled.
+			*
+			* @return true if enabled
+			*/
+			bool IsFastLoadEnabled() const throw();
+
 			/**
 			* Returns the total number of disks.
 			*
@@ -0,0 +1,362 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <new>
+#include <sstream>
+#include "../NstMachine.hpp"
+#include "../NstThread.hpp"
+#include "../input/NstInpDevice.hpp"
+#include "NstApiMachine.hpp"
+#include "NstApiLockstep.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		struct Lockstep::Impl
+		{
+			struct Instance
+			{
+				Instance()
+				: emulator(NULL), result(RESULT_OK) {}
+
+				Emulator* emulator;
+				Result result;
+				std::stringstream snapshot;
+			};
+
+			explicit Impl(uint);
+			~Impl();
+
+			Result Run(Core::Thread::Job);
+			void Observe(Core::Machine&,uchar*) const;
+
+			static void NST_CALL StepInstance(void*,uint);
+			static void NST_CALL CaptureInstance(void*,uint);
+			static void NST_CALL RestoreInstance(void*,uint);
+
+			Core::Thread::Pool pool;
+			Instance* instances;
+			uint count;
+			Observation observation;
+			uint ramOffset;
+			uint ramLength;
+			bool captured;
+
+			Core::Input::Controllers* input;
+			uchar* observations;
+			ulong stride;
+			uchar* ram;
+			uint frames;
+			const uchar* mask;
+		};
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Lockstep::Impl::Impl(uint threads)
+		:
+		pool         (threads),
+		instances    (NULL),
+		count        (0),
+		observation  (OBSERVE_INDICES),
+		ramOffset    (0),
+		ramLength    (0),
+		captured     (false),
+		input        (NULL),
+		observations (NULL),
+		stride       (0),
+		ram          (NULL),
+		frames       (0),
+		mask         (NULL)
+		{
+		}
+
+		Lockstep::Impl::~Impl()
+		{
+			delete [] instances;
+		}
+
+		Lockstep::Lockstep(uint threads)
+		: impl(new Impl(threads))
+		{
+		}
+
+		Lockstep::~Lockstep() throw()
+		{
+			delete impl;
+		}
+
+		Result Lockstep::Attach(Emulator* const* emulators,const uint count) throw()
+		{
+			if (count && !emulators)
+				return RESULT_ERR_INVALID_PARAM;
+
+			for (uint i=0; i < count; ++i)
+			{
+				if (!emulators[i])
+					return RESULT_ERR_INVALID_PARAM;
+			}
+
+			Impl::Instance* instances = NULL;
+
+			if (count)
+			{
+				instances = new (std::nothrow) Impl::Instance [count];
+
+				if (!instances)
+					return RESULT_ERR_OUT_OF_MEMORY;
+
+				for (uint i=0; i < count; ++i)
+					instances[i].emulator = emulators[i];
+			}
+
+			delete [] impl->instances;
+
+			impl->instances = instances;
+			impl->count = count;
+			impl->captured = false;
+
+			return RESULT_OK;
+		}
+
+		uint Lockstep::NumInstances() const throw()
+		{
+			return impl->count;
+		}
+
+		uint Lockstep::NumThreads() const throw()
+		{
+			return impl->pool.Size();
+		}
+
+		void Lockstep::SetObservation(Observation observation) throw()
+		{
+			impl->observation = observation;
+		}
+
+		Lockstep::Observation Lockstep::GetObservation() const throw()
+		{
+			return impl->observation;
+		}
+
+		ulong Lockstep::GetObservationSize() const throw()
+		{
+			switch (impl->observation)
+			{
+				case OBSERVE_INDICES:
+				case OBSERVE_GRAYSCALE: return ulong(WIDTH) * HEIGHT;
+				case OBSERVE_RGB_HALF:  return ulong(RGB_WIDTH) * RGB_HEIGHT * 3;
+				case OBSERVE_INDICES16: return ulong(WIDTH) * HEIGHT * 2;
+				default:                return 0;
+			}
+		}
+
+		Result Lockstep::SetRamSlice(const uint offset,const uint length) throw()
+		{
+			if (offset > RAM_SIZE || length > RAM_SIZE - offset)
+				return RESULT_ERR_INVALID_PARAM;
+
+			impl->ramOffset = offset;
+			impl->ramLength = length;
+
+			return RESULT_OK;
+		}
+
+		uint Lockstep::GetRamSliceSize() const throw()
+		{
+			return impl->ramLength;
+		}
+
+		Result Lockstep::Impl::Run(const Core::Thread::Job job)
+		{
+			pool.Run( job, this, count );
+
+			for (uint i=0; i < count; ++i)
+			{
+				if (NES_FAILED(instances[i].result))
+					return instances[i].result;
+			}
+
+			return RESULT_OK;
+		}
+
+		void NST_CALL Lockstep::Impl::CaptureInstance(void* data,const uint index)
+		{
+			Instance& instance = static_cast<Impl*>(data)->instances[index];
+
+			instance.snapshot.str( std::string() );
+			instance.snapshot.clear();
+
+			instance.result = Machine(*instance.emulator).SaveState( instance.snapshot, Machine::NO_COMPRESSION );
+		}
+
+		void NST_CALL Lockstep::Impl::RestoreInstance(void* data,const uint index)
+		{
+			const Impl& impl = *static_cast<Impl*>(data);
+			Instance& instance = impl.instances[index];
+
+			if (impl.mask && !impl.mask[index])
+			{
+				instance.result = RESULT_NOP;
+				return;
+			}
+
+			instance.snapshot.clear();
+			instance.snapshot.seekg( 0, std::stringstream::beg );
+
+			instance.result = Machine(*instance.emulator).LoadState( instance.snapshot );
+		}
+
+		Result Lockstep::Capture() throw()
+		{
+			if (!impl->count)
+				return RESULT_ERR_NOT_READY;
+
+			const Result result = impl->Run( Impl::CaptureInstance );
+			impl->captured = NES_SUCCEEDED(result);
+
+			return result;
+		}
+
+		Result Lockstep::Restore(const uchar* const mask) throw()
+		{
+			if (!impl->captured)
+				return RESULT_ERR_NOT_READY;
+
+			impl->mask = mask;
+
+			return impl->Run( Impl::RestoreInstance );
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		void Lockstep::Impl::Observe(Core::Machine& machine,uchar* NST_RESTRICT dst) const
+		{
+			typedef Core::Video::Screen Screen;
+
+			const Screen::Pixel* NST_RESTRICT src = machine.ppu.GetScreen().pixels;
+
+			switch (observation)
+			{
+				case OBSERVE_INDICES:
+
+					for (uint i=0; i < Screen::PIXELS; ++i)
+						dst[i] = src[i] & 0x3F;
+
+					break;
+
+				case OBSERVE_INDICES16:
+
+					for (uint i=0; i < Screen::PIXELS; ++i)
+					{
+						dst[i*2+0] = src[i] & 0xFF;
+						dst[i*2+1] = src[i] >> 8;
+					}
+					break;
+
+				case OBSERVE_GRAYSCALE:
+				{
+					const Core::Video::Renderer::PaletteEntries& palette = machine.renderer.GetPalette();
+					uchar luma[Screen::PALETTE];
+
+					for (uint i=0; i < Screen::PALETTE; ++i)
+						luma[i] = (palette[i][0] * 77U + palette[i][1] * 150U + palette[i][2] * 29U) >> 8;
+
+					for (uint i=0; i < Screen::PIXELS; ++i)
+						dst[i] = luma[src[i]];
+
+					break;
+				}
+
+				case OBSERVE_RGB_HALF:
+				{
+					const Core::Video::Renderer::PaletteEntries& palette = machine.renderer.GetPalette();
+
+					for (uint y=0; y < Screen::HEIGHT; y += 2, src += Screen::WIDTH * 2)
+					{
+						for (uint x=0; x < Screen::WIDTH; x += 2, dst += 3)
+						{
+							const byte* const rgb = palette[src[x]];
+
+							dst[0] = rgb[0];
+							dst[1] = rgb[1];
+							dst[2] = rgb[2];
+						}
+					}
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+
+		void NST_CALL Lockstep::Impl::StepInstance(void* data,const uint index)
+		{
+			const Impl& impl = *static_cast<Impl*>(data);
+			Instance& instance = impl.instances[index];
+			Core::Input::Controllers* const input = impl.input ? impl.input + index : NULL;
+
+			Result result = RESULT_OK;
+
+			for (uint i=0; i < impl.frames && NES_SUCCEEDED(result); ++i)
+				result = instance.emulator->Execute( NULL, NULL, input );
+
+			instance.result = result;
+
+			Core::Machine& machine = *instance.emulator;
+
+			if (impl.observations && impl.observation != OBSERVE_NONE)
+				impl.Observe( machine, impl.observations + index * impl.stride );
+
+			if (impl.ram && impl.ramLength)
+				std::memcpy( impl.ram + index * impl.ramLength, machine.cpu.GetRam() + impl.ramOffset, impl.ramLength );
+		}
+
+		Result Lockstep::Step
+		(
+			Core::Input::Controllers* const input,
+			uchar* const observations,
+			uchar* const ram,
+			const uint frames
+		)   throw()
+		{
+			if (!impl->count)
+				return RESULT_ERR_NOT_READY;
+
+			impl->input = input;
+			impl->observations = observations;
+			impl->stride = GetObservationSize();
+			impl->ram = ram;
+			impl->frames = frames;
+
+			return impl->Run( Impl::StepInstance );
+		}
+	}
+}
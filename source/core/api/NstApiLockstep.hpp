@@ -0,0 +1,230 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_API_LOCKSTEP_H
+#define NST_API_LOCKSTEP_H
+
+#include "NstApiEmulator.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* Batched lockstep execution interface.
+		*
+		* Steps a set of emulator instances together on a pool of worker threads and
+		* writes their observations into one caller-provided buffer. Each instance must
+		* have an image loaded and powered on and must not be used by anything else while
+		* a step is in progress. Input callbacks and the user callbacks of the instances
+		* are invoked from the worker threads.
+		*
+		* All emulation state belongs to its instance. The only state shared between
+		* instances is the callbacks and the FDS BIOS image. Neither may be changed
+		* while a step is in progress.
+		*/
+		class Lockstep
+		{
+		public:
+
+			/**
+			* Constructor.
+			*
+			* @param threads number of threads including the calling one, 0 for one per processor
+			*/
+			explicit Lockstep(uint threads=0);
+
+			~Lockstep() throw();
+
+			enum
+			{
+				/**
+				* Width of the full-size observations.
+				*/
+				WIDTH = 256,
+				/**
+				* Height of the full-size observations.
+				*/
+				HEIGHT = 240,
+				/**
+				* Width of the RGB observation.
+				*/
+				RGB_WIDTH = WIDTH / 2,
+				/**
+				* Height of the RGB observation.
+				*/
+				RGB_HEIGHT = HEIGHT / 2,
+				/**
+				* Size of the internal CPU RAM available for RAM slices.
+				*/
+				RAM_SIZE = 0x800
+			};
+
+			/**
+			* Observation format.
+			*/
+			enum Observation
+			{
+				/**
+				* No screen output.
+				*/
+				OBSERVE_NONE,
+				/**
+				* One byte per pixel, palette index 0-63 without the emphasis bits.
+				*/
+				OBSERVE_INDICES,
+				/**
+				* One byte per pixel, luminance of the current palette.
+				*/
+				OBSERVE_GRAYSCALE,
+				/**
+				* Three bytes per pixel, RGB of the current palette, every second pixel and line.
+				*/
+				OBSERVE_RGB_HALF,
+				/**
+				* Two bytes per pixel, little-endian, the full 9-bit index as written by
+				* the PPU. Bits 0-5 hold the palette index, bits 6-8 the emphasis bits.
+				*/
+				OBSERVE_INDICES16
+			};
+
+			/**
+			* Sets the instances to step.
+			*
+			* Any captured snapshots are discarded.
+			*
+			* @param emulators array of emulator instances
+			* @param count number of instances
+			* @return result code
+			*/
+			Result Attach(Emulator* const* emulators,uint count) throw();
+
+			/**
+			* Returns the number of attached instances.
+			*
+			* @return number
+			*/
+			uint NumInstances() const throw();
+
+			/**
+			* Returns the number of threads used.
+			*
+			* @return number
+			*/
+			uint NumThreads() const throw();
+
+			/**
+			* Sets the observation format.
+			*
+			* @param observation format
+			*/
+			void SetObservation(Observation observation) throw();
+
+			/**
+			* Returns the observation format.
+			*
+			* @return format
+			*/
+			Observation GetObservation() const throw();
+
+			/**
+			* Returns the size of one instance's observation.
+			*
+			* @return size in bytes
+			*/
+			ulong GetObservationSize() const throw();
+
+			/**
+			* Selects the part of the internal CPU RAM copied out after each step.
+			*
+			* @param offset start address
+			* @param length number of bytes, 0 to disable
+			* @return result code, RESULT_ERR_INVALID_PARAM if outside RAM_SIZE
+			*/
+			Result SetRamSlice(uint offset,uint length) throw();
+
+			/**
+			* Returns the size of one instance's RAM slice.
+			*
+			* @return size in bytes
+			*/
+			uint GetRamSliceSize() const throw();
+
+			/**
+			* Steps all instances.
+			*
+			* Observations and RAM slices are taken after the last frame and stored back to
+			* back in instance order, GetObservationSize() and GetRamSliceSize() bytes apart.
+			*
+			* @param input array of controller states, one per instance, or NULL for no input
+			* @param observations buffer for the observations or NULL to skip them
+			* @param ram buffer for the RAM slices or NULL to skip them
+			* @param frames number of frames to execute with the same input
+			* @return result code, the first error of any instance
+			*/
+			Result Step
+			(
+				Core::Input::Controllers* input,
+				uchar* observations,
+				uchar* ram,
+				uint frames=1
+			)   throw();
+
+			/**
+			* Takes an in-memory snapshot of every instance.
+			*
+			* @return result code
+			*/
+			Result Capture() throw();
+
+			/**
+			* Restores instances to their snapshots.
+			*
+			* @param mask array with one entry per instance, nonzero to restore, or NULL for all
+			* @return result code, RESULT_ERR_NOT_READY if no snapshot was captured
+			*/
+			Result Restore(const uchar* mask=NULL) throw();
+
+		private:
+
+			struct Impl;
+			Impl* const impl;
+		};
+	}
+}
+
+#if NST_MSVC >= 1200
+#pragma warning( pop )
+#endif
+
+#endif
@@ -26,6 +26,7 @@
 #include "../NstMachine.hpp"
 #include "../NstImage.hpp"
 #include "../NstState.hpp"
+#include "../NstThread.hpp"
 #include "NstApiMachine.hpp"
 
 namespace Nes
@@ -192,6 +193,20 @@ namespace Nes
 			return RESULT_OK;
 		}
 
+		Result Machine::SetCpuFetch(const CpuFetch fetch) throw()
+		{
+			if (fetch == GetCpuFetch())
+				return RESULT_NOP;
+
+			emulator.cpu.SetDirectFetch( fetch == CPU_FETCH_DIRECT );
+			return RESULT_OK;
+		}
+
+		Machine::CpuFetch Machine::GetCpuFetch() const throw()
+		{
+			return emulator.cpu.GetDirectFetch() ? CPU_FETCH_DIRECT : CPU_FETCH_MAPPED;
+		}
+
 		Machine::Mode Machine::GetMode() const throw()
 		{
 			return static_cast<Mode>(Is(NTSC|PAL));
@@ -228,7 +243,7 @@ namespace Nes
 			try
 			{
 				emulator.tracker.Resync();
-				Core::State::Loader loader( &stream, true );
+				Core::State::Loader loader( &stream, true, &emulator.stateReference );
 
 				if (emulator.LoadState( loader, true ))
 					return RESULT_OK;
@@ -249,14 +264,29 @@ namespace Nes
 			}
 		}
 
-		Result Machine::SaveState(std::ostream& stream,Compression compression) const throw()
+		Result Machine::SaveState(std::ostream& stream,const uint compression) const throw()
 		{
-			if (!Is(GAME,ON))
+			return Save( stream, compression, false );
+		}
+
+		Result Machine::SaveReferenceState(std::ostream& stream,const uint compression) throw()
+		{
+			const Result result = Save( stream, compression, true );
+
+			if (NES_FAILED(result))
+				emulator.stateReference.Clear();
+
+			return result;
+		}
+
+		Result Machine::SaveIncrementalState(std::ostream& stream) const throw()
+		{
+			if (!Is(GAME,ON) || emulator.stateReference.Empty())
 				return RESULT_ERR_NOT_READY;
 
 			try
 			{
-				Core::State::Saver saver( &stream, compression != NO_COMPRESSION, false );
+				Core::State::Saver saver( &stream, Core::State::DELTA_COMPRESSION, false, 0, NULL, &emulator.stateReference );
 				emulator.SaveState( saver );
 			}
 			catch (Result result)
@@ -275,6 +305,102 @@ namespace Nes
 			return RESULT_OK;
 		}
 
+		void Machine::ClearReferenceState() throw()
+		{
+			emulator.stateReference.Clear();
+		}
+
+		Result Machine::HashState(StateHash& hash) const throw()
+		{
+			if (!Is(GAME,ON))
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				Core::State::Hash state;
+
+				{
+					Core::State::Saver saver( state, emulator.hashCache );
+					emulator.SaveState( saver );
+				}
+
+				const qaword digest = state.Digest();
+
+				hash.hi = dword(digest >> 32);
+				hash.lo = dword(digest & 0xFFFFFFFF);
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result Machine::Save(std::ostream& stream,const uint compression,const bool reference) const
+		{
+			if (!Is(GAME,ON))
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				uint type;
+
+				switch (compression & ~uint(PARALLEL_COMPRESSION))
+				{
+					case USE_COMPRESSION:  type = Core::State::ZLIB_COMPRESSION; break;
+					case FAST_COMPRESSION: type = Core::State::LZ_COMPRESSION;   break;
+					default:               type = Core::State::NO_COMPRESSION;   break;
+				}
+
+				Core::State::Reference* const target = (reference ? &emulator.stateReference : NULL);
+
+				if (type != Core::State::NO_COMPRESSION && (compression & PARALLEL_COMPRESSION) && Core::Thread::AVAILABLE)
+				{
+					// first pass only collects the blocks to compress, second pass writes them
+
+					Core::State::Batch batch( type );
+
+					{
+						Core::State::Saver saver( batch );
+						emulator.SaveState( saver );
+					}
+
+					batch.Run();
+
+					Core::State::Saver saver( &stream, type, false, 0, &batch, target );
+					emulator.SaveState( saver );
+				}
+				else
+				{
+					Core::State::Saver saver( &stream, type, false, 0, NULL, target );
+					emulator.SaveState( saver );
+				}
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
@@ -131,6 +131,21 @@ namespace Nes
 				ASK_PROFILE
 			};
 
+			/**
+			* CPU instruction fetch path.
+			*/
+			enum CpuFetch
+			{
+				/**
+				* All instruction bytes are read through the I/O map (default).
+				*/
+				CPU_FETCH_MAPPED,
+				/**
+				* Instruction bytes in plain PRG-ROM banks are read directly from the bank memory.
+				*/
+				CPU_FETCH_DIRECT
+			};
+
 			enum
 			{
 				CLK_NTSC_DOT   = Core::CLK_NTSC,
@@ -173,6 +188,40 @@ namespace Nes
 				: stream(s), bypassChecksum(b), result(RESULT_NOP) {}
 			};
 
+			/**
+			* Machine state hash.
+			*
+			* 64-bit digest split in two halves.
+			*/
+			struct StateHash
+			{
+				/**
+				* Upper 32 bits.
+				*/
+				dword hi;
+
+				/**
+				* Lower 32 bits.
+				*/
+				dword lo;
+
+				/**
+				* Constructor.
+				*/
+				StateHash()
+				: hi(0), lo(0) {}
+
+				bool operator == (const StateHash& hash) const
+				{
+					return hi == hash.hi && lo == hash.lo;
+				}
+
+				bool operator != (const StateHash& hash) const
+				{
+					return hi != hash.hi || lo != hash.lo;
+				}
+			};
+
 			/**
 			* Loads any image. Input stream can be in XML, iNES, UNIF, FDS or NSF format.
 			*
@@ -264,6 +313,26 @@ namespace Nes
 			*/
 			Result SetRamPowerState(uint state) throw();
 
+			/**
+			* Sets the CPU instruction fetch path.
+			*
+			* Both paths are cycle exact and produce the same output. Banks
+			* whose reads are intercepted by the mapper, cheats or other
+			* devices always take the mapped path. Switching to the direct
+			* path takes effect on the next power-on or reset.
+			*
+			* @param fetch fetch path
+			* @return result code
+			*/
+			Result SetCpuFetch(CpuFetch fetch) throw();
+
+			/**
+			* Returns the CPU instruction fetch path.
+			*
+			* @return fetch path
+			*/
+			CpuFetch GetCpuFetch() const throw();
+
 			/**
 			* Returns the current mode.
 			*
@@ -296,9 +365,17 @@ namespace Nes
 				*/
 				NO_COMPRESSION,
 				/**
-				* Compression enabled (default).
+				* Compression enabled (default). Uses zlib.
+				*/
+				USE_COMPRESSION,
+				/**
+				* Fast compression. Quicker to save and load than zlib but with a lower ratio.
+				*/
+				FAST_COMPRESSION,
+				/**
+				* May be OR:ed with USE_COMPRESSION or FAST_COMPRESSION to compress the memory blocks of the state in parallel.
 				*/
-				USE_COMPRESSION
+				PARALLEL_COMPRESSION = 0x10
 			};
 
 			/**
@@ -313,10 +390,51 @@ namespace Nes
 			* Saves a state.
 			*
 			* @param stream output stream which the state will be written to
-			* @param compression to allow internal compression in the state, default is USE_COMPRESSION
+			* @param compression OR:ed Compression flags, default is USE_COMPRESSION
+			* @return result code
+			*/
+			Result SaveState(std::ostream& stream,uint compression=USE_COMPRESSION) const throw();
+
+			/**
+			* Saves a state and keeps its memory blocks as the reference for incremental states.
+			*
+			* @param stream output stream which the state will be written to
+			* @param compression OR:ed Compression flags, default is USE_COMPRESSION
+			* @return result code
+			*/
+			Result SaveReferenceState(std::ostream& stream,uint compression=USE_COMPRESSION) throw();
+
+			/**
+			* Saves an incremental state.
+			*
+			* Memory blocks such as RAM, VRAM and disk sides are stored as the pages that changed
+			* since the reference state, everything else is stored in full. The result is loaded
+			* with LoadState() which fails with RESULT_ERR_INVALID_CRC unless the same reference
+			* state is in place.
+			*
+			* @param stream output stream which the state will be written to
+			* @return result code, RESULT_ERR_NOT_READY if no reference state has been saved
+			*/
+			Result SaveIncrementalState(std::ostream& stream) const throw();
+
+			/**
+			* Releases the reference state.
+			*/
+			void ClearReferenceState() throw();
+
+			/**
+			* Hashes the machine state.
+			*
+			* Covers the same data as SaveState() without building or compressing a
+			* save. Two machines that hash equal would have written identical states,
+			* which makes it cheap enough to run every frame for desync detection in
+			* netplay, movies or rewind. CPU RAM and OAM are hashed again only when
+			* they have been written since the previous call.
+			*
+			* @param hash hash to be filled in
 			* @return result code
 			*/
-			Result SaveState(std::ostream& stream,Compression compression=USE_COMPRESSION) const throw();
+			Result HashState(StateHash& hash) const throw();
 
 			/**
 			* Returns a machine state.
@@ -409,6 +527,7 @@ namespace Nes
 		private:
 
 			Result Load(std::istream&,FavoredSystem,AskProfile,Patch*,uint);
+			Result Save(std::ostream&,uint,bool) const;
 		};
 
 		/**
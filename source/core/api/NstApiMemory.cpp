@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../NstMachine.hpp"
+#include "../NstImage.hpp"
+#include "NstApiMachine.hpp"
+#include "NstApiMemory.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		const uchar* Memory::GetData(Type type) const throw()
+		{
+			switch (type)
+			{
+				case CPU_RAM:
+
+					return emulator.cpu.GetRam();
+
+				case WORK_RAM:
+
+					if (emulator.image)
+					{
+						dword size;
+						return emulator.image->GetWram( size );
+					}
+					break;
+
+				case VIDEO_RAM:
+
+					return emulator.ppu.GetNameTableRam();
+
+				case CHR_RAM:
+
+					if (emulator.image)
+					{
+						const Core::Ppu::ChrMem& chr = emulator.ppu.GetChrMem();
+
+						for (uint i=0; i < 2; ++i)
+						{
+							if (chr.Source(i).GetType() != Core::Ram::ROM && chr.Source(i).Size())
+								return chr.Source(i).Mem();
+						}
+					}
+					break;
+
+				case OAM_RAM:
+
+					return emulator.ppu.GetOamRam();
+
+				case PALETTE_RAM:
+
+					return emulator.ppu.GetPalette().ram;
+
+				default:
+
+					break;
+			}
+
+			return NULL;
+		}
+
+		ulong Memory::GetSize(Type type) const throw()
+		{
+			switch (type)
+			{
+				case CPU_RAM:
+
+					return Core::Cpu::RAM_SIZE;
+
+				case WORK_RAM:
+
+					if (emulator.image)
+					{
+						dword size;
+						emulator.image->GetWram( size );
+						return size;
+					}
+					break;
+
+				case VIDEO_RAM:
+
+					return Core::Ppu::NMT_RAM_SIZE;
+
+				case CHR_RAM:
+
+					if (emulator.image)
+					{
+						const Core::Ppu::ChrMem& chr = emulator.ppu.GetChrMem();
+
+						for (uint i=0; i < 2; ++i)
+						{
+							if (chr.Source(i).GetType() != Core::Ram::ROM && chr.Source(i).Size())
+								return chr.Source(i).Size();
+						}
+					}
+					break;
+
+				case OAM_RAM:
+
+					return Core::Ppu::OAM_SIZE;
+
+				case PALETTE_RAM:
+
+					return Core::Ppu::PALETTE_SIZE;
+
+				default:
+
+					break;
+			}
+
+			return 0;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		ulong Memory::GetGeneration(Type type) const throw()
+		{
+			NST_COMPILE_ASSERT( uint(NUM_TYPES) == uint(Core::Machine::NUM_MEMORY_WATCHES) );
+
+			if (uint(type) >= NUM_TYPES)
+				return 0;
+
+			dword writes;
+
+			switch (type)
+			{
+				case CPU_RAM:     writes = emulator.cpu.GetWriteCount( 0x0000 ) + emulator.cpu.GetWriteCount( 0x10000 ); break;
+				case VIDEO_RAM:   writes = emulator.ppu.GetWriteCount( Core::Ppu::WRITES_NMT     ); break;
+				case CHR_RAM:     writes = emulator.ppu.GetWriteCount( Core::Ppu::WRITES_CHR     ); break;
+				case OAM_RAM:     writes = emulator.ppu.GetWriteCount( Core::Ppu::WRITES_OAM     ); break;
+				case PALETTE_RAM: writes = emulator.ppu.GetWriteCount( Core::Ppu::WRITES_PALETTE ); break;
+				default:
+
+					// the disk system maps its RAM up to $DFFF
+
+					writes = emulator.cpu.GetWriteCount( 0x6000 );
+
+					if (emulator.Is(Machine::DISK))
+					{
+						for (uint address=0x8000; address < 0xE000; address += Core::SIZE_8K)
+							writes += emulator.cpu.GetWriteCount( address );
+					}
+					break;
+			}
+
+			Core::Machine::MemoryWatch& watch = emulator.memoryWatches[type];
+
+			if (watch.writes != writes || watch.epoch != emulator.memoryEpoch)
+			{
+				watch.writes = writes;
+				watch.epoch = emulator.memoryEpoch;
+				watch.generation++;
+			}
+
+			return watch.generation;
+		}
+	}
+}
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_API_MEMORY_H
+#define NST_API_MEMORY_H
+
+#include "NstApi.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_ICC >= 810
+#pragma warning( push )
+#pragma warning( disable : 444 )
+#elif NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* Memory introspection interface.
+		*
+		* Gives read-only access to the emulated memory regions without going through
+		* a save state. The returned pointers refer to the live emulator memory and stay
+		* valid until the current image is unloaded. CPU_RAM stays valid for the lifetime
+		* of the emulator object.
+		*/
+		class Memory : public Base
+		{
+		public:
+
+			/**
+			* Interface constructor.
+			*
+			* @param instance emulator instance
+			*/
+			template<typename T>
+			Memory(T& instance)
+			: Base(instance) {}
+
+			/**
+			* Memory region.
+			*/
+			enum Type
+			{
+				/**
+				* 2k internal CPU RAM at $0000-$07FF.
+				*/
+				CPU_RAM,
+				/**
+				* Work RAM at $6000, cartridge WRAM/SRAM, FDS RAM or NSF RAM.
+				*/
+				WORK_RAM,
+				/**
+				* 2k internal name-table RAM (CIRAM).
+				*/
+				VIDEO_RAM,
+				/**
+				* CHR-RAM, if the board has any.
+				*/
+				CHR_RAM,
+				/**
+				* 256 bytes of sprite attribute memory.
+				*/
+				OAM_RAM,
+				/**
+				* 32 bytes of palette RAM.
+				*/
+				PALETTE_RAM,
+				/**
+				* Number of memory regions.
+				*/
+				NUM_TYPES
+			};
+
+			/**
+			* Returns a pointer to a memory region.
+			*
+			* @param type region
+			* @return pointer to memory or NULL if the region is not present
+			*/
+			const uchar* GetData(Type type) const throw();
+
+			/**
+			* Returns the size of a memory region.
+			*
+			* @param type region
+			* @return size in bytes or 0 if the region is not present
+			*/
+			ulong GetSize(Type type) const throw();
+
+			/**
+			* Returns the change generation of a memory region.
+			*
+			* The value is increased whenever the region may have been written since the
+			* previous call, so polling it once per frame tells if anything needs to be
+			* copied or compared. Writes are counted where the CPU and PPU make them, along
+			* with RAM cheat codes and NSF song setup, and loading, resets and state loads
+			* count as well. A call is cheap, but a write that stores the value already
+			* there also counts as a change.
+			*
+			* @param type region
+			* @return generation
+			*/
+			ulong GetGeneration(Type type) const throw();
+		};
+	}
+}
+
+#if NST_MSVC >= 1200 || NST_ICC >= 810
+#pragma warning( pop )
+#endif
+
+#endif
@@ -42,9 +42,14 @@ namespace Nes
 			return emulator.tracker.PlayMovie( emulator, stream );
 		}
 
-		Result Movie::Record(std::iostream& stream,How how) throw()
+		Result Movie::Record(std::iostream& stream,How how,ulong keyFrameInterval) throw()
 		{
-			return emulator.tracker.RecordMovie( emulator, stream, how == APPEND );
+			return emulator.tracker.RecordMovie( emulator, stream, how == APPEND, keyFrameInterval );
+		}
+
+		Result Movie::Seek(ulong frame) throw()
+		{
+			return emulator.tracker.SeekMovie( emulator, frame );
 		}
 
 		void Movie::Stop() throw()
@@ -90,9 +90,21 @@ namespace Nes
 			*
 			* @param stream stream to record movie to
 			* @param how CLEAN to erase any previous content, APPEND to keep content, default is CLEAN
+			* @param keyFrameInterval number of frames between embedded save states, 0 to only store them on resync, default is 0
 			* @return result code
 			*/
-			Result Record(std::iostream& stream,How how=CLEAN) throw();
+			Result Record(std::iostream& stream,How how=CLEAN,ulong keyFrameInterval=0) throw();
+
+			/**
+			* Seeks to a frame in the movie being played.
+			*
+			* Restores the nearest preceding key frame and runs the remaining
+			* frames without video and sound output.
+			*
+			* @param frame frame number, counted from the start of the movie
+			* @return result code
+			*/
+			Result Seek(ulong frame) throw();
 
 			/**
 			* Stops movie.
@@ -0,0 +1,354 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <new>
+#include <string>
+#include <sstream>
+#include "../NstMachine.hpp"
+#include "NstApiPool.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		struct Pool::Impl
+		{
+			struct Game;
+
+			struct Instance
+			{
+				explicit Instance(Game& g)
+				: game(g), busy(false) {}
+
+				Game& game;
+				Emulator emulator;
+				bool busy;
+			};
+
+			struct Game
+			{
+				explicit Game(Machine::FavoredSystem s)
+				: system(s) {}
+
+				~Game();
+
+				Instance* Launch();
+				void Pin(Core::Machine&);
+				void Restore(Core::Machine&);
+
+				const Machine::FavoredSystem system;
+				std::string image;
+				std::stringstream snapshot;
+				Core::State::Reference reference;
+				Core::Vector<Instance*> instances;
+			};
+
+			~Impl();
+
+			void Clear();
+			Game* Find(uint) const;
+			Instance* Find(const Emulator*) const;
+
+			Core::Vector<Game*> games;
+		};
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Pool::Impl::Game::~Game()
+		{
+			for (Instance** it=instances.Begin(), **const end=instances.End(); it != end; ++it)
+				delete *it;
+		}
+
+		Pool::Impl::Instance* Pool::Impl::Game::Launch()
+		{
+			Instance* const instance = new Instance( *this );
+
+			try
+			{
+				std::istringstream stream( image );
+				Machine machine( instance->emulator );
+
+				Result result = machine.Load( stream, system );
+
+				if (NES_SUCCEEDED(result))
+					result = machine.Power( true );
+
+				if (NES_FAILED(result))
+					throw result;
+
+				instances.Append( instance );
+			}
+			catch (...)
+			{
+				delete instance;
+				throw;
+			}
+
+			return instance;
+		}
+
+		void Pool::Impl::Game::Pin(Core::Machine& machine)
+		{
+			// the full state captures every memory region into the reference, the delta
+			// taken right after it only holds the registers and the unchanged page maps
+
+			{
+				std::stringstream scratch;
+				Core::State::Saver saver( &scratch, Core::State::NO_COMPRESSION, false, 0, NULL, &reference );
+				machine.SaveState( saver );
+			}
+
+			snapshot.str( std::string() );
+			snapshot.clear();
+
+			Core::State::Saver saver( &snapshot, Core::State::DELTA_COMPRESSION, false, 0, NULL, &reference );
+			machine.SaveState( saver );
+		}
+
+		void Pool::Impl::Game::Restore(Core::Machine& machine)
+		{
+			snapshot.clear();
+			snapshot.seekg( 0, std::stringstream::beg );
+
+			// memory blocks are copied straight from the reference by the delta loader,
+			// only the registers and bank maps are parsed from the snapshot stream
+
+			machine.tracker.Resync();
+			Core::State::Loader loader( &snapshot, true, &reference );
+
+			if (!machine.LoadState( loader, true ))
+				throw RESULT_ERR_INVALID_CRC;
+		}
+
+		Pool::Impl::~Impl()
+		{
+			Clear();
+		}
+
+		void Pool::Impl::Clear()
+		{
+			for (Game** it=games.Begin(), **const end=games.End(); it != end; ++it)
+				delete *it;
+
+			games.Destroy();
+		}
+
+		Pool::Impl::Game* Pool::Impl::Find(const uint game) const
+		{
+			return game < games.Size() ? games[game] : NULL;
+		}
+
+		Pool::Impl::Instance* Pool::Impl::Find(const Emulator* const emulator) const
+		{
+			for (Game** it=games.Begin(), **const end=games.End(); it != end; ++it)
+			{
+				const Core::Vector<Instance*>& instances = (*it)->instances;
+
+				for (dword i=0; i < instances.Size(); ++i)
+				{
+					if (&instances[i]->emulator == emulator)
+						return instances[i];
+				}
+			}
+
+			return NULL;
+		}
+
+		Pool::Pool()
+		: impl(new Impl)
+		{
+		}
+
+		Pool::~Pool() throw()
+		{
+			delete impl;
+		}
+
+		Result Pool::Add(std::istream& stream,uint count,const Machine::FavoredSystem system,uint* const index) throw()
+		{
+			Impl::Game* game = NULL;
+
+			try
+			{
+				game = new Impl::Game( system );
+
+				{
+					std::ostringstream image;
+					image << stream.rdbuf();
+					game->image = image.str();
+				}
+
+				if (game->image.empty())
+					throw RESULT_ERR_INVALID_FILE;
+
+				game->Pin( game->Launch()->emulator );
+
+				for (uint i=1; i < count; ++i)
+					game->Launch();
+
+				impl->games.Append( game );
+			}
+			catch (Result result)
+			{
+				delete game;
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				delete game;
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				delete game;
+				return RESULT_ERR_GENERIC;
+			}
+
+			if (index)
+				*index = impl->games.Size() - 1;
+
+			return RESULT_OK;
+		}
+
+		void Pool::Clear() throw()
+		{
+			impl->Clear();
+		}
+
+		uint Pool::NumGames() const throw()
+		{
+			return impl->games.Size();
+		}
+
+		uint Pool::NumInstances(const uint index) const throw()
+		{
+			const Impl::Game* const game = impl->Find( index );
+			return game ? game->instances.Size() : 0;
+		}
+
+		uint Pool::NumIdle(const uint index) const throw()
+		{
+			uint idle = 0;
+
+			if (const Impl::Game* const game = impl->Find( index ))
+			{
+				for (dword i=0; i < game->instances.Size(); ++i)
+					idle += !game->instances[i]->busy;
+			}
+
+			return idle;
+		}
+
+		Result Pool::Pin(Emulator& emulator) throw()
+		{
+			Impl::Instance* const instance = impl->Find( &emulator );
+
+			if (!instance || !instance->busy)
+				return RESULT_ERR_INVALID_PARAM;
+
+			if (!Machine(emulator).Is(Machine::GAME,Machine::ON))
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				instance->game.Pin( emulator );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		Emulator* Pool::Acquire(const uint index) throw()
+		{
+			Impl::Game* const game = impl->Find( index );
+
+			if (!game)
+				return NULL;
+
+			try
+			{
+				Impl::Instance* instance = NULL;
+
+				for (dword i=0; i < game->instances.Size(); ++i)
+				{
+					if (!game->instances[i]->busy)
+					{
+						instance = game->instances[i];
+						break;
+					}
+				}
+
+				if (!instance)
+					instance = game->Launch();
+
+				Machine machine( instance->emulator );
+
+				if (!machine.Is(Machine::GAME))
+					return NULL;
+
+				if (!machine.Is(Machine::ON) && NES_FAILED(machine.Power( true )))
+					return NULL;
+
+				game->Restore( instance->emulator );
+				instance->busy = true;
+
+				return &instance->emulator;
+			}
+			catch (...)
+			{
+				return NULL;
+			}
+		}
+
+		Result Pool::Release(Emulator* const emulator) throw()
+		{
+			Impl::Instance* const instance = impl->Find( emulator );
+
+			if (!instance || !instance->busy)
+				return RESULT_ERR_INVALID_PARAM;
+
+			instance->busy = false;
+
+			return RESULT_OK;
+		}
+	}
+}
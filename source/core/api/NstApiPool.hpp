@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_API_POOL_H
+#define NST_API_POOL_H
+
+#include <iosfwd>
+#include "NstApiEmulator.hpp"
+#include "NstApiMachine.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* Pool of loaded emulator instances.
+		*
+		* Keeps any number of powered on instances per game so that a session can start
+		* without loading, parsing and allocating anything. Every game has one pinned
+		* snapshot shared by all of its instances, and an instance handed out by Acquire()
+		* is restored to it by copying the saved memory regions back in place. The pool
+		* itself is not thread-safe, acquired instances may be run on any thread.
+		*/
+		class Pool
+		{
+		public:
+
+			Pool();
+
+			/**
+			* Destructor.
+			*
+			* Unloads all instances, battery data is saved through the usual callbacks.
+			*/
+			~Pool() throw();
+
+			/**
+			* Adds a game.
+			*
+			* The image is read into memory once and used for loading further instances.
+			* The snapshot is pinned right after power-on.
+			*
+			* @param stream input stream containing the image
+			* @param instances number of instances to load up front, at least one is always loaded
+			* @param system preferred console
+			* @param game index of the new game, optional
+			* @return result code
+			*/
+			Result Add(std::istream& stream,uint instances=1,Machine::FavoredSystem system=Machine::FAVORED_NES_NTSC,uint* game=NULL) throw();
+
+			/**
+			* Removes all games and unloads their instances.
+			*
+			* No instance may be acquired.
+			*/
+			void Clear() throw();
+
+			/**
+			* Returns the number of games.
+			*
+			* @return number
+			*/
+			uint NumGames() const throw();
+
+			/**
+			* Returns the number of loaded instances of a game.
+			*
+			* @param game game index
+			* @return number
+			*/
+			uint NumInstances(uint game) const throw();
+
+			/**
+			* Returns the number of idle instances of a game.
+			*
+			* @param game game index
+			* @return number
+			*/
+			uint NumIdle(uint game) const throw();
+
+			/**
+			* Hands out an instance restored to the game's snapshot.
+			*
+			* A new instance is loaded if all are in use.
+			*
+			* @param game game index
+			* @return instance or NULL on error
+			*/
+			Emulator* Acquire(uint game) throw();
+
+			/**
+			* Returns an instance to the pool.
+			*
+			* @param emulator instance from Acquire()
+			* @return result code, RESULT_ERR_INVALID_PARAM if not acquired from this pool
+			*/
+			Result Release(Emulator* emulator) throw();
+
+			/**
+			* Replaces a game's snapshot with the current state of one of its instances.
+			*
+			* Useful for starting sessions past boot or menu screens.
+			*
+			* @param emulator acquired instance
+			* @return result code
+			*/
+			Result Pin(Emulator& emulator) throw();
+
+		private:
+
+			struct Impl;
+			Impl* const impl;
+		};
+	}
+}
+
+#if NST_MSVC >= 1200
+#pragma warning( pop )
+#endif
+
+#endif
@@ -22,6 +22,7 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <new>
 #include "../NstMachine.hpp"
 #include "NstApiSound.hpp"
 
@@ -142,6 +143,23 @@ namespace Nes
 			return emulator.cpu.GetApu().InStereo() ? SPEAKER_STEREO : SPEAKER_MONO;
 		}
 
+		Result Sound::SetExpansionThread(bool enable) throw()
+		{
+			try
+			{
+				return emulator.cpu.GetApu().SetExpansionThread( enable );
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+		}
+
+		bool Sound::IsExpansionThreaded() const throw()
+		{
+			return emulator.cpu.GetApu().IsExpansionThreaded();
+		}
+
 		void Sound::EmptyBuffer() throw()
 		{
 			emulator.cpu.GetApu().ClearBuffers();
@@ -384,6 +384,26 @@ namespace Nes
 			*/
 			bool IsAudible() const throw();
 
+			/**
+			* Moves expansion sound synthesis to a worker thread.
+			*
+			* Only applies to the write-only VRC7 and N163 chips. Their register writes are
+			* logged with sample timestamps and replayed on the worker while the CPU keeps
+			* running, and the two halves are mixed when the frame ends. The output is
+			* identical to the inline path.
+			*
+			* @param enable true to enable
+			* @return result code, RESULT_ERR_UNSUPPORTED if threads aren't available
+			*/
+			Result SetExpansionThread(bool enable) throw();
+
+			/**
+			* Checks if expansion sound is synthesized on a worker thread.
+			*
+			* @return true if enabled
+			*/
+			bool IsExpansionThreaded() const throw();
+
 			/**
 			* Empties the internal sound buffer.
 			*/
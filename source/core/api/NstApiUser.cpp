@@ -32,6 +32,7 @@ namespace Nes
 		User::EventCaller    User::eventCallback;
 		User::QuestionCaller User::questionCallback;
 		User::FileIoCaller   User::fileIoCallback;
+		User::JournalCaller  User::journalCallback;
 
 		const wchar_t* User::File::GetName() const throw()
 		{
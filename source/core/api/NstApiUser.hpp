@@ -53,6 +53,7 @@ namespace Nes
 			struct EventCaller;
 			struct QuestionCaller;
 			struct FileIoCaller;
+			struct JournalCaller;
 
 		public:
 
@@ -382,6 +383,21 @@ namespace Nes
 			*/
 			typedef void (NST_CALLBACK *FileIoCallback) (UserData userData,File& file);
 
+			/**
+			* Save data journal callback prototype.
+			*
+			* Invoked at the end of every frame with the ranges of battery, EEPROM,
+			* disk or Turbo File data that changed since the previous frame. The
+			* data pointer is only valid for the duration of the call.
+			*
+			* @param userData optional user data
+			* @param action SAVE_xx action the data belongs to
+			* @param offset byte offset of the range within the save data
+			* @param data new content of the range
+			* @param length length of the range
+			*/
+			typedef void (NST_CALLBACK *JournalCallback) (UserData userData,File::Action action,ulong offset,const void* data,ulong length);
+
 			/**
 			* Logfile callback manager.
 			*
@@ -409,6 +425,14 @@ namespace Nes
 			* Static object used for adding the user defined callback.
 			*/
 			static FileIoCaller fileIoCallback;
+
+			/**
+			* Save data journal callback manager.
+			*
+			* Static object used for adding the user defined callback.
+			* Change tracking is only done while a callback is set.
+			*/
+			static JournalCaller journalCallback;
 		};
 
 		/**
@@ -471,6 +495,20 @@ namespace Nes
 					function( userdata, file );
 			}
 		};
+
+		/**
+		* Save data journal callback invoker.
+		*
+		* Used internally by the core.
+		*/
+		struct User::JournalCaller : Core::UserCallback<User::JournalCallback>
+		{
+			void operator () (File::Action action,ulong offset,const void* data,ulong length) const
+			{
+				if (function)
+					function( userdata, action, offset, data, length );
+			}
+		};
 	}
 }
 
@@ -436,6 +436,11 @@ namespace Nes
 				}
 
 				SubReset( hard );
+
+				cpu.SetFetchBank( 0x8000, prg.Slot(0), Io::Port( this, &Board::Peek_Prg_8, &Board::Poke_Nop ) );
+				cpu.SetFetchBank( 0xA000, prg.Slot(1), Io::Port( this, &Board::Peek_Prg_A, &Board::Poke_Nop ) );
+				cpu.SetFetchBank( 0xC000, prg.Slot(2), Io::Port( this, &Board::Peek_Prg_C, &Board::Poke_Nop ) );
+				cpu.SetFetchBank( 0xE000, prg.Slot(3), Io::Port( this, &Board::Peek_Prg_E, &Board::Poke_Nop ) );
 			}
 
 			void Board::Save(File& file) const
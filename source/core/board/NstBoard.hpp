@@ -693,6 +693,12 @@ namespace Nes
 					return NULL;
 				}
 
+				const byte* GetWram(dword& size) const
+				{
+					size = board.GetWram();
+					return size ? wrk.Source().Mem() : NULL;
+				}
+
 			protected:
 
 				explicit Board(const Context&);
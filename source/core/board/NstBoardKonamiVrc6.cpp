@@ -522,6 +522,33 @@ namespace Nes
 					}
 				}
 
+				void Vrc6::Sound::Render(Sample* const NST_RESTRICT samples,const uint length)
+				{
+					if (output)
+					{
+						// channel by channel over the block, then mixed down in order
+
+						const Cycle r = rate;
+
+						for (uint i=0; i < length; ++i)
+							samples[i] = saw.GetSample( r );
+
+						for (uint j=0; j < 2; ++j)
+						{
+							for (uint i=0; i < length; ++i)
+								samples[i] += square[j].GetSample( r );
+						}
+
+						for (uint i=0; i < length; ++i)
+							samples[i] = dcBlocker.Apply( dword(samples[i]) * output / DEFAULT_VOLUME );
+					}
+					else
+					{
+						for (uint i=0; i < length; ++i)
+							samples[i] = 0;
+					}
+				}
+
 				NES_POKE_D(Vrc6,B003)
 				{
 					SetMirroringVH01( data >> 2 );
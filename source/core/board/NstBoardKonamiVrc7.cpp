@@ -221,7 +221,7 @@ namespace Nes
 					bool audible = UpdateSettings();
 
 					if (connect)
-						Connect( audible );
+						Connect( audible, true );
 				}
 
 				Vrc7::Vrc7(const Context& c)
@@ -784,6 +784,12 @@ namespace Nes
 				{
 					Update();
 
+					if (!Defer( regSelect, data ))
+						Write( regSelect, data );
+				}
+
+				void Vrc7::Sound::Write(const uint regSelect,const uint data)
+				{
 					switch (regSelect & 0x3F)
 					{
 						case 0x00:
@@ -986,35 +992,87 @@ namespace Nes
 
 				Vrc7::Sound::Sample Vrc7::Sound::GetSample()
 				{
-					if (output)
+					Sample sample;
+					Sound::Render( &sample, 1 );
+					return sample;
+				}
+
+				void Vrc7::Sound::Render(Sample* NST_RESTRICT samples,uint length)
+				{
+					if (!output)
 					{
-						while (samplePhase < sampleRate)
+						std::memset( samples, 0, sizeof(Sample) * length );
+						return;
+					}
+
+					// The chip is clocked ahead for a run of samples, one voice at a
+					// time, and the run is then resampled from the clocked outputs.
+					// The LFOs are shared by all voices, so their values are worked
+					// out for each clock before the voices are run.
+
+					Sample clocked[2+RENDER_CLOCKS];
+					uint lfo[2][RENDER_CLOCKS];
+
+					while (length)
+					{
+						uint count = 0;
+						uint clocks = 0;
+
+						for (dword phase = samplePhase; count < length; ++count)
 						{
-							samplePhase += CLOCK_RATE;
+							uint n = 0;
+
+							for (; phase < sampleRate; phase += CLOCK_RATE)
+								++n;
+
+							if (clocks + n > RENDER_CLOCKS)
+								break;
+
+							clocks += n;
+							phase -= sampleRate;
+						}
 
+						NST_ASSERT( count );
+
+						for (uint i=0; i < clocks; ++i)
+						{
 							pitchPhase = (pitchPhase + PITCH_RATE) & PITCH_RANGE;
 							ampPhase = (ampPhase + AMP_RATE) & AMP_RANGE;
 
-							const uint lfo[2] =
+							lfo[0][i] = tables.GetPitch( pitchPhase >> PITCH_SHIFT );
+							lfo[1][i] = tables.GetAmp( ampPhase >> AMP_SHIFT );
+							clocked[2+i] = 0;
+						}
+
+						for (uint j=0; j < NUM_OPLL_CHANNELS; ++j)
+						{
+							for (uint i=0; i < clocks; ++i)
+								clocked[2+i] += channels[j].GetSample( lfo[0][i], lfo[1][i], tables );
+						}
+
+						clocked[0] = prevSample;
+						clocked[1] = nextSample;
+
+						const Sample* next = clocked + 1;
+
+						for (uint i=0; i < count; ++i)
+						{
+							while (samplePhase < sampleRate)
 							{
-								tables.GetPitch( pitchPhase >> PITCH_SHIFT ),
-								tables.GetAmp( ampPhase >> AMP_SHIFT )
-							};
+								samplePhase += CLOCK_RATE;
+								++next;
+							}
 
-							prevSample = nextSample;
-							nextSample = 0;
+							samplePhase -= sampleRate;
 
-							for (uint i=0; i < NUM_OPLL_CHANNELS; ++i)
-								nextSample += channels[i].GetSample( lfo[0], lfo[1], tables );
+							samples[i] = signed_shl( (next[-1] * idword(samplePhase) + next[0] * idword(CLOCK_RATE - samplePhase)) / idword(CLOCK_RATE), 3 ) * idword(output) / DEFAULT_VOLUME;
 						}
 
-						samplePhase -= sampleRate;
+						prevSample = next[-1];
+						nextSample = next[0];
 
-						return signed_shl( (prevSample * idword(samplePhase) + nextSample * idword(CLOCK_RATE - samplePhase)) / idword(CLOCK_RATE), 3 ) * idword(output) / DEFAULT_VOLUME;
-					}
-					else
-					{
-						return 0;
+						samples += count;
+						length -= count;
 					}
 				}
 			}
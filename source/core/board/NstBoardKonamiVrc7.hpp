@@ -59,6 +59,8 @@ namespace Nes
 						void Reset();
 						bool UpdateSettings();
 						Sample GetSample();
+						void Render(Sample*,uint);
+						void Write(uint,uint);
 
 					private:
 
@@ -88,7 +90,8 @@ namespace Nes
 							PG_PHASE_RANGE = (1UL << 18) - 1,
 							EG_BEGIN       = 1UL << 22,
 							PITCH_RATE     = 64UL * (1UL << 16) / CLOCK_DIV / 10,
-							AMP_RATE       = 37UL * (1UL << 16) / CLOCK_DIV / 10
+							AMP_RATE       = 37UL * (1UL << 16) / CLOCK_DIV / 10,
+							RENDER_CLOCKS  = 0x100
 						};
 
 						class Tables
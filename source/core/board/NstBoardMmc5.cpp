@@ -177,7 +177,7 @@ namespace Nes
 
 			void Mmc5::SubReset(const bool hard)
 			{
-				cpu.AddHook( Hook(this,&Mmc5::Hook_Cpu) );
+				cpu.SetEvent( Hook(this,&Mmc5::Hook_Flow) );
 				ppu.SetHActiveHook( Hook(this,&Mmc5::Hook_HActive) );
 				ppu.SetHBlankHook( Hook(this,&Mmc5::Hook_HBlank) );
 
@@ -226,6 +226,7 @@ namespace Nes
 
 				exRam.Reset( hard );
 				flow.Reset();
+				cpu.ScheduleEvent( flow.cycles );
 				banks.Reset();
 				regs.Reset();
 				irq.Reset();
@@ -643,14 +644,16 @@ namespace Nes
 
 					flow.cycles = 0;
 					flow.phase = &Mmc5::VBlank;
+					cpu.ScheduleEvent( flow.cycles );
 				}
 
 				Board::Sync( event, controllers );
 			}
 
-			NES_HOOK(Mmc5,Cpu)
+			NES_HOOK(Mmc5,Flow)
 			{
 				Update();
+				cpu.ScheduleEvent( flow.cycles );
 			}
 
 			NES_HOOK(Mmc5,HActive)
@@ -1695,6 +1698,34 @@ namespace Nes
 				}
 			}
 
+			void Mmc5::Sound::Render(Sample* const NST_RESTRICT samples,const uint length)
+			{
+				if (output)
+				{
+					// channel by channel over the block, then mixed down in order;
+					// the PCM level only changes on a register write
+
+					const Cycle r = rate;
+					const Sample level = pcm.GetSample();
+
+					for (uint i=0; i < length; ++i)
+						samples[i] = level;
+
+					for (uint j=0; j < NUM_SQUARES; ++j)
+					{
+						for (uint i=0; i < length; ++i)
+							samples[i] += square[j].GetSample( r );
+					}
+
+					for (uint i=0; i < length; ++i)
+						samples[i] = dcBlocker.Apply( dword(samples[i]) * 2 * output / DEFAULT_VOLUME );
+				}
+				else
+				{
+					std::memset( samples, 0, sizeof(Sample) * length );
+				}
+			}
+
 			NST_SINGLE_CALL void Mmc5::Sound::Square::ClockQuarter()
 			{
 				envelope.Clock();
@@ -68,6 +68,7 @@ namespace Nes
 					bool UpdateSettings();
 					Cycle Clock(Cycle,Cycle,Cycle);
 					Sample GetSample();
+					void Render(Sample*,uint);
 
 				private:
 
@@ -213,7 +214,7 @@ namespace Nes
 				template<FetchType NT>
 				NST_FORCE_INLINE uint FetchNtExtSplit(uint);
 
-				NES_DECL_HOOK( Cpu     );
+				NES_DECL_HOOK( Flow    );
 				NES_DECL_HOOK( HActive );
 				NES_DECL_HOOK( HBlank  );
 
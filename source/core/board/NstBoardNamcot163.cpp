@@ -55,7 +55,7 @@ namespace Nes
 					bool audible = UpdateSettings();
 
 					if (connect)
-						Connect( audible );
+						Connect( audible, true );
 				}
 
 				void N163::SubReset(const bool hard)
@@ -331,6 +331,61 @@ namespace Nes
 					return 0;
 				}
 
+				inline void N163::Sound::BaseChannel::Render
+				(
+					Sample* const NST_RESTRICT samples,
+					const uint length,
+					const Cycle rate,
+					const Cycle factor,
+					const byte (&wave)[0x100]
+				)
+				{
+					NST_VERIFY( bool(active) == CanOutput() );
+
+					if (active && length)
+					{
+						samples[0] += GetSample( rate, factor, wave );
+
+						// with the timer now below the factor, every step is either
+						// 'steps' or 'steps+1' frequency units, so both phase
+						// increments can be reduced once for the whole block
+
+						const dword range = waveLength;
+						const dword steps = rate / factor;
+						const dword step[2] =
+						{
+							steps * frequency % range,
+							(steps + 1) * frequency % range
+						};
+
+						const dword remainder = rate % factor;
+						const dword amp = volume;
+						const uint offset = waveOffset;
+
+						Cycle p = phase;
+						Cycle t = timer;
+
+						for (uint i=1; i < length; ++i)
+						{
+							t += remainder;
+							const uint carry = (t >= factor);
+
+							if (carry)
+								t -= factor;
+
+							p += step[carry];
+
+							if (p >= range)
+								p -= range;
+
+							samples[i] += wave[(offset + (p >> PHASE_SHIFT)) & 0xFF] * amp;
+						}
+
+						phase = p;
+						timer = t;
+					}
+				}
+
 				N163::Sound::Sample N163::Sound::GetSample()
 				{
 					if (output)
@@ -348,6 +403,22 @@ namespace Nes
 					}
 				}
 
+				void N163::Sound::Render(Sample* const NST_RESTRICT samples,const uint length)
+				{
+					std::memset( samples, 0, sizeof(Sample) * length );
+
+					if (output)
+					{
+						// channel by channel over the block, then mixed down in order
+
+						for (BaseChannel* channel = channels+startChannel; channel != channels+NUM_CHANNELS; ++channel)
+							channel->Render( samples, length, rate, frequency, wave );
+
+						for (uint i=0; i < length; ++i)
+							samples[i] = dcBlocker.Apply( dword(samples[i]) * output / DEFAULT_VOLUME );
+					}
+				}
+
 				bool N163::Sound::UpdateSettings()
 				{
 					uint volume = GetVolume(EXT_N163) * 68U / DEFAULT_VOLUME;
@@ -369,19 +440,22 @@ namespace Nes
 
 				inline dword N163::Sound::FetchFrequency(uint address) const
 				{
-					address &= 0x78;
+					// read back from the unpacked wave data rather than exRam
+					// so that the synthesis side never touches the register file
+
+					address = (address & 0x78) << 1;
 
 					return
 					(
-						(dword(exRam[address+0x0]       ) <<  0) |
-						(dword(exRam[address+0x2]       ) <<  8) |
-						(dword(exRam[address+0x4] & 0x3U) << 16)
+						(dword(wave[address+0x0] | wave[address+0x1] << 4) >> 2 <<  0) |
+						(dword(wave[address+0x4] | wave[address+0x5] << 4) >> 2 <<  8) |
+						(dword(wave[address+0x8] >> 2 & 0x3U              ) << 16)
 					);
 				}
 
-				inline void N163::Sound::WriteWave(const uint data)
+				inline void N163::Sound::WriteWave(const uint address,const uint data)
 				{
-					const uint index = exAddress << 1;
+					const uint index = address << 1;
 					wave[index+0] = (data & 0xF) << 2;
 					wave[index+1] = (data >>  4) << 2;
 				}
@@ -402,14 +476,23 @@ namespace Nes
 				{
 					Update();
 
-					WriteWave( data );
 					exRam[exAddress] = data;
 
-					if (exAddress >= 0x40)
+					if (!Defer( exAddress, data ))
+						Write( exAddress, data );
+
+					exAddress = (exAddress + exIncrease) & 0x7F;
+				}
+
+				void N163::Sound::Write(const uint address,const uint data)
+				{
+					WriteWave( address, data );
+
+					if (address >= 0x40)
 					{
-						BaseChannel& channel = channels[(exAddress - 0x40) >> 3];
+						BaseChannel& channel = channels[(address - 0x40) >> 3];
 
-						switch (exAddress & 0x7)
+						switch (address & 0x7)
 						{
 							case 0x4:
 
@@ -418,7 +501,7 @@ namespace Nes
 							case 0x0:
 							case 0x2:
 
-								channel.SetFrequency( FetchFrequency(exAddress) );
+								channel.SetFrequency( FetchFrequency(address) );
 								break;
 
 							case 0x6:
@@ -430,7 +513,7 @@ namespace Nes
 
 								channel.SetVolume( data );
 
-								if (exAddress == 0x7F)
+								if (address == 0x7F)
 									SetChannelState( data );
 
 								break;
@@ -438,8 +521,6 @@ namespace Nes
 
 						channel.Validate();
 					}
-
-					exAddress = (exAddress + exIncrease) & 0x7F;
 				}
 
 				NES_POKE_D(N163,4800)
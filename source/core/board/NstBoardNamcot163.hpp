@@ -69,12 +69,14 @@ namespace Nes
 						void Reset();
 						bool UpdateSettings();
 						Sample GetSample();
+						void Render(Sample*,uint);
+						void Write(uint,uint);
 
 					private:
 
 						inline void SetChannelState(uint);
 
-						inline void WriteWave(uint);
+						inline void WriteWave(uint,uint);
 						inline dword FetchFrequency(uint) const;
 
 						enum
@@ -96,6 +98,7 @@ namespace Nes
 							void Reset();
 
 							inline dword GetSample(Cycle,Cycle,const byte (&)[0x100]);
+							inline void Render(Sample*,uint,Cycle,Cycle,const byte (&)[0x100]);
 
 							inline void SetFrequency  (uint);
 							inline void SetWaveLength (uint);
@@ -599,6 +599,49 @@ namespace Nes
 						return 0;
 					}
 				}
+
+				void S5b::Sound::Render(Sample* const NST_RESTRICT samples,const uint length)
+				{
+					if (active && output)
+					{
+						// envelope and noise first, since all three squares read
+						// them, then channel by channel and mixed down in order
+
+						const Cycle r = rate;
+
+						uint envelopes[RENDER_BLOCK];
+						uint noises[RENDER_BLOCK];
+
+						for (uint offset=0; offset < length; offset += RENDER_BLOCK)
+						{
+							Sample* const NST_RESTRICT block = samples + offset;
+							const uint count = NST_MIN(length-offset,RENDER_BLOCK);
+
+							for (uint i=0; i < count; ++i)
+							{
+								envelopes[i] = envelope.Clock( r );
+								noises[i] = noise.Clock( r );
+							}
+
+							for (uint i=0; i < count; ++i)
+								block[i] = squares[0].GetSample( r, envelopes[i], noises[i] );
+
+							for (uint j=1; j < NUM_SQUARES; ++j)
+							{
+								for (uint i=0; i < count; ++i)
+									block[i] += squares[j].GetSample( r, envelopes[i], noises[i] );
+							}
+
+							for (uint i=0; i < count; ++i)
+								block[i] = dcBlocker.Apply( dword(block[i]) * output / DEFAULT_VOLUME );
+						}
+					}
+					else
+					{
+						for (uint i=0; i < length; ++i)
+							samples[i] = 0;
+					}
+				}
 			}
 		}
 	}
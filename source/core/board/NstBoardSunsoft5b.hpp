@@ -59,6 +59,7 @@ namespace Nes
 						void Reset();
 						bool UpdateSettings();
 						Sample GetSample();
+						void Render(Sample*,uint);
 
 					private:
 
@@ -80,17 +80,7 @@ namespace Nes
 					}
 				}
 
-				if (pos < Video::Screen::WIDTH * Video::Screen::HEIGHT)
-				{
-					ppu.Update();
-
-					uint pixel = ppu.GetPixelCycles();
-
-					if (pos < pixel && pos >= pixel - PHOSPHOR_DECAY)
-						return Zapper::GetLightMap( ppu.GetPixel( pos ) );
-				}
-
-				return 0;
+				return ppu.GetLightSensor( pos, Zapper::GetLightMap(), false );
 			}
 
 			uint BandaiHyperShot::Peek(uint)
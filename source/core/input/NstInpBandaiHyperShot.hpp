@@ -53,7 +53,6 @@ namespace Nes
 
 				enum
 				{
-					PHOSPHOR_DECAY = 384,
 					LIGHT_SENSOR = 0x40
 				};
 
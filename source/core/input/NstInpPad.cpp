@@ -32,8 +32,6 @@ namespace Nes
 	{
 		namespace Input
 		{
-			uint Pad::mic;
-
 			#ifdef NST_MSVC_OPTIMIZE
 			#pragma optimize("s", on)
 			#endif
@@ -96,7 +94,8 @@ namespace Nes
 			{
 				if (input)
 				{
-					Controllers::Pad& pad = input->pad[type - Api::Input::PAD1];
+					Controllers::Pad* const pads = input->pad;
+					Controllers::Pad& pad = pads[type - Api::Input::PAD1];
 					input = NULL;
 
 					if (Controllers::Pad::callback( pad, type - Api::Input::PAD1 ))
@@ -123,7 +122,13 @@ namespace Nes
 						state = buttons;
 					}
 
-					mic |= pad.mic;
+					// the microphone sits on the second controller but is read
+					// through the first port, so every pad picks up all of them
+
+					mic = 0;
+
+					for (uint i=0; i < 4; ++i)
+						mic |= pads[i].mic;
 				}
 			}
 
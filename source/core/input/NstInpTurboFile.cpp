@@ -23,6 +23,7 @@
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include <cstring>
+#include "../NstLog.hpp"
 #include "NstInpDevice.hpp"
 #include "NstInpTurboFile.hpp"
 
@@ -48,6 +49,22 @@ namespace Nes
 				file.Save( File::TURBOFILE, ram, SIZE );
 			}
 
+			void TurboFile::Journal() const
+			{
+				file.SetJournaling( true );
+
+				try
+				{
+					file.Save( File::TURBOFILE, ram, SIZE );
+				}
+				catch (...)
+				{
+					Log::Flush( "TurboFile: warning, save data journaling failed!" NST_LINEBREAK );
+				}
+
+				file.SetJournaling( false );
+			}
+
 			void TurboFile::Reset()
 			{
 				pos = 0x00;
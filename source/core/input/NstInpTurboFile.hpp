@@ -43,6 +43,8 @@ namespace Nes
 
 				explicit TurboFile(const Cpu&);
 
+				void Journal() const;
+
 			private:
 
 				~TurboFile();
@@ -180,32 +180,9 @@ namespace Nes
 					}
 				}
 
-				if (pos < Video::Screen::WIDTH * Video::Screen::HEIGHT)
-				{
-					ppu.Update();
-
-					uint pixel = ppu.GetPixelCycles();
-
-					if (pos < pixel && pos >= pixel - PHOSPHOR_DECAY)
-					{
-						pixel = ppu.GetPixel( pos );
-
-						if (arcade)
-						{
-							NST_COMPILE_ASSERT( LIGHT_SENSOR >= 0x3F );
-							NST_VERIFY( pixel <= 0x3F );
-
-							if (pixel > 0x3F)
-								return pixel;
-
-							pixel = ppu.GetYuvColor( pixel );
-						}
-
-						return GetLightMap( pixel );
-					}
-				}
+				NST_COMPILE_ASSERT( LIGHT_SENSOR >= 0x3F );
 
-				return 0;
+				return ppu.GetLightSensor( pos, lightMap, arcade );
 			}
 
 			void Zapper::Poke(const uint data)
@@ -56,7 +56,6 @@ namespace Nes
 
 				enum
 				{
-					PHOSPHOR_DECAY = 384,
 					LIGHT_SENSOR = 0x40
 				};
 
@@ -71,10 +70,9 @@ namespace Nes
 
 			public:
 
-				static uint GetLightMap(uint pixel)
+				static const byte* GetLightMap()
 				{
-					NST_ASSERT( pixel < Video::Screen::PALETTE );
-					return lightMap[pixel];
+					return lightMap;
 				}
 			};
 		}
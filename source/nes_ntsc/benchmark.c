@@ -1,11 +1,16 @@
 /* Measures performance of blitter, useful for improving a custom blitter.
 NOTE: This assumes that the process is getting 100% CPU time; you might need to
-arrange for this or else the performance will be reported lower than it really is. */
+arrange for this or else the performance will be reported lower than it really is.
+
+Also times each SIMD blitter this build supports, after checking that its output
+matches nes_ntsc_blit() exactly. Build with: cc -O2 benchmark.c -x c nes_ntsc.inl -lm */
 
 #include "nes_ntsc.h"
+#include "nes_ntsc_simd.inl"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 enum { in_width   = 256 };
@@ -19,10 +24,45 @@ struct data_t
 	nes_ntsc_t ntsc;
 	unsigned char  in  [ in_height] [ in_width];
 	unsigned short out [out_height] [out_width];
+	
+	nes_ntsc_simd_rgb_t simd [nes_ntsc_simd_table_size];
+	unsigned short simd_in  [ in_height] [ in_width];
+	unsigned short simd_out [out_height] [out_width];
 };
 
 static int time_blitter( void );
 
+static void simd_blit( struct data_t* data, nes_ntsc_simd_row_t row )
+{
+	int y;
+	for ( y = 0; y < in_height; y++ )
+		row( data->simd, y % nes_ntsc_burst_count, nes_ntsc_black, data->simd_in [y],
+				(in_width - 1) / nes_ntsc_in_chunk, data->simd_out [y], NES_NTSC_OUT_DEPTH );
+}
+
+static char const* const simd_names [] = { "none", "SSE2", "AVX2", "NEON" };
+
+static void time_simd( struct data_t* data, int kernel )
+{
+	char const* const name = simd_names [kernel];
+	nes_ntsc_simd_row_t row = nes_ntsc_simd_row( kernel );
+	if ( !row )
+		return;
+	
+	simd_blit( data, row );
+	if ( memcmp( data->out, data->simd_out, sizeof data->out ) )
+	{
+		printf( "%s output differs from nes_ntsc_blit\n", name );
+		return;
+	}
+	
+	printf( "Timing %s...\n", name );
+	fflush( stdout );
+	
+	while ( time_blitter() )
+		simd_blit( data, row );
+}
+
 int main()
 {
 	struct data_t* data = (struct data_t*) malloc( sizeof *data );
@@ -34,7 +74,7 @@ int main()
 		{
 			int x;
 			for ( x = 0; x < in_width; x++ )
-				data->in [y] [x] = rand() >> 4 & 0x1F;
+				data->simd_in [y] [x] = data->in [y] [x] = rand() >> 4 & 0x1F;
 		}
 		
 		printf( "Timing nes_ntsc...\n" );
@@ -49,6 +89,12 @@ int main()
 				in_width, in_height, data->out [0], sizeof data->out [0] );
 		}
 		
+		nes_ntsc_simd_pack( data->simd, &data->ntsc );
+		time_simd( data, nes_ntsc_simd_sse2 );
+		time_simd( data, nes_ntsc_simd_avx2 );
+		time_simd( data, nes_ntsc_simd_neon );
+		printf( "Fastest available SIMD blitter: %s\n", simd_names [nes_ntsc_simd_best()] );
+		
 		free( data );
 	}
 	
@@ -78,6 +124,7 @@ static int time_blitter( void )
 		int rate = count / duration;
 		printf( "Performance: %d frames per second, which would use %d%% CPU at 60 FPS\n",
 				rate, 60 * 100 / rate );
+		count = 0;
 		return 0;
 	}
 	count++;
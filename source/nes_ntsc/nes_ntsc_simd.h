@@ -0,0 +1,57 @@
+/* NES NTSC video filter: SIMD blitters */
+
+/* nes_ntsc 0.2.2 */
+#ifndef NES_NTSC_SIMD_H
+#define NES_NTSC_SIMD_H
+
+#include "nes_ntsc.h"
+
+/* Vector versions of the 3->7 blitter, producing output identical to
+NES_NTSC_RGB_OUT(). Each one compiles only where the compiler can target it:
+
+SSE2 - x86-64, or 32-bit x86 built with SSE2 enabled
+AVX2 - as SSE2, with GCC, Clang or MSVC 2013+; checked for at run time
+NEON - ARM built with NEON enabled
+
+NES_NTSC_SIMD is defined when at least one of them is available. Define
+NES_NTSC_NO_SIMD to leave them all out. */
+
+#ifndef NES_NTSC_NO_SIMD
+	#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define NES_NTSC_SSE2 1
+		#if (defined (__GNUC__) && (__GNUC__ >= 5 || defined (__clang__))) || \
+				(defined (_MSC_VER) && _MSC_VER >= 1800)
+			#define NES_NTSC_AVX2 1
+		#endif
+	#endif
+	#if defined (__ARM_NEON) || defined (__ARM_NEON__)
+		#define NES_NTSC_NEON 1
+	#endif
+	#if defined (NES_NTSC_SSE2) || defined (NES_NTSC_NEON)
+		#define NES_NTSC_SIMD 1
+	#endif
+#endif
+
+/* The kernels read a packed copy of the table with 32-bit entries. Only the
+low 32 bits of an nes_ntsc_rgb_t ever reach the output, so this is exact
+even where unsigned long is wider. The vector loads run a few entries past
+the end of the last kernel, hence the padding. */
+typedef unsigned int nes_ntsc_simd_rgb_t;
+enum { nes_ntsc_simd_table_size = nes_ntsc_palette_size * nes_ntsc_entry_size + 8 };
+
+/* Blits one row like nes_ntsc_blit() does: in [0], then chunk_count chunks of
+three pixels, then a final chunk of black. Input pixels are 9-bit palette
+indicies. Writes (chunk_count + 1) * 7 pixels of the given depth (15, 16 or
+32) to out. */
+typedef void (*nes_ntsc_simd_row_t)( nes_ntsc_simd_rgb_t const* table, int burst,
+		unsigned black, unsigned short const* in, int chunk_count, void* out, int depth );
+
+enum
+{
+	nes_ntsc_simd_none,
+	nes_ntsc_simd_sse2,
+	nes_ntsc_simd_avx2,
+	nes_ntsc_simd_neon
+};
+
+#endif
@@ -0,0 +1,326 @@
+/* nes_ntsc 0.2.2. http://www.slack.net/~ant/ */
+
+#include "nes_ntsc_simd.h"
+
+#include <string.h>
+
+#ifdef NES_NTSC_SSE2
+	#include <emmintrin.h>
+#endif
+
+#ifdef NES_NTSC_AVX2
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define NES_NTSC_AVX2_TARGET_
+	#else
+		#define NES_NTSC_AVX2_TARGET_ __attribute__((target("avx2")))
+	#endif
+#endif
+
+#ifdef NES_NTSC_NEON
+	#include <arm_neon.h>
+#endif
+
+/* Copyright (C) 2006-2007 Shay Green. This module is free software; you
+can redistribute it and/or modify it under the terms of the GNU Lesser
+General Public License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version. This
+module is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details. You should have received a copy of the GNU Lesser General Public
+License along with this module; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
+
+/* Output pixel x of a chunk (0 to 6) sums entries from the kernels of the last
+eight input pixels k [0] to k [7], where k [5] to k [7] are the chunk's own:
+
+	k [5] [x] + k [2] [x+7] + k [3] [x+19] + k [4] [x+31] +
+	(x < 2 ? k [0] [x+26] : k [6] [x+12]) +
+	(x < 4 ? k [1] [x+38] : k [7] [x+24])
+
+This is NES_NTSC_RGB_OUT_14_() rearranged so that each term is a run of
+consecutive entries, and a chunk becomes a handful of unaligned vector loads.
+All kernels write an eighth, junk pixel, which the next chunk overwrites. */
+
+static void nes_ntsc_simd_pack( nes_ntsc_simd_rgb_t* out, nes_ntsc_t const* ntsc )
+{
+	nes_ntsc_rgb_t const* in = ntsc->table [0];
+	int n;
+	for ( n = 0; n < nes_ntsc_palette_size * nes_ntsc_entry_size; n++ )
+		out [n] = (nes_ntsc_simd_rgb_t) in [n];
+	for ( ; n < nes_ntsc_simd_table_size; n++ )
+		out [n] = 0;
+}
+
+#define NES_NTSC_SIMD_ROW_( chunk ) {\
+	nes_ntsc_simd_rgb_t const* const ktable = table + burst * nes_ntsc_burst_size;\
+	nes_ntsc_simd_rgb_t const* k [8];\
+	nes_ntsc_simd_rgb_t tail [8];\
+	int const size = (depth == 32 ? 4 : 2);\
+	char* line_out = (char*) out;\
+	k [0] = k [1] = k [2] = k [3] = ktable + black * nes_ntsc_entry_size;\
+	k [4] = ktable + in [0] * nes_ntsc_entry_size;\
+	++in;\
+	for ( ; chunk_count; --chunk_count )\
+	{\
+		k [5] = ktable + in [0] * nes_ntsc_entry_size;\
+		k [6] = ktable + in [1] * nes_ntsc_entry_size;\
+		k [7] = ktable + in [2] * nes_ntsc_entry_size;\
+		chunk( k, line_out, depth );\
+		k [0] = k [3];\
+		k [1] = k [4];\
+		k [2] = k [5];\
+		k [3] = k [6];\
+		k [4] = k [7];\
+		in += 3;\
+		line_out += nes_ntsc_out_chunk * size;\
+	}\
+	k [5] = k [6] = k [7] = ktable + black * nes_ntsc_entry_size;\
+	chunk( k, tail, depth );\
+	memcpy( line_out, tail, nes_ntsc_out_chunk * size );\
+}
+
+#ifdef NES_NTSC_SSE2
+
+#define NES_NTSC_SSE2_LOAD_( k, n ) _mm_loadu_si128( (__m128i const*) ((k) + (n)) )
+
+static __m128i nes_ntsc_sse2_clamp( __m128i io )
+{
+	__m128i sub = _mm_and_si128( _mm_srli_epi32( io, 9 ), _mm_set1_epi32( nes_ntsc_clamp_mask ) );
+	__m128i clamp = _mm_sub_epi32( _mm_set1_epi32( nes_ntsc_clamp_add ), sub );
+	io = _mm_or_si128( io, clamp );
+	clamp = _mm_sub_epi32( clamp, sub );
+	return _mm_and_si128( io, clamp );
+}
+
+static __m128i nes_ntsc_sse2_rgb( __m128i raw, int depth )
+{
+	if ( depth == 16 )
+		return _mm_or_si128( _mm_or_si128(
+				_mm_and_si128( _mm_srli_epi32( raw, 13 ), _mm_set1_epi32( 0xF800 ) ),
+				_mm_and_si128( _mm_srli_epi32( raw,  8 ), _mm_set1_epi32( 0x07E0 ) ) ),
+				_mm_and_si128( _mm_srli_epi32( raw,  4 ), _mm_set1_epi32( 0x001F ) ) );
+	if ( depth == 15 )
+		return _mm_or_si128( _mm_or_si128(
+				_mm_and_si128( _mm_srli_epi32( raw, 14 ), _mm_set1_epi32( 0x7C00 ) ),
+				_mm_and_si128( _mm_srli_epi32( raw,  9 ), _mm_set1_epi32( 0x03E0 ) ) ),
+				_mm_and_si128( _mm_srli_epi32( raw,  4 ), _mm_set1_epi32( 0x001F ) ) );
+	return _mm_or_si128( _mm_or_si128(
+			_mm_and_si128( _mm_srli_epi32( raw, 5 ), _mm_set1_epi32( 0xFF0000 ) ),
+			_mm_and_si128( _mm_srli_epi32( raw, 3 ), _mm_set1_epi32( 0x00FF00 ) ) ),
+			_mm_and_si128( _mm_srli_epi32( raw, 1 ), _mm_set1_epi32( 0x0000FF ) ) );
+}
+
+static void nes_ntsc_sse2_chunk( nes_ntsc_simd_rgb_t const* const* k, void* out, int depth )
+{
+	/* pixels 0-1 come from k [0], 2-3 from k [6] */
+	__m128i const left = _mm_castps_si128( _mm_shuffle_ps(
+			_mm_castsi128_ps( NES_NTSC_SSE2_LOAD_( k [0], 26 ) ),
+			_mm_castsi128_ps( NES_NTSC_SSE2_LOAD_( k [6], 12 ) ), _MM_SHUFFLE( 3, 2, 1, 0 ) ) );
+
+	__m128i lo = _mm_add_epi32(
+			_mm_add_epi32( _mm_add_epi32( NES_NTSC_SSE2_LOAD_( k [5],  0 ), NES_NTSC_SSE2_LOAD_( k [2],  7 ) ),
+			               _mm_add_epi32( NES_NTSC_SSE2_LOAD_( k [3], 19 ), NES_NTSC_SSE2_LOAD_( k [4], 31 ) ) ),
+			_mm_add_epi32( left, NES_NTSC_SSE2_LOAD_( k [1], 38 ) ) );
+
+	__m128i hi = _mm_add_epi32(
+			_mm_add_epi32( _mm_add_epi32( NES_NTSC_SSE2_LOAD_( k [5],  4 ), NES_NTSC_SSE2_LOAD_( k [2], 11 ) ),
+			               _mm_add_epi32( NES_NTSC_SSE2_LOAD_( k [3], 23 ), NES_NTSC_SSE2_LOAD_( k [4], 35 ) ) ),
+			_mm_add_epi32( NES_NTSC_SSE2_LOAD_( k [6], 16 ), NES_NTSC_SSE2_LOAD_( k [7], 28 ) ) );
+
+	lo = nes_ntsc_sse2_rgb( nes_ntsc_sse2_clamp( lo ), depth );
+	hi = nes_ntsc_sse2_rgb( nes_ntsc_sse2_clamp( hi ), depth );
+
+	if ( depth == 32 )
+	{
+		_mm_storeu_si128( (__m128i*) out, lo );
+		_mm_storeu_si128( (__m128i*) out + 1, hi );
+	}
+	else
+	{
+		/* sign-extend so that the saturating pack leaves the values alone */
+		lo = _mm_srai_epi32( _mm_slli_epi32( lo, 16 ), 16 );
+		hi = _mm_srai_epi32( _mm_slli_epi32( hi, 16 ), 16 );
+		_mm_storeu_si128( (__m128i*) out, _mm_packs_epi32( lo, hi ) );
+	}
+}
+
+static void nes_ntsc_sse2_row( nes_ntsc_simd_rgb_t const* table, int burst,
+		unsigned black, unsigned short const* in, int chunk_count, void* out, int depth )
+NES_NTSC_SIMD_ROW_( nes_ntsc_sse2_chunk )
+
+#endif
+
+#ifdef NES_NTSC_AVX2
+
+#define NES_NTSC_AVX2_LOAD_( k, n ) _mm256_loadu_si256( (__m256i const*) ((k) + (n)) )
+
+NES_NTSC_AVX2_TARGET_
+static void nes_ntsc_avx2_chunk( nes_ntsc_simd_rgb_t const* const* k, void* out, int depth )
+{
+	__m256i raw = _mm256_add_epi32(
+			_mm256_add_epi32( _mm256_add_epi32( NES_NTSC_AVX2_LOAD_( k [5],  0 ), NES_NTSC_AVX2_LOAD_( k [2],  7 ) ),
+			                  _mm256_add_epi32( NES_NTSC_AVX2_LOAD_( k [3], 19 ), NES_NTSC_AVX2_LOAD_( k [4], 31 ) ) ),
+			_mm256_add_epi32(
+				_mm256_blend_epi32( NES_NTSC_AVX2_LOAD_( k [0], 26 ), NES_NTSC_AVX2_LOAD_( k [6], 12 ), 0xFC ),
+				_mm256_blend_epi32( NES_NTSC_AVX2_LOAD_( k [1], 38 ), NES_NTSC_AVX2_LOAD_( k [7], 24 ), 0xF0 ) ) );
+
+	__m256i sub = _mm256_and_si256( _mm256_srli_epi32( raw, 9 ), _mm256_set1_epi32( nes_ntsc_clamp_mask ) );
+	__m256i clamp = _mm256_sub_epi32( _mm256_set1_epi32( nes_ntsc_clamp_add ), sub );
+	raw = _mm256_or_si256( raw, clamp );
+	clamp = _mm256_sub_epi32( clamp, sub );
+	raw = _mm256_and_si256( raw, clamp );
+
+	if ( depth == 32 )
+	{
+		raw = _mm256_or_si256( _mm256_or_si256(
+				_mm256_and_si256( _mm256_srli_epi32( raw, 5 ), _mm256_set1_epi32( 0xFF0000 ) ),
+				_mm256_and_si256( _mm256_srli_epi32( raw, 3 ), _mm256_set1_epi32( 0x00FF00 ) ) ),
+				_mm256_and_si256( _mm256_srli_epi32( raw, 1 ), _mm256_set1_epi32( 0x0000FF ) ) );
+		_mm256_storeu_si256( (__m256i*) out, raw );
+	}
+	else
+	{
+		if ( depth == 16 )
+			raw = _mm256_or_si256( _mm256_or_si256(
+					_mm256_and_si256( _mm256_srli_epi32( raw, 13 ), _mm256_set1_epi32( 0xF800 ) ),
+					_mm256_and_si256( _mm256_srli_epi32( raw,  8 ), _mm256_set1_epi32( 0x07E0 ) ) ),
+					_mm256_and_si256( _mm256_srli_epi32( raw,  4 ), _mm256_set1_epi32( 0x001F ) ) );
+		else
+			raw = _mm256_or_si256( _mm256_or_si256(
+					_mm256_and_si256( _mm256_srli_epi32( raw, 14 ), _mm256_set1_epi32( 0x7C00 ) ),
+					_mm256_and_si256( _mm256_srli_epi32( raw,  9 ), _mm256_set1_epi32( 0x03E0 ) ) ),
+					_mm256_and_si256( _mm256_srli_epi32( raw,  4 ), _mm256_set1_epi32( 0x001F ) ) );
+		_mm_storeu_si128( (__m128i*) out, _mm_packus_epi32(
+				_mm256_castsi256_si128( raw ), _mm256_extracti128_si256( raw, 1 ) ) );
+	}
+}
+
+NES_NTSC_AVX2_TARGET_
+static void nes_ntsc_avx2_row( nes_ntsc_simd_rgb_t const* table, int burst,
+		unsigned black, unsigned short const* in, int chunk_count, void* out, int depth )
+NES_NTSC_SIMD_ROW_( nes_ntsc_avx2_chunk )
+
+static int nes_ntsc_avx2_supported( void )
+{
+	#ifdef _MSC_VER
+		int regs [4];
+		__cpuid( regs, 0 );
+		if ( regs [0] < 7 )
+			return 0;
+
+		/* OS must save the YMM registers */
+		__cpuid( regs, 1 );
+		if ( !(regs [2] >> 27 & 1) || (_xgetbv( 0 ) & 6) != 6 )
+			return 0;
+
+		__cpuidex( regs, 7, 0 );
+		return regs [1] >> 5 & 1;
+	#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports( "avx2" ) != 0;
+	#endif
+}
+
+#endif
+
+#ifdef NES_NTSC_NEON
+
+static uint32x4_t nes_ntsc_neon_clamp( uint32x4_t io )
+{
+	uint32x4_t sub = vandq_u32( vshrq_n_u32( io, 9 ), vdupq_n_u32( nes_ntsc_clamp_mask ) );
+	uint32x4_t clamp = vsubq_u32( vdupq_n_u32( nes_ntsc_clamp_add ), sub );
+	io = vorrq_u32( io, clamp );
+	clamp = vsubq_u32( clamp, sub );
+	return vandq_u32( io, clamp );
+}
+
+static uint32x4_t nes_ntsc_neon_rgb( uint32x4_t raw, int depth )
+{
+	if ( depth == 16 )
+		return vorrq_u32( vorrq_u32(
+				vandq_u32( vshrq_n_u32( raw, 13 ), vdupq_n_u32( 0xF800 ) ),
+				vandq_u32( vshrq_n_u32( raw,  8 ), vdupq_n_u32( 0x07E0 ) ) ),
+				vandq_u32( vshrq_n_u32( raw,  4 ), vdupq_n_u32( 0x001F ) ) );
+	if ( depth == 15 )
+		return vorrq_u32( vorrq_u32(
+				vandq_u32( vshrq_n_u32( raw, 14 ), vdupq_n_u32( 0x7C00 ) ),
+				vandq_u32( vshrq_n_u32( raw,  9 ), vdupq_n_u32( 0x03E0 ) ) ),
+				vandq_u32( vshrq_n_u32( raw,  4 ), vdupq_n_u32( 0x001F ) ) );
+	return vorrq_u32( vorrq_u32(
+			vandq_u32( vshrq_n_u32( raw, 5 ), vdupq_n_u32( 0xFF0000 ) ),
+			vandq_u32( vshrq_n_u32( raw, 3 ), vdupq_n_u32( 0x00FF00 ) ) ),
+			vandq_u32( vshrq_n_u32( raw, 1 ), vdupq_n_u32( 0x0000FF ) ) );
+}
+
+static void nes_ntsc_neon_chunk( nes_ntsc_simd_rgb_t const* const* k, void* out, int depth )
+{
+	/* pixels 0-1 come from k [0], 2-3 from k [6] */
+	uint32x4_t const left = vcombine_u32( vget_low_u32( vld1q_u32( k [0] + 26 ) ),
+			vget_high_u32( vld1q_u32( k [6] + 12 ) ) );
+
+	uint32x4_t lo = vaddq_u32(
+			vaddq_u32( vaddq_u32( vld1q_u32( k [5] +  0 ), vld1q_u32( k [2] +  7 ) ),
+			           vaddq_u32( vld1q_u32( k [3] + 19 ), vld1q_u32( k [4] + 31 ) ) ),
+			vaddq_u32( left, vld1q_u32( k [1] + 38 ) ) );
+
+	uint32x4_t hi = vaddq_u32(
+			vaddq_u32( vaddq_u32( vld1q_u32( k [5] +  4 ), vld1q_u32( k [2] + 11 ) ),
+			           vaddq_u32( vld1q_u32( k [3] + 23 ), vld1q_u32( k [4] + 35 ) ) ),
+			vaddq_u32( vld1q_u32( k [6] + 16 ), vld1q_u32( k [7] + 28 ) ) );
+
+	lo = nes_ntsc_neon_rgb( nes_ntsc_neon_clamp( lo ), depth );
+	hi = nes_ntsc_neon_rgb( nes_ntsc_neon_clamp( hi ), depth );
+
+	if ( depth == 32 )
+	{
+		vst1q_u32( (uint32_t*) out, lo );
+		vst1q_u32( (uint32_t*) out + 4, hi );
+	}
+	else
+	{
+		vst1q_u16( (uint16_t*) out, vcombine_u16( vmovn_u32( lo ), vmovn_u32( hi ) ) );
+	}
+}
+
+static void nes_ntsc_neon_row( nes_ntsc_simd_rgb_t const* table, int burst,
+		unsigned black, unsigned short const* in, int chunk_count, void* out, int depth )
+NES_NTSC_SIMD_ROW_( nes_ntsc_neon_chunk )
+
+#endif
+
+/* Returns the row blitter for the given kernel, or NULL if it isn't compiled in
+or the CPU doesn't support it */
+static nes_ntsc_simd_row_t nes_ntsc_simd_row( int kernel )
+{
+	switch ( kernel )
+	{
+	#ifdef NES_NTSC_SSE2
+		case nes_ntsc_simd_sse2:
+			return nes_ntsc_sse2_row;
+	#endif
+	#ifdef NES_NTSC_AVX2
+		case nes_ntsc_simd_avx2:
+			return nes_ntsc_avx2_supported() ? nes_ntsc_avx2_row : 0;
+	#endif
+	#ifdef NES_NTSC_NEON
+		case nes_ntsc_simd_neon:
+			return nes_ntsc_neon_row;
+	#endif
+	}
+	return 0;
+}
+
+/* Returns the fastest kernel available, or nes_ntsc_simd_none */
+static int nes_ntsc_simd_best( void )
+{
+	int kernel;
+	for ( kernel = nes_ntsc_simd_neon; kernel != nes_ntsc_simd_none; --kernel )
+	{
+		if ( nes_ntsc_simd_row( kernel ) )
+			return kernel;
+	}
+	return nes_ntsc_simd_none;
+}
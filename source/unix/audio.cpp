@@ -26,6 +26,7 @@
 
 #include "config.h"
 #include "audio.h"
+#include "capture.h"
 
 #ifndef _MINGW
 #include <ao/ao.h>
@@ -46,21 +47,111 @@ int16_t audiobuf[96000];
 
 int framerate, channels, bufsize;
 
+// Single-producer/single-consumer ring between the emulator thread and the
+// SDL audio callback. The positions are free-running sample counters; only
+// the producer writes ring_wr and only the callback writes ring_rd.
+#define RING_SIZE 65536
+#define RING_MASK (RING_SIZE - 1)
+
+// Maximum deviation of the dynamic rate control from the nominal rate
+#define DRC_MAX_DEVIATION 0.005
+
+static int16_t ring[RING_SIZE];
+static SDL_atomic_t ring_rd, ring_wr;
+static SDL_sem *ring_sem = NULL;
+
+static int16_t drc_prev[2];
+static double drc_frac = 0.0;
+
 bool altspeed = false;
 bool paused = false;
 
+static int audio_ring_target() {
+	// Aim for two frames of audio in flight
+	return 2 * channels * (conf.audio_sample_rate / framerate);
+}
+
+static void audio_callback(void *userdata, Uint8 *stream, int len) {
+	// Drain the ring into the device, padding with silence on underrun
+	int16_t *out = (int16_t*)stream;
+	int want = len / (int)sizeof(int16_t);
+	
+	Uint32 rd = (Uint32)SDL_AtomicGet(&ring_rd);
+	Uint32 avail = (Uint32)SDL_AtomicGet(&ring_wr) - rd;
+	int count = avail < (Uint32)want ? (int)avail : want;
+	
+	for (int i = 0; i < count; i++) {
+		out[i] = ring[(rd + i) & RING_MASK];
+	}
+	
+	if (count < want) { memset(out + count, 0, (want - count) * sizeof(int16_t)); }
+	
+	SDL_AtomicSet(&ring_rd, (int)(rd + count));
+	
+	// Wake the emulator thread if it is waiting for room
+	if (SDL_SemValue(ring_sem) == 0) { SDL_SemPost(ring_sem); }
+}
+
+static void audio_ring_push(const int16_t *samples, int frames) {
+	// Resample one frame of audio into the ring, nudging the rate by up to
+	// DRC_MAX_DEVIATION so the fill level converges on the target
+	Uint32 wr = (Uint32)SDL_AtomicGet(&ring_wr);
+	int fill = (int)(wr - (Uint32)SDL_AtomicGet(&ring_rd));
+	int target = audio_ring_target();
+	
+	double ratio = 1.0 + DRC_MAX_DEVIATION * (double)(target - fill) / target;
+	if (ratio < 1.0 - DRC_MAX_DEVIATION) { ratio = 1.0 - DRC_MAX_DEVIATION; }
+	else if (ratio > 1.0 + DRC_MAX_DEVIATION) { ratio = 1.0 + DRC_MAX_DEVIATION; }
+	
+	drc_frac += frames * ratio;
+	int outframes = (int)drc_frac;
+	drc_frac -= outframes;
+	
+	// Resample at the controller's rate, then drop the tail that does not
+	// fit rather than overwrite unread samples or change the pitch
+	int room = (RING_SIZE - fill) / channels;
+	int keep = outframes < room ? outframes : room;
+	
+	for (int i = 0; i < keep; i++) {
+		// Linear interpolation, position in 1/32768ths of an input frame
+		Uint64 pos = (Uint64)(i + 1) * frames * 32768 / outframes;
+		int idx = (int)(pos >> 15);
+		int frac = (int)(pos & 0x7FFF);
+		
+		for (int c = 0; c < channels; c++) {
+			int s0 = idx ? samples[(idx - 1) * channels + c] : drc_prev[c];
+			int s1 = idx < frames ? samples[idx * channels + c] : s0;
+			ring[wr & RING_MASK] = (int16_t)(s0 + (((s1 - s0) * frac) >> 15));
+			wr++;
+		}
+	}
+	
+	for (int c = 0; c < channels; c++) {
+		drc_prev[c] = samples[(frames - 1) * channels + c];
+	}
+	
+	SDL_AtomicSet(&ring_wr, (int)wr);
+}
+
+static void audio_ring_reset() {
+	// Discard everything still in flight
+	SDL_LockAudioDevice(dev);
+	SDL_AtomicSet(&ring_rd, 0);
+	SDL_AtomicSet(&ring_wr, 0);
+	SDL_UnlockAudioDevice(dev);
+	drc_frac = 0.0;
+}
+
 void audio_play() {
 	
 	if (paused) { updateok = true; return; }
 	
 	bufsize = 2 * channels * (conf.audio_sample_rate / framerate);
 	
+	capture_audio(audiobuf, bufsize);
+	
 	if (conf.audio_api == 0) { // SDL
-		#if SDL_VERSION_ATLEAST(2,0,4)
-		SDL_QueueAudio(dev, (const void*)audiobuf, bufsize);
-		// Clear the audio queue arbitrarily to avoid it backing up too far
-		if (SDL_GetQueuedAudioSize(dev) > (Uint32)(bufsize * 3)) { SDL_ClearQueuedAudio(dev); }
-		#endif
+		audio_ring_push(audiobuf, conf.audio_sample_rate / framerate);
 	}
 #ifndef _MINGW
 	else if (conf.audio_api == 1) { // libao
@@ -84,14 +175,6 @@ void audio_init() {
 	conf.audio_api = 0; // Set SDL audio for MinGW
 	#endif
 	
-	#if SDL_VERSION_ATLEAST(2,0,4)
-	#else // Force libao if SDL lib is not modern enough
-	if (conf.audio_api == 0) {
-		conf.audio_api = 1;
-		fprintf(stderr, "Audio: Forcing libao\n");
-	}
-	#endif
-	
 	if (conf.audio_api == 0) { // SDL
 		spec.freq = conf.audio_sample_rate;
 		spec.format = AUDIO_S16SYS;
@@ -99,9 +182,16 @@ void audio_init() {
 		spec.silence = 0;
 		spec.samples = 512;
 		spec.userdata = 0;
-		spec.callback = NULL; // Use SDL_QueueAudio instead
+		spec.callback = audio_callback;
+		
+		SDL_AtomicSet(&ring_rd, 0);
+		SDL_AtomicSet(&ring_wr, 0);
+		memset(drc_prev, 0, sizeof(drc_prev));
+		drc_frac = 0.0;
+		ring_sem = SDL_CreateSemaphore(0);
 		
-		dev = SDL_OpenAudioDevice(NULL, 0, &spec, &obtained, SDL_AUDIO_ALLOW_ANY_CHANGE);
+		// The ring holds samples in our own format, so let SDL convert
+		dev = SDL_OpenAudioDevice(NULL, 0, &spec, &obtained, 0);
 		if (!dev) {
 			fprintf(stderr, "Error opening audio device.\n");
 		}
@@ -141,6 +231,7 @@ void audio_deinit() {
 	
 	if (conf.audio_api == 0) { // SDL
 		SDL_CloseAudioDevice(dev);
+		if (ring_sem) { SDL_DestroySemaphore(ring_sem); ring_sem = NULL; }
 	}
 #ifndef _MINGW
 	else if (conf.audio_api == 1) { // libao
@@ -175,6 +266,7 @@ void audio_set_params(Sound::Output *soundoutput) {
 	
 	sound.SetSpeaker(conf.audio_stereo ? Sound::SPEAKER_STEREO : Sound::SPEAKER_MONO);
 	sound.SetSpeed(Sound::DEFAULT_SPEED);
+	sound.SetExpansionThread(conf.audio_ext_thread);
 	
 	audio_adj_volume();
 	
@@ -187,6 +279,13 @@ void audio_set_params(Sound::Output *soundoutput) {
 void audio_adj_volume() {
 	// Adjust the audio volume to the current settings
 	Sound sound(emulator);
+	audio_set_volumes(sound);
+	
+	if (conf.audio_volume == 0) { memset(audiobuf, 0, sizeof(audiobuf)); }
+}
+
+void audio_set_volumes(Sound &sound) {
+	// Apply the configured channel volumes to an emulator instance
 	sound.SetVolume(Sound::ALL_CHANNELS, conf.audio_volume);
 	sound.SetVolume(Sound::CHANNEL_SQUARE1, conf.audio_vol_sq1);
 	sound.SetVolume(Sound::CHANNEL_SQUARE2, conf.audio_vol_sq2);
@@ -199,8 +298,6 @@ void audio_adj_volume() {
 	sound.SetVolume(Sound::CHANNEL_VRC7, conf.audio_vol_vrc7);
 	sound.SetVolume(Sound::CHANNEL_N163, conf.audio_vol_n163);
 	sound.SetVolume(Sound::CHANNEL_S5B, conf.audio_vol_s5b);
-	
-	if (conf.audio_volume == 0) { memset(audiobuf, 0, sizeof(audiobuf)); }
 }
 
 // Timing Functions
@@ -208,13 +305,13 @@ void audio_adj_volume() {
 bool timing_frameskip() {
 	// Calculate whether to skip a frame or not
 	
-	if (conf.audio_api == 0) { // SDL
-		// Wait until the audio is drained
-		#if SDL_VERSION_ATLEAST(2,0,4)
-		while (SDL_GetQueuedAudioSize(dev) > (Uint32)bufsize) {
-			if (conf.timing_limiter) { SDL_Delay(1); }
+	if (conf.audio_api == 0 && dev && conf.timing_limiter && !paused) { // SDL
+		// Sleep until the callback has drained the ring down to the target.
+		// A timeout means the device has stalled, so stop waiting on it.
+		int target = audio_ring_target();
+		while ((int)((Uint32)SDL_AtomicGet(&ring_wr) - (Uint32)SDL_AtomicGet(&ring_rd)) > target) {
+			if (SDL_SemWaitTimeout(ring_sem, 100) == SDL_MUTEX_TIMEDOUT) { break; }
 		}
-		#endif
 	}
 	
 	static int flipper = 1;
@@ -231,9 +328,7 @@ void timing_set_default() {
 	// Set the framerate to the default
 	altspeed = false;
 	framerate = nst_pal ? (conf.timing_speed / 6) * 5 : conf.timing_speed;
-	#if SDL_VERSION_ATLEAST(2,0,4)
-	if (conf.audio_api == 0) { SDL_ClearQueuedAudio(dev); }
-	#endif
+	if (conf.audio_api == 0) { audio_ring_reset(); }
 }
 
 void timing_set_altspeed() {
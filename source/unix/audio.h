@@ -14,6 +14,7 @@ void audio_pause();
 void audio_unpause();
 void audio_set_params(Sound::Output *soundoutput);
 void audio_adj_volume();
+void audio_set_volumes(Sound &sound);
 
 bool timing_frameskip();
 void timing_set_default();
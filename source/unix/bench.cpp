@@ -0,0 +1,801 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2016 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Headless benchmark suite. The built-in workloads are small programs
+// assembled here at startup and wrapped in iNES, NSF and FDS images, so every
+// run is reproducible without shipping ROMs. Each one drives the PPU, APU,
+// controller port and its mapper's registers from NMI while the main loop
+// reads cartridge space. ROMs given on the command line are run as extra
+// workloads with the same scripted input.
+//
+// The time split comes from the core's frame profiler: video filter time,
+// APU sample generation time and the rest of the frame counted as the core.
+// It is only available when the core is built with NST_PROFILER. Allocations
+// are counted while a workload is timed, in the nestopia-bench build only.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+
+#include <SDL.h>
+
+#include "core/api/NstApiEmulator.hpp"
+#include "core/api/NstApiMachine.hpp"
+#include "core/api/NstApiVideo.hpp"
+#include "core/api/NstApiSound.hpp"
+#include "core/api/NstApiInput.hpp"
+#include "core/api/NstApiCheats.hpp"
+#include "core/api/NstApiNsf.hpp"
+#include "core/api/NstApiFds.hpp"
+
+#include "main.h"
+#include "config.h"
+#include "bench.h"
+
+using namespace Nes::Api;
+
+#define BENCH_WARMUP 60
+#define BENCH_RATE 44100
+#define BENCH_CHEATS 256
+
+benchopts_t benchopts = { false, 1200, NULL };
+
+extern Emulator emulator;
+extern settings_t conf;
+
+// A tiny 6502 assembler, just enough for the workload programs
+
+enum {
+	OP_ORA_IMM = 0x09, OP_ASL_A = 0x0A, OP_BPL = 0x10, OP_CLC = 0x18,
+	OP_JSR = 0x20, OP_AND_IMM = 0x29, OP_BIT_ABS = 0x2C, OP_ROL_ZP = 0x26,
+	OP_RTI = 0x40, OP_EOR_ZP = 0x45, OP_PHA = 0x48, OP_EOR_IMM = 0x49,
+	OP_LSR_A = 0x4A, OP_JMP = 0x4C, OP_CLI = 0x58, OP_RTS = 0x60,
+	OP_ADC_ZP = 0x65, OP_PLA = 0x68, OP_ADC_ABS = 0x6D, OP_SEI = 0x78,
+	OP_STA_ZP = 0x85, OP_TXA = 0x8A, OP_STA_ABS = 0x8D, OP_TYA = 0x98,
+	OP_TXS = 0x9A, OP_STA_ABSX = 0x9D, OP_LDX_IMM = 0xA2, OP_LDA_ZP = 0xA5,
+	OP_TAY = 0xA8, OP_LDA_IMM = 0xA9, OP_TAX = 0xAA, OP_LDA_ABS = 0xAD,
+	OP_LDA_ABSX = 0xBD, OP_DEX = 0xCA, OP_BNE = 0xD0, OP_CLD = 0xD8,
+	OP_INC_ZP = 0xE6, OP_INX = 0xE8
+};
+
+typedef struct {
+	unsigned char *mem;
+	unsigned int org;
+	unsigned int pc;
+} benchasm_t;
+
+static benchasm_t as;
+
+static void a_byte(int b) {
+	as.mem[as.pc++ - as.org] = b & 0xFF;
+}
+
+static void a_op(int op) {
+	a_byte(op);
+}
+
+static void a_imm(int op, int value) {
+	a_byte(op);
+	a_byte(value);
+}
+
+static void a_abs(int op, unsigned int addr) {
+	a_byte(op);
+	a_byte(addr);
+	a_byte(addr >> 8);
+}
+
+static void a_branch(int op, unsigned int target) {
+	a_byte(op);
+	a_byte(target - (as.pc + 1));
+}
+
+static void a_poke(unsigned int addr, int value) {
+	a_imm(OP_LDA_IMM, value);
+	a_abs(OP_STA_ABS, addr);
+}
+
+// Workload programs
+
+typedef enum {
+	BENCH_NROM,
+	BENCH_MMC1,
+	BENCH_MMC3,
+	BENCH_MMC5,
+	BENCH_VRC7,
+	BENCH_FDS
+} benchboard_t;
+
+// Zero page: $10 main loop accumulator, $12 controller, $13 frame counter
+
+static void bench_board_init(benchboard_t board) {
+	switch (board) {
+		case BENCH_MMC1:
+			// 4K CHR banks, 16K PRG banks with the last one fixed
+			a_imm(OP_LDA_IMM, 0x1E);
+			for (int i = 0; i < 5; i++) {
+				a_abs(OP_STA_ABS, 0x8000);
+				if (i < 4) { a_op(OP_LSR_A); }
+			}
+			break;
+
+		case BENCH_MMC5:
+			a_poke(0x5100, 0x03); // 8K PRG banks
+			a_poke(0x5101, 0x03); // 1K CHR banks
+			a_poke(0x5105, 0x44); // Vertical mirroring
+			a_poke(0x5117, 0xFF);
+			a_poke(0x5015, 0x03); // Both pulse channels on
+			break;
+
+		case BENCH_FDS:
+			// Game NMI and IRQ vectors, disk and sound registers on
+			a_poke(0x0100, 0xC0);
+			a_poke(0x0101, 0xC0);
+			a_poke(0x4023, 0x83);
+			a_poke(0x4089, 0x80);
+			a_imm(OP_LDX_IMM, 0xC0);
+			{
+				unsigned int loop = as.pc;
+				a_op(OP_TXA);
+				a_abs(OP_STA_ABSX, 0x4040 - 0xC0); // Wave table
+				a_op(OP_INX);
+				a_branch(OP_BNE, loop);
+			}
+			a_poke(0x4089, 0x00);
+			a_poke(0x408A, 0xFF);
+			break;
+
+		default: break;
+	}
+}
+
+static void bench_board_frame(benchboard_t board) {
+	switch (board) {
+		case BENCH_MMC1:
+			// CHR bank 0 and PRG bank from the frame counter
+			a_imm(OP_LDA_ZP, 0x13);
+			for (int i = 0; i < 5; i++) {
+				a_abs(OP_STA_ABS, 0xA000);
+				if (i < 4) { a_op(OP_LSR_A); }
+			}
+			a_imm(OP_LDA_ZP, 0x13);
+			for (int i = 0; i < 5; i++) {
+				a_abs(OP_STA_ABS, 0xE000);
+				if (i < 4) { a_op(OP_LSR_A); }
+			}
+			break;
+
+		case BENCH_MMC3:
+			a_poke(0x8000, 0x00);
+			a_imm(OP_LDA_ZP, 0x13);
+			a_abs(OP_STA_ABS, 0x8001);
+			a_poke(0x8000, 0x06);
+			a_imm(OP_LDA_ZP, 0x13);
+			a_abs(OP_STA_ABS, 0x8001);
+			// Scanline IRQ a third of the way down
+			a_imm(OP_LDA_IMM, 0x50);
+			a_abs(OP_STA_ABS, 0xC000);
+			a_abs(OP_STA_ABS, 0xC001);
+			a_abs(OP_STA_ABS, 0xE001);
+			break;
+
+		case BENCH_MMC5:
+			a_imm(OP_LDA_ZP, 0x13);
+			a_abs(OP_STA_ABS, 0x5120);
+			a_abs(OP_STA_ABS, 0x5128);
+			a_imm(OP_ORA_IMM, 0x80);
+			a_abs(OP_STA_ABS, 0x5114);
+			a_poke(0x5000, 0xBF);
+			a_imm(OP_LDA_ZP, 0x13);
+			a_abs(OP_STA_ABS, 0x5002);
+			a_poke(0x5003, 0x08);
+			// Multiplier and scanline IRQ
+			a_imm(OP_LDA_ZP, 0x13);
+			a_abs(OP_STA_ABS, 0x5205);
+			a_imm(OP_LDA_ZP, 0x12);
+			a_abs(OP_STA_ABS, 0x5206);
+			a_abs(OP_LDA_ABS, 0x5205);
+			a_poke(0x5203, 0x60);
+			a_poke(0x5204, 0x80);
+			break;
+
+		case BENCH_VRC7:
+			a_imm(OP_LDA_ZP, 0x13);
+			a_abs(OP_STA_ABS, 0xA000);
+			a_abs(OP_STA_ABS, 0x8000);
+			// Three FM channels, keyed on and off every 16 frames
+			for (int ch = 0; ch < 3; ch++) {
+				a_poke(0x9010, 0x30 + ch);
+				a_poke(0x9030, (ch + 1) << 4);
+				a_poke(0x9010, 0x10 + ch);
+				a_imm(OP_LDA_ZP, 0x13);
+				a_abs(OP_STA_ABS, 0x9030);
+				a_poke(0x9010, 0x20 + ch);
+				a_imm(OP_LDA_ZP, 0x13);
+				a_imm(OP_AND_IMM, 0x10);
+				a_imm(OP_ORA_IMM, 0x0A + (ch << 1));
+				a_abs(OP_STA_ABS, 0x9030);
+			}
+			break;
+
+		case BENCH_FDS:
+			a_poke(0x4080, 0xBF);
+			a_imm(OP_LDA_ZP, 0x13);
+			a_abs(OP_STA_ABS, 0x4082);
+			a_poke(0x4083, 0x02);
+			break;
+
+		default: break;
+	}
+}
+
+static void bench_board_irq(benchboard_t board) {
+	switch (board) {
+		case BENCH_MMC3: a_abs(OP_STA_ABS, 0xE000); break;
+		case BENCH_MMC5: a_abs(OP_LDA_ABS, 0x5204); break;
+		case BENCH_FDS: a_abs(OP_LDA_ABS, 0x4030); break;
+		default: break;
+	}
+}
+
+static void bench_program(unsigned char *image, unsigned int org, benchboard_t board) {
+	// Assemble the 8K workload program for a board at org
+	memset(image, 0xEA, 0x2000);
+
+	as.mem = image;
+	as.org = org;
+
+	unsigned int reset = org;
+	unsigned int nmi = org + 0x0800;
+	unsigned int irq = org + 0x1000;
+	unsigned int loop;
+
+	// Reset
+	as.pc = reset;
+	a_op(OP_SEI);
+	a_op(OP_CLD);
+	a_imm(OP_LDX_IMM, 0xFF);
+	a_op(OP_TXS);
+	a_poke(0x4017, 0x40);
+	a_poke(0x2000, 0x00);
+	a_abs(OP_STA_ABS, 0x2001);
+
+	for (int i = 0; i < 2; i++) {
+		loop = as.pc;
+		a_abs(OP_BIT_ABS, 0x2002);
+		a_branch(OP_BPL, loop);
+	}
+
+	bench_board_init(board);
+
+	// Every OAM byte set to its own index
+	a_imm(OP_LDX_IMM, 0x00);
+	loop = as.pc;
+	a_op(OP_TXA);
+	a_abs(OP_STA_ABSX, 0x0200);
+	a_op(OP_INX);
+	a_branch(OP_BNE, loop);
+
+	a_poke(0x4015, 0x0F);
+	a_poke(0x2000, 0x80);
+	a_poke(0x2001, 0x1E);
+	a_op(OP_CLI);
+
+	// Main loop, reading through cartridge space
+	loop = as.pc;
+	a_abs(OP_LDA_ABSX, 0x8000);
+	a_imm(OP_EOR_ZP, 0x10);
+	a_imm(OP_STA_ZP, 0x10);
+	a_op(OP_INX);
+	a_abs(OP_JMP, loop);
+
+	// NMI
+	as.pc = nmi;
+	a_op(OP_PHA);
+	a_op(OP_TXA);
+	a_op(OP_PHA);
+	a_op(OP_TYA);
+	a_op(OP_PHA);
+
+	a_poke(0x2003, 0x00);
+	a_poke(0x4014, 0x02);
+
+	// Controller 1
+	a_poke(0x4016, 0x01);
+	a_poke(0x4016, 0x00);
+	a_imm(OP_LDX_IMM, 0x08);
+	loop = as.pc;
+	a_abs(OP_LDA_ABS, 0x4016);
+	a_op(OP_LSR_A);
+	a_imm(OP_ROL_ZP, 0x12);
+	a_op(OP_DEX);
+	a_branch(OP_BNE, loop);
+
+	// Move sprite 0 by the buttons held
+	a_imm(OP_LDA_ZP, 0x12);
+	a_op(OP_CLC);
+	a_abs(OP_ADC_ABS, 0x0203);
+	a_abs(OP_STA_ABS, 0x0203);
+	a_imm(OP_INC_ZP, 0x13);
+
+	// Some nametable traffic and a new scroll position
+	a_poke(0x2006, 0x20);
+	a_imm(OP_LDA_ZP, 0x13);
+	a_abs(OP_STA_ABS, 0x2006);
+	a_imm(OP_LDA_ZP, 0x12);
+	a_abs(OP_STA_ABS, 0x2007);
+	a_imm(OP_LDA_ZP, 0x13);
+	a_abs(OP_STA_ABS, 0x2007);
+	a_abs(OP_STA_ABS, 0x2005);
+	a_poke(0x2005, 0x00);
+	a_poke(0x2000, 0x80);
+
+	// Pulse, triangle and noise
+	a_poke(0x4000, 0xBF);
+	a_imm(OP_LDA_ZP, 0x13);
+	a_abs(OP_STA_ABS, 0x4002);
+	a_poke(0x4003, 0x08);
+	a_poke(0x4008, 0x81);
+	a_imm(OP_LDA_ZP, 0x12);
+	a_imm(OP_EOR_IMM, 0xFF);
+	a_abs(OP_STA_ABS, 0x400A);
+	a_poke(0x400B, 0x08);
+	a_poke(0x400C, 0x3F);
+	a_imm(OP_LDA_ZP, 0x13);
+	a_abs(OP_STA_ABS, 0x400E);
+	a_abs(OP_STA_ABS, 0x400F);
+
+	bench_board_frame(board);
+
+	a_op(OP_PLA);
+	a_op(OP_TAY);
+	a_op(OP_PLA);
+	a_op(OP_TAX);
+	a_op(OP_PLA);
+	a_op(OP_RTI);
+
+	// IRQ, acknowledging the frame counter and the board
+	as.pc = irq;
+	a_op(OP_PHA);
+	a_abs(OP_LDA_ABS, 0x4015);
+	bench_board_irq(board);
+	a_op(OP_PLA);
+	a_op(OP_RTI);
+
+	// The FDS takes three NMI vectors, cartridges use the last one
+	for (int i = 0; i < 3; i++) {
+		image[0x1FF6 + i * 2] = nmi & 0xFF;
+		image[0x1FF7 + i * 2] = nmi >> 8;
+	}
+	image[0x1FFC] = reset & 0xFF;
+	image[0x1FFD] = reset >> 8;
+	image[0x1FFE] = irq & 0xFF;
+	image[0x1FFF] = irq >> 8;
+}
+
+static void bench_chr(unsigned char *chr, int size) {
+	// Deterministic pattern data, different in every bank
+	for (int i = 0; i < size; i++) {
+		chr[i] = (i * 7) ^ (i >> 8);
+	}
+}
+
+static std::string bench_image_ines(benchboard_t board) {
+	// Cartridge image with the program in every 8K of PRG
+	static const int mappers[] = { 0, 1, 4, 5, 85 };
+	int prgsize = board == BENCH_NROM ? 0x8000 : 0x20000;
+	int chrsize = board == BENCH_NROM ? 0x2000 : 0x20000;
+
+	std::string rom(16 + prgsize + chrsize, '\0');
+	unsigned char *data = (unsigned char*)&rom[0];
+
+	memcpy(data, "NES\x1a", 4);
+	data[4] = prgsize / 0x4000;
+	data[5] = chrsize / 0x2000;
+	data[6] = (mappers[board] & 0x0F) << 4 | 0x01;
+	data[7] = mappers[board] & 0xF0;
+
+	bench_program(data + 16, 0xE000, board);
+	for (int i = 0x2000; i < prgsize; i += 0x2000) {
+		memcpy(data + 16 + i, data + 16, 0x2000);
+	}
+
+	bench_chr(data + 16 + prgsize, chrsize);
+
+	return rom;
+}
+
+static std::string bench_image_nsf() {
+	// Single song driving the 2A03 channels from the play routine
+	std::string nsf(0x80 + 0x100, '\0');
+	unsigned char *data = (unsigned char*)&nsf[0];
+
+	memcpy(data, "NESM\x1a", 5);
+	data[0x05] = 1; // Version
+	data[0x06] = 1; // Songs
+	data[0x07] = 1; // Starting song
+	data[0x08] = 0x00; data[0x09] = 0x80; // Load
+	data[0x0A] = 0x00; data[0x0B] = 0x80; // Init
+	data[0x0C] = 0x20; data[0x0D] = 0x80; // Play
+	strcpy((char*)data + 0x0E, "Benchmark");
+	data[0x6E] = 0x1A; data[0x6F] = 0x41; // NTSC speed
+	data[0x78] = 0x20; data[0x79] = 0x4E; // PAL speed
+
+	as.mem = data + 0x80;
+	as.org = 0x8000;
+
+	as.pc = 0x8000;
+	a_poke(0x4015, 0x0F);
+	a_imm(OP_LDA_IMM, 0x00);
+	a_imm(OP_STA_ZP, 0x10);
+	a_op(OP_RTS);
+
+	as.pc = 0x8020;
+	a_imm(OP_INC_ZP, 0x10);
+	a_poke(0x4000, 0xBF);
+	a_imm(OP_LDA_ZP, 0x10);
+	a_abs(OP_STA_ABS, 0x4002);
+	a_poke(0x4003, 0x08);
+	a_poke(0x4008, 0x81);
+	a_imm(OP_LDA_ZP, 0x10);
+	a_imm(OP_EOR_IMM, 0xFF);
+	a_abs(OP_STA_ABS, 0x400A);
+	a_poke(0x400B, 0x08);
+	a_poke(0x400C, 0x3F);
+	a_imm(OP_LDA_ZP, 0x10);
+	a_abs(OP_STA_ABS, 0x400E);
+	a_abs(OP_STA_ABS, 0x400F);
+	a_op(OP_RTS);
+
+	return nsf;
+}
+
+static unsigned char* bench_fds_file(unsigned char *side, int number, unsigned int addr, int size, int type) {
+	// File header and data blocks
+	memset(side, 0, 16);
+	side[0] = 0x03;
+	side[1] = number;
+	side[2] = number;
+	memcpy(side + 3, number ? "BENCHCHR" : "BENCHPRG", 8);
+	side[11] = addr & 0xFF;
+	side[12] = addr >> 8;
+	side[13] = size & 0xFF;
+	side[14] = size >> 8;
+	side[15] = type;
+	side[16] = 0x04;
+	return side + 17;
+}
+
+static std::string bench_image_fds() {
+	// One disk side loading the program to $C000 and pattern data to the PPU
+	std::string fds(16 + 65500, '\0');
+	unsigned char *data = (unsigned char*)&fds[0];
+
+	memcpy(data, "FDS\x1a", 4);
+	data[4] = 1;
+
+	unsigned char *side = data + 16;
+
+	side[0] = 0x01;
+	memcpy(side + 1, "*NINTENDO-HVC*", 14);
+	memcpy(side + 16, "BNC", 3);
+	side[19] = ' ';
+	side[25] = 0x0F; // Boot file ID
+	memset(side + 26, 0xFF, 5);
+	side += 56;
+
+	side[0] = 0x02;
+	side[1] = 2; // Files
+	side += 2;
+
+	side = bench_fds_file(side, 0, 0xC000, 0x2000, 0);
+	bench_program(side, 0xC000, BENCH_FDS);
+	side += 0x2000;
+
+	side = bench_fds_file(side, 1, 0x0000, 0x2000, 1);
+	bench_chr(side, 0x2000);
+
+	return fds;
+}
+
+// Running workloads
+
+typedef struct {
+	const char *name;
+	Video::RenderState::Filter filter;
+	int width;
+	int height;
+} benchfilter_t;
+
+static const benchfilter_t filters[] = {
+	{ "none", Video::RenderState::FILTER_NONE, 256, 240 },
+	{ "ntsc", Video::RenderState::FILTER_NTSC, Video::Output::NTSC_WIDTH, 240 },
+	#ifndef NST_NO_SCALEX
+	{ "scale2x", Video::RenderState::FILTER_SCALE2X, 512, 480 },
+	{ "scale3x", Video::RenderState::FILTER_SCALE3X, 768, 720 },
+	#endif
+	#ifndef NST_NO_HQ2X
+	{ "hq2x", Video::RenderState::FILTER_HQ2X, 512, 480 },
+	{ "hq3x", Video::RenderState::FILTER_HQ3X, 768, 720 },
+	{ "hq4x", Video::RenderState::FILTER_HQ4X, 1024, 960 },
+	#endif
+	#ifndef NST_NO_2XSAI
+	{ "2xsai", Video::RenderState::FILTER_2XSAI, 512, 480 },
+	#endif
+	#ifndef NST_NO_XBR
+	{ "2xbr", Video::RenderState::FILTER_2XBR, 512, 480 },
+	{ "3xbr", Video::RenderState::FILTER_3XBR, 768, 720 },
+	{ "4xbr", Video::RenderState::FILTER_4XBR, 1024, 960 },
+	#endif
+};
+
+#define NUM_FILTERS (int)(sizeof(filters) / sizeof(filters[0]))
+
+typedef struct {
+	char name[64];
+	const char *status;
+	int frames;
+	double seconds;
+	bool profiled;
+	double core;
+	double video;
+	double audio;
+	bool counted;
+	uint64_t allocs;
+	uint64_t allocbytes;
+} benchresult_t;
+
+static uint32_t videobuf[1024 * 960];
+static int16_t audiobuf[BENCH_RATE / 50];
+
+static unsigned int bench_buttons(int frame) {
+	// Scripted input: Start now and then to get past title screens, otherwise
+	// a new pseudo-random set of buttons every 16 frames
+	if (frame % 600 >= 60 && frame % 600 < 66) { return Input::Controllers::Pad::START; }
+
+	unsigned int seed = (frame >> 4) * 1103515245U + 12345U;
+	seed = seed * 1103515245U + 12345U;
+
+	return (seed >> 16) & ~(Input::Controllers::Pad::START | Input::Controllers::Pad::SELECT) & 0xFF;
+}
+
+static void bench_workload(benchresult_t *result, const std::string& image, const benchfilter_t *filter, bool cheats) {
+	// Load an image and time a fixed number of frames with scripted input
+	Machine machine(emulator);
+	Video video(emulator);
+	Sound sound(emulator);
+
+	result->frames = 0;
+
+	std::istringstream stream(image);
+
+	if (NES_FAILED(machine.Load(stream, Machine::FAVORED_NES_NTSC))) {
+		result->status = "failed";
+		return;
+	}
+
+	Video::RenderState renderstate;
+	renderstate.filter = filter->filter;
+	renderstate.width = filter->width;
+	renderstate.height = filter->height;
+	renderstate.bits.count = 32;
+	renderstate.bits.mask.r = 0x00ff0000;
+	renderstate.bits.mask.g = 0x0000ff00;
+	renderstate.bits.mask.b = 0x000000ff;
+
+	if (NES_FAILED(video.SetRenderState(renderstate))) {
+		machine.Unload();
+		result->status = "skipped";
+		return;
+	}
+
+	sound.SetSampleBits(16);
+	sound.SetSampleRate(BENCH_RATE);
+	sound.SetSpeaker(Sound::SPEAKER_MONO);
+	sound.SetExpansionThread(conf.audio_ext_thread);
+
+	Input(emulator).ConnectController(0, Input::PAD1);
+
+	Video::Output videoout(videobuf, filter->width * sizeof(uint32_t));
+	Sound::Output soundout(audiobuf, BENCH_RATE / 60);
+	Input::Controllers pads;
+
+	machine.SetCpuFetch(conf.misc_direct_fetch ? Machine::CPU_FETCH_DIRECT : Machine::CPU_FETCH_MAPPED);
+	machine.Power(true);
+
+	if (machine.Is(Machine::SOUND)) { Nsf(emulator).PlaySong(); }
+	if (machine.Is(Machine::DISK)) { Fds(emulator).InsertDisk(0, 0); }
+
+	if (cheats) {
+		// Codes across the page the main loop keeps reading
+		Cheats codes(emulator);
+		for (int i = 0; i < BENCH_CHEATS; i++) {
+			codes.SetCode(Cheats::Code(0x8000 + i, i, 0, false));
+		}
+	}
+
+	for (int i = 0; i < BENCH_WARMUP; i++) {
+		pads.pad[0].buttons = bench_buttons(i);
+		emulator.Execute(&videoout, &soundout, &pads);
+	}
+
+	// The profiler keeps only the last few frames, so collect each one
+	result->profiled = NES_SUCCEEDED(emulator.EnableProfiler(true));
+	result->core = result->video = result->audio = 0;
+
+	result->counted = bench_alloc_begin();
+
+	Uint64 total = 0;
+
+	for (int i = 0; i < benchopts.frames; i++) {
+		pads.pad[0].buttons = bench_buttons(BENCH_WARMUP + i);
+		Uint64 start = SDL_GetPerformanceCounter();
+		emulator.Execute(&videoout, &soundout, &pads);
+		total += SDL_GetPerformanceCounter() - start;
+
+		Emulator::FrameProfile profile;
+		if (result->profiled && emulator.GetProfiles(&profile, 1)) {
+			result->core += (profile.frameTime - profile.blitTime - profile.apuTime) * 1e-9;
+			result->video += profile.blitTime * 1e-9;
+			result->audio += profile.apuTime * 1e-9;
+		}
+	}
+
+	bench_alloc_end(&result->allocs, &result->allocbytes);
+
+	if (result->profiled) { emulator.EnableProfiler(false); }
+
+	result->status = "ok";
+	result->frames = benchopts.frames;
+	result->seconds = total / (double)SDL_GetPerformanceFrequency();
+
+	if (cheats) { Cheats(emulator).ClearCodes(); }
+
+	machine.Unload();
+}
+
+static void bench_json_string(FILE *file, const char *str) {
+	fputc('"', file);
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\') { fprintf(file, "\\%c", *str); }
+		else if ((unsigned char)*str < 0x20) { fprintf(file, "\\u%04x", (unsigned char)*str); }
+		else { fputc(*str, file); }
+	}
+	fputc('"', file);
+}
+
+static void bench_json(FILE *file, const benchresult_t *results, int count) {
+	// Machine readable report for regression tracking
+	fprintf(file, "{\n\t\"version\": \"%s\",\n\t\"frames\": %d,\n\t\"cpu_fetch\": \"%s\",\n\t\"ext_thread\": %s,\n\t\"workloads\": [\n",
+		VERSION, benchopts.frames, conf.misc_direct_fetch ? "direct" : "mapped", conf.audio_ext_thread ? "true" : "false");
+
+	for (int i = 0; i < count; i++) {
+		const benchresult_t *r = &results[i];
+		fprintf(file, "\t\t{ \"name\": ");
+		bench_json_string(file, r->name);
+		fprintf(file, ", \"status\": \"%s\"", r->status);
+		if (r->frames) {
+			fprintf(file, ", \"frames\": %d, \"fps\": %.2f", r->frames, r->frames / r->seconds);
+			if (r->profiled) {
+				fprintf(file, ", \"core_ms\": %.3f, \"video_ms\": %.3f, \"audio_ms\": %.3f", r->core * 1000, r->video * 1000, r->audio * 1000);
+			}
+			if (r->counted) {
+				fprintf(file, ", \"allocations\": %llu, \"allocated_bytes\": %llu", (unsigned long long)r->allocs, (unsigned long long)r->allocbytes);
+			}
+		}
+		fprintf(file, " }%s\n", i < count - 1 ? "," : "");
+	}
+
+	fprintf(file, "\t]\n}\n");
+}
+
+int bench_run(int numroms, char *roms[]) {
+	// Run every workload and report
+	if (benchopts.frames <= 0) { benchopts.frames = 1200; }
+
+	nst_load_db();
+	nst_load_fds_bios();
+
+	static const char *boards[] = { "nrom", "mmc1", "mmc3", "mmc5", "vrc7" };
+	int count = 5 + 1 + 1 + 1 + (NUM_FILTERS - 1) + numroms;
+	benchresult_t *results = (benchresult_t*)calloc(count, sizeof(benchresult_t));
+	benchresult_t *r = results;
+
+	for (int i = BENCH_NROM; i <= BENCH_VRC7; i++, r++) {
+		snprintf(r->name, sizeof(r->name), "%s", boards[i]);
+		bench_workload(r, bench_image_ines((benchboard_t)i), &filters[0], false);
+	}
+
+	snprintf(r->name, sizeof(r->name), "fds");
+	if (Fds(emulator).HasBIOS()) { bench_workload(r, bench_image_fds(), &filters[0], false); }
+	else { r->status = "skipped"; r->frames = 0; }
+	r++;
+
+	snprintf(r->name, sizeof(r->name), "nsf");
+	bench_workload(r++, bench_image_nsf(), &filters[0], false);
+
+	snprintf(r->name, sizeof(r->name), "cheats");
+	bench_workload(r++, bench_image_ines(BENCH_NROM), &filters[0], true);
+
+	for (int i = 1; i < NUM_FILTERS; i++, r++) {
+		snprintf(r->name, sizeof(r->name), "filter-%s", filters[i].name);
+		bench_workload(r, bench_image_ines(BENCH_NROM), &filters[i], false);
+	}
+
+	for (int i = 0; i < numroms; i++, r++) {
+		const char *base = strrchr(roms[i], '/');
+		snprintf(r->name, sizeof(r->name), "%s", base ? base + 1 : roms[i]);
+
+		FILE *file = fopen(roms[i], "rb");
+		std::string image;
+		if (file) {
+			char buf[4096];
+			size_t len;
+			while ((len = fread(buf, 1, sizeof(buf), file)) > 0) { image.append(buf, len); }
+			fclose(file);
+			bench_workload(r, image, &filters[0], false);
+		}
+		else { r->status = "failed"; r->frames = 0; }
+	}
+
+	printf("%-24s %10s %12s %12s %12s %8s\n", "workload", "fps", "core us/f", "video us/f", "audio us/f", "allocs");
+	for (int i = 0; i < count; i++) {
+		const benchresult_t *res = &results[i];
+		if (!res->frames) {
+			printf("%-24s %10s\n", res->name, res->status);
+			continue;
+		}
+		char allocs[24] = "-";
+		if (res->counted) { snprintf(allocs, sizeof(allocs), "%llu", (unsigned long long)res->allocs); }
+		if (!res->profiled) {
+			printf("%-24s %10.1f %12s %12s %12s %8s\n", res->name,
+				res->frames / res->seconds, "-", "-", "-", allocs);
+			continue;
+		}
+		printf("%-24s %10.1f %12.1f %12.1f %12.1f %8s\n", res->name,
+			res->frames / res->seconds,
+			res->core * 1e6 / res->frames,
+			res->video * 1e6 / res->frames,
+			res->audio * 1e6 / res->frames,
+			allocs);
+	}
+
+	if (benchopts.jsonpath) {
+		FILE *file = strcmp(benchopts.jsonpath, "-") ? fopen(benchopts.jsonpath, "w") : stdout;
+		if (file) {
+			bench_json(file, results, count);
+			if (file != stdout) { fclose(file); }
+		}
+		else { fprintf(stderr, "Bench: could not write %s\n", benchopts.jsonpath); }
+	}
+
+	bool failed = false;
+	for (int i = 0; i < count; i++) {
+		if (!strcmp(results[i].status, "failed")) { failed = true; }
+	}
+
+	free(results);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+typedef struct {
+	bool enabled;
+	int frames;
+	const char *jsonpath;
+} benchopts_t;
+
+int bench_run(int numroms, char *roms[]);
+
+bool bench_alloc_begin();
+void bench_alloc_end(uint64_t *allocs, uint64_t *bytes);
+
+#endif
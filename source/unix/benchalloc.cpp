@@ -0,0 +1,105 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2016 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Allocation counting for the benchmark suite. The replacement operator new
+// only exists in the nestopia-bench build (BENCH_COUNT_ALLOCS), the regular
+// binary gets the stubs below and keeps the default allocator.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <new>
+
+#include <SDL.h>
+
+#include "bench.h"
+
+#ifdef BENCH_COUNT_ALLOCS
+
+// Counts only while a workload is timed. The sound expansion thread
+// allocates too, so the counters are updated under a lock.
+
+static SDL_atomic_t bench_counting;
+static SDL_SpinLock bench_lock;
+static uint64_t bench_allocs;
+static uint64_t bench_allocbytes;
+
+#if __cplusplus >= 201103L
+#define BENCH_THROW_BAD_ALLOC
+#else
+#define BENCH_THROW_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+static void* bench_alloc(size_t size) {
+	if (SDL_AtomicGet(&bench_counting)) {
+		SDL_AtomicLock(&bench_lock);
+		bench_allocs++;
+		bench_allocbytes += size;
+		SDL_AtomicUnlock(&bench_lock);
+	}
+	void *p = malloc(size ? size : 1);
+	if (!p) { throw std::bad_alloc(); }
+	return p;
+}
+
+void* operator new(size_t size) BENCH_THROW_BAD_ALLOC {
+	return bench_alloc(size);
+}
+
+void* operator new[](size_t size) BENCH_THROW_BAD_ALLOC {
+	return bench_alloc(size);
+}
+
+void operator delete(void *p) throw() {
+	free(p);
+}
+
+void operator delete[](void *p) throw() {
+	free(p);
+}
+
+bool bench_alloc_begin() {
+	SDL_AtomicLock(&bench_lock);
+	bench_allocs = bench_allocbytes = 0;
+	SDL_AtomicUnlock(&bench_lock);
+	SDL_AtomicSet(&bench_counting, 1);
+	return true;
+}
+
+void bench_alloc_end(uint64_t *allocs, uint64_t *bytes) {
+	SDL_AtomicSet(&bench_counting, 0);
+	SDL_AtomicLock(&bench_lock);
+	*allocs = bench_allocs;
+	*bytes = bench_allocbytes;
+	SDL_AtomicUnlock(&bench_lock);
+}
+
+#else
+
+bool bench_alloc_begin() {
+	return false;
+}
+
+void bench_alloc_end(uint64_t *allocs, uint64_t *bytes) {
+	*allocs = *bytes = 0;
+}
+
+#endif
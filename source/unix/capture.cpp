@@ -0,0 +1,461 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2016 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Frames and sound buffers are copied into a ring of preallocated slots by
+// the emulation thread and written out by a separate writer thread. Each side
+// only ever touches its own ring index; the two semaphores count free and
+// filled slots. The emulation thread only waits if the writer falls a whole
+// ring behind, so nothing is dropped.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL.h>
+
+#include "main.h"
+#include "config.h"
+#include "capture.h"
+#include "png.h"
+
+#define CAPTURE_SLOTS 32
+
+typedef enum {
+	CAPTURE_VIDEO,
+	CAPTURE_AUDIO,
+	CAPTURE_SCREENSHOT,
+	CAPTURE_START,
+	CAPTURE_STOP,
+	CAPTURE_QUIT
+} capturetype_t;
+
+typedef struct {
+	capturetype_t type;
+	int width;
+	int height;
+	int size;
+	int capacity;
+	unsigned char *data;
+	char path[512];
+} captureslot_t;
+
+typedef struct {
+	FILE *video;
+	FILE *audio;
+	char basepath[512];
+	int format;
+	int fps;
+	int rate;
+	int channels;
+	int width;
+	int height;
+	int segment;
+	uint32_t audiobytes;
+	unsigned char *planes;
+} capturewriter_t;
+
+static captureslot_t slots[CAPTURE_SLOTS];
+static unsigned int head = 0; // Only touched by the emulation thread
+static unsigned int tail = 0; // Only touched by the writer thread
+
+static SDL_sem *slots_free = NULL;
+static SDL_sem *slots_filled = NULL;
+static SDL_Thread *writerthread = NULL;
+
+static capturewriter_t writer;
+static bool recording = false;
+
+extern settings_t conf;
+extern nstpaths_t nstpaths;
+extern int framerate, channels;
+
+static void capture_put16(unsigned char *p, uint32_t v) {
+	p[0] = v & 0xff; p[1] = (v >> 8) & 0xff;
+}
+
+static void capture_put32(unsigned char *p, uint32_t v) {
+	p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = (v >> 24) & 0xff;
+}
+
+void capture_wav_header(FILE *fp, int rate, int chans, uint32_t bytes) {
+	// Write a canonical 16-bit PCM WAV header
+	unsigned char header[44];
+	memcpy(header, "RIFF", 4);
+	capture_put32(header + 4, 36 + bytes);
+	memcpy(header + 8, "WAVEfmt ", 8);
+	capture_put32(header + 16, 16);
+	capture_put16(header + 20, 1);
+	capture_put16(header + 22, chans);
+	capture_put32(header + 24, rate);
+	capture_put32(header + 28, rate * chans * 2);
+	capture_put16(header + 32, chans * 2);
+	capture_put16(header + 34, 16);
+	memcpy(header + 36, "data", 4);
+	capture_put32(header + 40, bytes);
+	fwrite(header, 1, sizeof(header), fp);
+}
+
+static void capture_close_files() {
+	// Finalize and close any open capture files
+	if (writer.video) {
+		fclose(writer.video);
+		writer.video = NULL;
+	}
+
+	if (writer.audio) {
+		// Patch the sizes into the header now that they are known
+		fseek(writer.audio, 0, SEEK_SET);
+		capture_wav_header(writer.audio, writer.rate, writer.channels, writer.audiobytes);
+		fclose(writer.audio);
+		writer.audio = NULL;
+	}
+
+	free(writer.planes);
+	writer.planes = NULL;
+	writer.width = writer.height = 0;
+}
+
+static void capture_open_video(int width, int height) {
+	// Open a video file, starting a new segment whenever the dimensions change
+	char path[560];
+
+	if (writer.video) {
+		fclose(writer.video);
+		writer.segment++;
+	}
+
+	if (writer.segment) {
+		snprintf(path, sizeof(path), "%s-%d.%s", writer.basepath, writer.segment, writer.format ? "rgb" : "y4m");
+	}
+	else {
+		snprintf(path, sizeof(path), "%s.%s", writer.basepath, writer.format ? "rgb" : "y4m");
+	}
+
+	writer.video = fopen(path, "wb");
+	writer.width = width;
+	writer.height = height;
+
+	if (!writer.video) {
+		fprintf(stderr, "Capture: Failed to open %s\n", path);
+		return;
+	}
+
+	unsigned char *planes = (unsigned char*)realloc(writer.planes, width * height * 3);
+
+	if (!planes) {
+		fprintf(stderr, "Capture: Out of memory for %dx%d frames\n", width, height);
+		fclose(writer.video);
+		writer.video = NULL;
+		return;
+	}
+
+	writer.planes = planes;
+
+	if (writer.format == 0) {
+		fprintf(writer.video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", width, height, writer.fps);
+	}
+	else {
+		fprintf(stderr, "Capture: %s is raw RGB24, %dx%d at %d fps\n", path, width, height, writer.fps);
+	}
+}
+
+static void capture_write_video(captureslot_t *slot) {
+	// Convert a BGRA frame and append it to the video file
+	if (slot->width != writer.width || slot->height != writer.height) {
+		capture_open_video(slot->width, slot->height);
+	}
+
+	if (!writer.video) { return; }
+
+	int pixels = slot->width * slot->height;
+	const unsigned char *src = slot->data;
+	unsigned char *dst = writer.planes;
+
+	if (writer.format == 0) {
+		// Full range BT.601 Y'CbCr 4:4:4, planar
+		unsigned char *y = dst, *cb = dst + pixels, *cr = dst + pixels * 2;
+
+		for (int i = 0; i < pixels; i++, src += 4) {
+			int b = src[0], g = src[1], r = src[2];
+			y[i] = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+			int u = ((-11059 * r - 21709 * g + 32768 * b + 32768) >> 16) + 128;
+			int v = ((32768 * r - 27439 * g - 5329 * b + 32768) >> 16) + 128;
+			cb[i] = u < 0 ? 0 : u > 255 ? 255 : u;
+			cr[i] = v < 0 ? 0 : v > 255 ? 255 : v;
+		}
+
+		fwrite("FRAME\n", 1, 6, writer.video);
+	}
+	else {
+		for (int i = 0; i < pixels; i++, src += 4, dst += 3) {
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+		}
+	}
+
+	fwrite(writer.planes, 1, pixels * 3, writer.video);
+}
+
+static void capture_write_audio(captureslot_t *slot) {
+	// Append samples to the WAV file
+	if (!writer.audio) { return; }
+	fwrite(slot->data, 1, slot->size, writer.audio);
+	writer.audiobytes += slot->size;
+}
+
+static void capture_write_screenshot(captureslot_t *slot) {
+	// Encode a BGRA frame to PNG
+	unsigned char *p = slot->data;
+
+	for (int i = 0; i < slot->width * slot->height; i++, p += 4) {
+		unsigned char b = p[0];
+		p[0] = p[2];
+		p[2] = b;
+		p[3] = 0xff;
+	}
+
+	if (lodepng_encode32_file(slot->path, slot->data, slot->width, slot->height)) {
+		fprintf(stderr, "Screenshot: Failed to write %s\n", slot->path);
+	}
+	else {
+		fprintf(stderr, "Screenshot: %s\n", slot->path);
+	}
+}
+
+static void capture_open(captureslot_t *slot) {
+	// Start a new capture
+	capture_close_files();
+
+	const int *params = (const int*)slot->data;
+
+	snprintf(writer.basepath, sizeof(writer.basepath), "%s", slot->path);
+	writer.format = params[0];
+	writer.fps = params[1];
+	writer.rate = params[2];
+	writer.channels = params[3];
+	writer.segment = 0;
+	writer.audiobytes = 0;
+
+	char path[560];
+	snprintf(path, sizeof(path), "%s.wav", writer.basepath);
+	writer.audio = fopen(path, "wb");
+
+	if (writer.audio) {
+		capture_wav_header(writer.audio, writer.rate, writer.channels, 0);
+		fprintf(stderr, "Capture: %s\n", writer.basepath);
+	}
+	else {
+		fprintf(stderr, "Capture: Failed to open %s\n", path);
+	}
+}
+
+static int capture_writer(void *data) {
+	// Writer thread: drain the ring until asked to quit
+	bool quit = false;
+
+	while (!quit) {
+		SDL_SemWait(slots_filled);
+
+		captureslot_t *slot = &slots[tail];
+
+		switch (slot->type) {
+			case CAPTURE_VIDEO: capture_write_video(slot); break;
+			case CAPTURE_AUDIO: capture_write_audio(slot); break;
+			case CAPTURE_SCREENSHOT: capture_write_screenshot(slot); break;
+			case CAPTURE_START: capture_open(slot); break;
+			case CAPTURE_STOP: capture_close_files(); break;
+			case CAPTURE_QUIT: capture_close_files(); quit = true; break;
+		}
+
+		tail = (tail + 1) % CAPTURE_SLOTS;
+		SDL_SemPost(slots_free);
+	}
+
+	return 0;
+}
+
+static captureslot_t* capture_acquire(capturetype_t type, int size) {
+	// Claim the next free slot, growing its buffer if needed
+	SDL_SemWait(slots_free);
+
+	captureslot_t *slot = &slots[head];
+
+	if (slot->capacity < size) {
+		unsigned char *data = (unsigned char*)realloc(slot->data, size);
+
+		if (!data) {
+			// Give the slot back, the caller drops this item
+			fprintf(stderr, "Capture: Out of memory, dropping data\n");
+			SDL_SemPost(slots_free);
+			return NULL;
+		}
+
+		slot->data = data;
+		slot->capacity = size;
+	}
+
+	slot->type = type;
+	slot->size = size;
+
+	return slot;
+}
+
+static void capture_commit() {
+	// Hand the current slot over to the writer thread
+	head = (head + 1) % CAPTURE_SLOTS;
+	SDL_SemPost(slots_filled);
+}
+
+static void capture_frame(capturetype_t type, const uint32_t *pixels, int width, int height, const char *path) {
+	// Queue a copy of a frame
+	captureslot_t *slot = capture_acquire(type, width * height * 4);
+
+	if (!slot) { return; }
+
+	memcpy(slot->data, pixels, width * height * 4);
+	slot->width = width;
+	slot->height = height;
+
+	if (path) { snprintf(slot->path, sizeof(slot->path), "%s", path); }
+
+	capture_commit();
+}
+
+void capture_init() {
+	// Initialize the capture ring and start the writer thread
+	if (writerthread) { return; }
+
+	memset(slots, 0, sizeof(slots));
+	memset(&writer, 0, sizeof(writer));
+	head = tail = 0;
+
+	slots_free = SDL_CreateSemaphore(CAPTURE_SLOTS);
+	slots_filled = SDL_CreateSemaphore(0);
+	writerthread = SDL_CreateThread(capture_writer, "capture", NULL);
+
+	if (!writerthread) {
+		fprintf(stderr, "Capture: Failed to create writer thread: %s\n", SDL_GetError());
+	}
+}
+
+void capture_deinit() {
+	// Flush the ring, stop the writer thread and free all buffers
+	if (!writerthread) { return; }
+
+	capture_acquire(CAPTURE_QUIT, 0);
+	capture_commit();
+
+	SDL_WaitThread(writerthread, NULL);
+	writerthread = NULL;
+	recording = false;
+
+	SDL_DestroySemaphore(slots_free);
+	SDL_DestroySemaphore(slots_filled);
+
+	for (int i = 0; i < CAPTURE_SLOTS; i++) {
+		free(slots[i].data);
+	}
+	memset(slots, 0, sizeof(slots));
+}
+
+void capture_start() {
+	// Start capturing video and audio
+	if (!writerthread || recording) { return; }
+
+	captureslot_t *slot = capture_acquire(CAPTURE_START, sizeof(int) * 4);
+
+	if (!slot) { return; }
+
+	int *params = (int*)slot->data;
+	params[0] = conf.misc_capture_format;
+	params[1] = framerate;
+	params[2] = conf.audio_sample_rate;
+	params[3] = channels;
+	snprintf(slot->path, sizeof(slot->path), "%scaptures/%s-%ld", nstpaths.nstdir, nstpaths.gamename, (long)time(NULL));
+	capture_commit();
+
+	recording = true;
+}
+
+void capture_stop() {
+	// Stop capturing, the files are finalized by the writer thread
+	if (!recording) { return; }
+
+	capture_acquire(CAPTURE_STOP, 0);
+	capture_commit();
+
+	recording = false;
+	fprintf(stderr, "Capture: Stopped\n");
+}
+
+void capture_toggle() {
+	if (recording) { capture_stop(); }
+	else { capture_start(); }
+}
+
+bool capture_active() {
+	return recording;
+}
+
+void capture_video(const uint32_t *pixels, int width, int height) {
+	// Queue a post-filter frame
+	if (recording) { capture_frame(CAPTURE_VIDEO, pixels, width, height, NULL); }
+}
+
+void capture_audio(const int16_t *samples, int bytes) {
+	// Queue one frame worth of sound
+	if (!recording || bytes <= 0) { return; }
+
+	captureslot_t *slot = capture_acquire(CAPTURE_AUDIO, bytes);
+	if (!slot) { return; }
+	memcpy(slot->data, samples, bytes);
+	capture_commit();
+}
+
+void capture_screenshot(const uint32_t *pixels, int width, int height, const char *filename) {
+	// Queue a frame to be written as PNG
+	if (writerthread) {
+		capture_frame(CAPTURE_SCREENSHOT, pixels, width, height, filename);
+		return;
+	}
+
+	// No writer thread, encode it here instead
+	captureslot_t slot;
+	memset(&slot, 0, sizeof(slot));
+	slot.data = (unsigned char*)malloc(width * height * 4);
+
+	if (!slot.data) {
+		fprintf(stderr, "Screenshot: Out of memory, dropping %s\n", filename);
+		return;
+	}
+
+	memcpy(slot.data, pixels, width * height * 4);
+	slot.type = CAPTURE_SCREENSHOT;
+	slot.width = width;
+	slot.height = height;
+	snprintf(slot.path, sizeof(slot.path), "%s", filename);
+
+	capture_write_screenshot(&slot);
+	free(slot.data);
+}
@@ -0,0 +1,19 @@
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+void capture_init();
+void capture_deinit();
+void capture_start();
+void capture_stop();
+void capture_toggle();
+bool capture_active();
+
+void capture_video(const uint32_t *pixels, int width, int height);
+void capture_audio(const int16_t *samples, int bytes);
+void capture_screenshot(const uint32_t *pixels, int width, int height, const char *filename);
+void capture_wav_header(FILE *fp, int rate, int chans, uint32_t bytes);
+
+#endif
@@ -27,8 +27,21 @@
 #include "main.h"
 #include "cli.h"
 #include "config.h"
+#include "bench.h"
+#include "nsfexport.h"
+
+// Long options without a short form
+enum {
+	OPT_NSFTRACKS = 256,
+	OPT_NSFLENGTH,
+	OPT_NSFSILENCE,
+	OPT_HASHTRACE
+};
 
 extern settings_t conf;
+extern benchopts_t benchopts;
+extern nsfexportopts_t nsfexportopts;
+extern char *hashtracepath;
 
 void cli_error(char *message) {
 	cli_show_usage();
@@ -55,6 +68,14 @@ void cli_show_usage() {
 	printf("  -u, --unlimitedsprites  Remove sprite limit\n");
 	printf("  -q, --spritelimit       Enable sprite limit\n\n");
 	printf("  -v, --version           Show version information\n\n");
+	printf("  -b, --bench[=FILE]      Run the benchmark suite headless and exit,\n");
+	printf("                          plus any FILEs given, with a JSON report to FILE\n");
+	printf("  -k, --benchframes       Frames to run per benchmark workload\n\n");
+	printf("  -x, --nsfexport=DIR     Render the tracks of the NSF FILE to WAV files in DIR\n");
+	printf("      --nsftracks=LIST    Tracks to render, e.g. 1,3-5 (default: all)\n");
+	printf("      --nsflength=SECS    Maximum length of a track (default: 180)\n");
+	printf("      --nsfsilence=SECS   End a track after this much silence (default: 3)\n\n");
+	printf("      --hashtrace=FILE    Write the machine state hash of every frame to FILE\n\n");
 	printf("More options can be set in the configuration file.\n");
 	printf("Options are saved, and do not need to be set on future invocations.\n\n");
 }
@@ -85,12 +106,19 @@ void cli_handle_command(int argc, char *argv[]) {
 			{"unlimitedsprites", no_argument, 0, 'u'},
 			{"spritelimit", no_argument, 0, 'q'},
 			{"version", no_argument, 0, 'v'},
+			{"bench", optional_argument, 0, 'b'},
+			{"benchframes", required_argument, 0, 'k'},
+			{"nsfexport", required_argument, 0, 'x'},
+			{"nsftracks", required_argument, 0, OPT_NSFTRACKS},
+			{"nsflength", required_argument, 0, OPT_NSFLENGTH},
+			{"nsfsilence", required_argument, 0, OPT_NSFSILENCE},
+			{"hashtrace", required_argument, 0, OPT_HASHTRACE},
 			{0, 0, 0, 0}
 		};
 		
 		int option_index = 0;
 		
-		c = getopt_long(argc, argv, "defhl:mnopqrs:tuvw",
+		c = getopt_long(argc, argv, "b::defhk:l:mnopqrs:tuvwx:",
 			long_options, &option_index);
 		
 		if (c == -1) { break; }
@@ -174,9 +202,65 @@ void cli_handle_command(int argc, char *argv[]) {
 				exit(0);
 				break;
 			
+			case 'b':
+				benchopts.enabled = true;
+				benchopts.jsonpath = optarg;
+				break;
+			
+			case 'k':
+				optint = atoi(optarg);
+				if (optint > 0) {
+					benchopts.frames = optint;
+				}
+				else {
+					cli_error("Error: Invalid number of frames");
+				}
+				break;
+			
+			case 'x':
+				nsfexportopts.outdir = optarg;
+				break;
+			
+			case OPT_NSFTRACKS:
+				nsfexportopts.tracks = optarg;
+				break;
+			
+			case OPT_NSFLENGTH:
+				optint = atoi(optarg);
+				if (optint > 0) {
+					nsfexportopts.length = optint;
+				}
+				else {
+					cli_error("Error: Invalid track length");
+				}
+				break;
+			
+			case OPT_NSFSILENCE:
+				optint = atoi(optarg);
+				if (optint > 0) {
+					nsfexportopts.silence = optint;
+				}
+				else {
+					cli_error("Error: Invalid silence length");
+				}
+				break;
+			
+			case OPT_HASHTRACE:
+				hashtracepath = optarg;
+				break;
+			
 			default:
 				cli_error("Error: Invalid option");
 				break;
 		}
 	}
+	
+	// Remaining arguments are extra benchmark ROMs
+	if (benchopts.enabled) { exit(bench_run(argc - optind, argv + optind)); }
+	
+	// Render an NSF headless
+	if (nsfexportopts.outdir) {
+		if (optind >= argc) { cli_error("Error: No NSF file given"); }
+		exit(nsfexport_run(argv[argc - 1]));
+	}
 }
@@ -105,7 +105,9 @@ void config_file_write() {
 		fprintf(fp, "vol_vrc6=%d\n", conf.audio_vol_vrc6);
 		fprintf(fp, "vol_vrc7=%d\n", conf.audio_vol_vrc7);
 		fprintf(fp, "vol_n163=%d\n", conf.audio_vol_n163);
-		fprintf(fp, "vol_s5b=%d\n", conf.audio_vol_s5b);
+		fprintf(fp, "vol_s5b=%d\n\n", conf.audio_vol_s5b);
+		fprintf(fp, "; Synthesize VRC7/N163 sound on a worker thread. Valid values are 1 and 0.\n");
+		fprintf(fp, "ext_thread=%d\n", conf.audio_ext_thread);
 		fprintf(fp, "\n"); // End of Section
 		
 		// Timing
@@ -135,6 +137,15 @@ void config_file_write() {
 		fprintf(fp, "last_folder=%s\n", conf.misc_last_folder);
 		fprintf(fp, "; 0=0x00, 1=0xFF, 2=Random\n");
 		fprintf(fp, "power_state=%d\n", conf.misc_power_state);
+		fprintf(fp, "; 0=Y4M, 1=Raw RGB24\n");
+		fprintf(fp, "capture_format=%d\n", conf.misc_capture_format);
+		fprintf(fp, "fds_fastload=%d\n", conf.misc_fds_fastload);
+		fprintf(fp, "; Read instructions directly from PRG-ROM banks\n");
+		fprintf(fp, "direct_fetch=%d\n", conf.misc_direct_fetch);
+		fprintf(fp, "; Poll controllers when the game strobes them\n");
+		fprintf(fp, "strobe_poll=%d\n", conf.misc_strobe_poll);
+		fprintf(fp, "; Journal save data changes every frame to survive crashes\n");
+		fprintf(fp, "battery_journal=%d\n", conf.misc_battery_journal);
 		
 		fclose(fp);
 	}
@@ -185,6 +196,7 @@ void config_set_default() {
 	conf.audio_vol_vrc7 = 85;
 	conf.audio_vol_n163 = 85;
 	conf.audio_vol_s5b = 85;
+	conf.audio_ext_thread = false;
 	
 	// Timing
 	conf.timing_speed = 60;
@@ -209,6 +221,11 @@ void config_set_default() {
 	#endif
 	conf.misc_last_folder = NULL;
 	conf.misc_power_state = 0;
+	conf.misc_capture_format = 0;
+	conf.misc_fds_fastload = false;
+	conf.misc_direct_fetch = false;
+	conf.misc_strobe_poll = false;
+	conf.misc_battery_journal = false;
 }
 
 static int config_match(void* user, const char* section, const char* name, const char* value) {
@@ -255,6 +272,7 @@ static int config_match(void* user, const char* section, const char* name, const
 	else if (MATCH("audio", "vol_vrc7")) { pconfig->audio_vol_vrc7 = atoi(value); }
 	else if (MATCH("audio", "vol_n163")) { pconfig->audio_vol_n163 = atoi(value); }
 	else if (MATCH("audio", "vol_s5b")) { pconfig->audio_vol_s5b = atoi(value); }
+	else if (MATCH("audio", "ext_thread")) { pconfig->audio_ext_thread = atoi(value); }
 	
 	// Timing
 	else if (MATCH("timing", "speed")) { pconfig->timing_speed = atoi(value); }
@@ -273,6 +291,11 @@ static int config_match(void* user, const char* section, const char* name, const
 	else if (MATCH("misc", "disable_cursor")) { pconfig->misc_disable_cursor = atoi(value); }
 	else if (MATCH("misc", "last_folder")) { pconfig->misc_last_folder = strdup(value); }
 	else if (MATCH("misc", "power_state")) { pconfig->misc_power_state = atoi(value); }
+	else if (MATCH("misc", "capture_format")) { pconfig->misc_capture_format = atoi(value); }
+	else if (MATCH("misc", "fds_fastload")) { pconfig->misc_fds_fastload = atoi(value); }
+	else if (MATCH("misc", "direct_fetch")) { pconfig->misc_direct_fetch = atoi(value); }
+	else if (MATCH("misc", "strobe_poll")) { pconfig->misc_strobe_poll = atoi(value); }
+	else if (MATCH("misc", "battery_journal")) { pconfig->misc_battery_journal = atoi(value); }
     
 	else { return 0; }
 	return 1;
@@ -43,6 +43,7 @@ typedef struct {
 	int audio_vol_vrc7;
 	int audio_vol_n163;
 	int audio_vol_s5b;
+	bool audio_ext_thread;
 	
 	// Timing
 	int timing_speed;
@@ -62,6 +63,11 @@ typedef struct {
 	bool misc_config_pause;
 	char* misc_last_folder;
 	int misc_power_state;
+	int misc_capture_format;
+	bool misc_fds_fastload;
+	bool misc_direct_fetch;
+	bool misc_strobe_poll;
+	bool misc_battery_journal;
 } settings_t;
 
 void config_file_read();
@@ -33,6 +33,7 @@
 #include "config.h"
 #include "audio.h"
 #include "video.h"
+#include "capture.h"
 #include "input.h"
 #include "ini.h"
 
@@ -425,64 +426,68 @@ void input_match_joystick(Input::Controllers *controllers, SDL_Event event) {
 	input_inject(controllers, input);
 }
 
-void input_match_keyboard(Input::Controllers *controllers, SDL_Event event) {
-	// Match NES buttons to keyboard buttons
-	
-	nesinput_t input;
-
-	input.nescode = 0x00;
-	input.player = 0;
-	input.pressed = 0;
-	input.turboa = 0;
-	input.turbob = 0;
+static void input_match_keyboard_pad(SDL_Event event, nesinput_t *input) {
+	// Match a keyboard event to an NES button, leaving nescode empty if it is not bound
+	input->nescode = 0x00;
+	input->player = 0;
+	input->pressed = 0;
+	input->turboa = 0;
+	input->turbob = 0;
 
-	if (event.type == SDL_KEYDOWN) { input.pressed = 1; }
+	if (event.type == SDL_KEYDOWN) { input->pressed = 1; }
 
 	for (int i = 0; i < NUMGAMEPADS; i++) {
 		if (player[i].u == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::UP;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::UP;
+			input->player = i;
 		}
 		else if (player[i].d == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::DOWN;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::DOWN;
+			input->player = i;
 		}
 		else if (player[i].l == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::LEFT;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::LEFT;
+			input->player = i;
 		}
 		else if (player[i].r == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::RIGHT;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::RIGHT;
+			input->player = i;
 		}
 		else if (player[i].select == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::SELECT;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::SELECT;
+			input->player = i;
 		}
 		else if (player[i].start == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::START;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::START;
+			input->player = i;
 		}
 		else if (player[i].a == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::A;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::A;
+			input->player = i;
 		}
 		else if (player[i].b == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::B;
-			input.player = i;
+			input->nescode = Input::Controllers::Pad::B;
+			input->player = i;
 		}
 		else if (player[i].ta == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::A;
-			input.player = i;
-			input.turboa = 1;
+			input->nescode = Input::Controllers::Pad::A;
+			input->player = i;
+			input->turboa = 1;
 		}
 		else if (player[i].tb == event.key.keysym.scancode) {
-			input.nescode = Input::Controllers::Pad::B;
-			input.player = i;
-			input.turbob = 1;
+			input->nescode = Input::Controllers::Pad::B;
+			input->player = i;
+			input->turbob = 1;
 		}
 	}
+}
 
+void input_match_keyboard(Input::Controllers *controllers, SDL_Event event) {
+	// Match NES buttons to keyboard buttons
+	
+	nesinput_t input;
+	
+	input_match_keyboard_pad(event, &input);
 	input_inject(controllers, input);
 	
 	if (event.key.keysym.scancode == ui.altspeed && event.type == SDL_KEYDOWN) { timing_set_altspeed(); }
@@ -506,6 +511,9 @@ void input_match_keyboard(Input::Controllers *controllers, SDL_Event event) {
 	// Screenshot
 	if (keys[ui.screenshot]) { video_screenshot(NULL); }
 	
+	// Audio/Video capture
+	if (event.key.keysym.scancode == ui.capture && event.type == SDL_KEYUP) { capture_toggle(); }
+	
 	// Reset
 	if (keys[ui.reset]) { nst_reset(0); }
 	
@@ -548,6 +556,36 @@ void input_match_keyboard(Input::Controllers *controllers, SDL_Event event) {
 	}
 }
 
+static bool NST_CALLBACK input_strobe_poll(void *userData, Input::Controllers::Pad& pad, unsigned int port) {
+	// Pick up pad events that arrived since the frame started, at the moment the game latches the pads.
+	// The events are only peeked: the main loop still takes them off the queue in order and applies
+	// them again, which leaves the pads in the same state.
+	Input::Controllers *controllers = (Input::Controllers*)userData;
+	SDL_Event events[64];
+	int count;
+	
+	SDL_PumpEvents();
+	
+	count = SDL_PeepEvents(events, 64, SDL_PEEKEVENT, SDL_JOYAXISMOTION, SDL_JOYBUTTONUP);
+	for (int i = 0; i < count; i++) { input_match_joystick(controllers, events[i]); }
+	
+	count = SDL_PeepEvents(events, 64, SDL_PEEKEVENT, SDL_KEYDOWN, SDL_KEYUP);
+	for (int i = 0; i < count; i++) {
+		nesinput_t input;
+		input_match_keyboard_pad(events[i], &input);
+		
+		if (input.nescode && events[i].key.keysym.scancode != ui.altspeed) { input_inject(controllers, input); }
+	}
+	
+	return true;
+}
+
+void input_set_strobe_poll(Input::Controllers *controllers) {
+	// Poll the pads when the game strobes them instead of only at the start of the frame
+	if (controllers && conf.misc_strobe_poll) { Input::Controllers::Pad::callback.Set(input_strobe_poll, controllers); }
+	else { Input::Controllers::Pad::callback.Unset(); }
+}
+
 void input_match_mouse(Input::Controllers *controllers, SDL_Event event) {
 	// Match mouse input to NES input
 	int x, y;
@@ -701,6 +739,7 @@ void input_config_read() {
 		ui.qload2 = SDL_GetScancodeFromName(inputconf.qload2);
 		
 		ui.screenshot = SDL_GetScancodeFromName(inputconf.screenshot);
+		ui.capture = SDL_GetScancodeFromName(inputconf.capture);
 		
 		ui.fdsflip = SDL_GetScancodeFromName(inputconf.fdsflip);
 		ui.fdsswitch = SDL_GetScancodeFromName(inputconf.fdsswitch);
@@ -783,6 +822,7 @@ void input_config_write() {
 		fprintf(fp, "qload2=%s\n", SDL_GetScancodeName(ui.qload2));
 		
 		fprintf(fp, "screenshot=%s\n", SDL_GetScancodeName(ui.screenshot));
+		fprintf(fp, "capture=%s\n", SDL_GetScancodeName(ui.capture));
 		
 		fprintf(fp, "fdsflip=%s\n", SDL_GetScancodeName(ui.fdsflip));
 		fprintf(fp, "fdsswitch=%s\n", SDL_GetScancodeName(ui.fdsswitch));
@@ -862,6 +902,7 @@ void input_set_default() {
 	ui.qload2 = SDL_GetScancodeFromName("F8");
 	
 	ui.screenshot = SDL_GetScancodeFromName("F9");
+	ui.capture = SDL_GetScancodeFromName("F10");
 	
 	ui.fdsflip = SDL_GetScancodeFromName("F3");
 	ui.fdsswitch = SDL_GetScancodeFromName("F4");
@@ -935,6 +976,7 @@ static int input_config_match(void* user, const char* section, const char* name,
 	else if (MATCH("ui", "qload2")) { pconfig->qload2 = strdup(value); }
 	
 	else if (MATCH("ui", "screenshot")) { pconfig->screenshot = strdup(value); }
+	else if (MATCH("ui", "capture")) { pconfig->capture = strdup(value); }
 	
 	else if (MATCH("ui", "fdsflip")) { pconfig->fdsflip = strdup(value); }
 	else if (MATCH("ui", "fdsswitch")) { pconfig->fdsswitch = strdup(value); }
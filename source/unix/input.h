@@ -20,6 +20,7 @@ typedef struct {
 	SDL_Scancode qload2;
 	
 	SDL_Scancode screenshot;
+	SDL_Scancode capture;
 	
 	SDL_Scancode fdsflip;
 	SDL_Scancode fdsswitch;
@@ -70,6 +71,7 @@ typedef struct {
 	char *qload2;
 	
 	char *screenshot;
+	char *capture;
 	
 	char *fdsflip;
 	char *fdsswitch;
@@ -154,6 +156,7 @@ void input_joysticks_detect();
 void input_joysticks_close();
 void input_process(Input::Controllers *controllers, SDL_Event event);
 void input_pulse_turbo(Input::Controllers *controllers);
+void input_set_strobe_poll(Input::Controllers *controllers);
 void input_inject(Input::Controllers *controllers, nesinput_t input);
 void input_match_joystick(Input::Controllers *controllers, SDL_Event event);
 void input_match_keyboard(Input::Controllers *controllers, SDL_Event event);
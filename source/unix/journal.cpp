@@ -0,0 +1,397 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2016 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// The core reports the ranges of save data that changed at the end of every
+// frame. They are appended to a buffer by the emulation thread and written to
+// <game>.jnl by a separate writer thread, which syncs the file after every
+// batch. When the game is loaded again the records are applied on top of the
+// regular save file, so nothing is lost if the emulator dies before it gets
+// to write the save. The frontend writes the rebuilt save file right away and
+// the journal starts over. A clean unload writes the save file as usual and
+// removes the journal again.
+//
+// Layout: "NJNL", then records of u8 action, u32 offset, u32 length, data.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef _MINGW
+#include <io.h>
+#define fsync _commit
+#define ftruncate _chsize
+#else
+#include <unistd.h>
+#endif
+
+#include <SDL.h>
+
+#include "core/api/NstApiEmulator.hpp"
+#include "core/api/NstApiUser.hpp"
+
+#include "main.h"
+#include "config.h"
+#include "journal.h"
+
+#define JOURNAL_MAGIC "NJNL"
+#define JOURNAL_HEADER 9
+
+using namespace Nes::Api;
+
+typedef struct {
+	unsigned char *data;
+	size_t size;
+	size_t capacity;
+} journalbuf_t;
+
+static journalbuf_t pending; // Filled by the emulation thread
+static journalbuf_t writing; // Drained by the writer thread
+
+static SDL_mutex *lock = NULL;
+static SDL_sem *wakeup = NULL;
+static SDL_sem *synced = NULL;
+static SDL_Thread *writerthread = NULL;
+
+static FILE *journalfile = NULL;
+static bool syncrequest = false;
+static bool quitrequest = false;
+
+static uint32_t recorded = 0; // Actions present in the journal
+static uint32_t saved = 0; // Actions written to their save files since loading
+
+extern settings_t conf;
+extern nstpaths_t nstpaths;
+
+static void journal_put32(unsigned char *p, uint32_t v) {
+	p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = (v >> 24) & 0xff;
+}
+
+static uint32_t journal_get32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void journal_path(char *path, size_t size) {
+	snprintf(path, size, "%s%s.jnl", nstpaths.savedir, nstpaths.gamename);
+}
+
+static int journal_save_action(int action) {
+	// Map a load or save request to the save action its records are made with
+	switch (action) {
+		case User::File::LOAD_BATTERY: case User::File::SAVE_BATTERY: return User::File::SAVE_BATTERY;
+		case User::File::LOAD_EEPROM: case User::File::SAVE_EEPROM: return User::File::SAVE_EEPROM;
+		case User::File::LOAD_TURBOFILE: case User::File::SAVE_TURBOFILE: return User::File::SAVE_TURBOFILE;
+		case User::File::LOAD_FDS: case User::File::SAVE_FDS: return User::File::SAVE_FDS;
+		default: return -1;
+	}
+}
+
+static long journal_parse(FILE *fp, int action, unsigned char *data, unsigned long size, uint32_t *mask) {
+	// Walk the records, applying those of the given action. Returns the end
+	// of the last complete record, or 0 if the file is not a journal.
+	unsigned char header[JOURNAL_HEADER];
+	long end, filesize;
+
+	fseek(fp, 0, SEEK_END);
+	filesize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if (fread(header, 1, 4, fp) != 4 || memcmp(header, JOURNAL_MAGIC, 4)) { return 0; }
+
+	end = 4;
+
+	while (fread(header, 1, JOURNAL_HEADER, fp) == JOURNAL_HEADER) {
+		uint32_t offset = journal_get32(header + 1);
+		uint32_t length = journal_get32(header + 5);
+
+		if (header[0] >= 32 || length > (uint32_t)(filesize - end - JOURNAL_HEADER)) { break; }
+
+		if (header[0] == action && data && offset < size) {
+			uint32_t n = length < size - offset ? length : size - offset;
+			if (fread(data + offset, 1, n, fp) != n) { break; }
+			fseek(fp, length - n, SEEK_CUR);
+		}
+		else {
+			fseek(fp, length, SEEK_CUR);
+		}
+
+		if (mask) { *mask |= 1u << header[0]; }
+		end += JOURNAL_HEADER + length;
+	}
+
+	return end;
+}
+
+static bool journal_append(journalbuf_t *buf, const void *data, size_t size) {
+	if (buf->capacity < buf->size + size) {
+		size_t capacity = (buf->size + size) * 2;
+		unsigned char *grown = (unsigned char*)realloc(buf->data, capacity);
+		if (!grown) { return false; }
+		buf->data = grown;
+		buf->capacity = capacity;
+	}
+
+	memcpy(buf->data + buf->size, data, size);
+	buf->size += size;
+	return true;
+}
+
+static void NST_CALLBACK journal_record(void *userData, User::File::Action action, unsigned long offset, const void *data, unsigned long length) {
+	// Queue a changed range for the writer thread
+	unsigned char header[JOURNAL_HEADER];
+
+	header[0] = action;
+	journal_put32(header + 1, offset);
+	journal_put32(header + 5, length);
+
+	SDL_LockMutex(lock);
+
+	size_t start = pending.size;
+	bool idle = !start;
+	bool queued = journal_append(&pending, header, JOURNAL_HEADER) && journal_append(&pending, data, length);
+	if (!queued) { pending.size = start; }
+
+	SDL_UnlockMutex(lock);
+
+	if (!queued) {
+		fprintf(stderr, "Journal: Out of memory, dropping record\n");
+		return;
+	}
+
+	recorded |= 1u << action;
+
+	if (idle) { SDL_SemPost(wakeup); }
+}
+
+static int journal_writer(void *data) {
+	// Writer thread: write and sync whatever has queued up since the last pass
+	bool quit = false;
+
+	while (!quit) {
+		SDL_SemWait(wakeup);
+
+		SDL_LockMutex(lock);
+
+		journalbuf_t swap = writing;
+		writing = pending;
+		pending = swap;
+		pending.size = 0;
+
+		bool sync = syncrequest;
+		quit = quitrequest;
+		syncrequest = false;
+
+		SDL_UnlockMutex(lock);
+
+		if (writing.size && journalfile) {
+			fwrite(writing.data, 1, writing.size, journalfile);
+			fflush(journalfile);
+			fsync(fileno(journalfile));
+		}
+
+		writing.size = 0;
+
+		if (sync) { SDL_SemPost(synced); }
+	}
+
+	return 0;
+}
+
+static void journal_flush() {
+	// Wait until everything queued so far is on disk
+	SDL_LockMutex(lock);
+	syncrequest = true;
+	SDL_UnlockMutex(lock);
+
+	SDL_SemPost(wakeup);
+	SDL_SemWait(synced);
+}
+
+void journal_init() {
+	// Start the journal writer thread
+	if (writerthread) { return; }
+
+	memset(&pending, 0, sizeof(pending));
+	memset(&writing, 0, sizeof(writing));
+	syncrequest = quitrequest = false;
+
+	lock = SDL_CreateMutex();
+	wakeup = SDL_CreateSemaphore(0);
+	synced = SDL_CreateSemaphore(0);
+	writerthread = SDL_CreateThread(journal_writer, "journal", NULL);
+
+	if (!writerthread) {
+		fprintf(stderr, "Journal: Failed to create writer thread: %s\n", SDL_GetError());
+	}
+}
+
+void journal_deinit() {
+	// Close any open journal and stop the writer thread
+	if (!writerthread) { return; }
+
+	journal_close();
+
+	SDL_LockMutex(lock);
+	quitrequest = true;
+	SDL_UnlockMutex(lock);
+
+	SDL_SemPost(wakeup);
+	SDL_WaitThread(writerthread, NULL);
+	writerthread = NULL;
+
+	SDL_DestroyMutex(lock);
+	SDL_DestroySemaphore(wakeup);
+	SDL_DestroySemaphore(synced);
+
+	free(pending.data);
+	free(writing.data);
+	memset(&pending, 0, sizeof(pending));
+	memset(&writing, 0, sizeof(writing));
+}
+
+void journal_open() {
+	// Start journaling the save data of the loaded game
+	char path[512];
+
+	if (!writerthread || journalfile || !conf.misc_battery_journal) { return; }
+
+	journal_path(path, sizeof(path));
+
+	recorded = 0;
+
+	FILE *fp = fopen(path, "r+b");
+
+	if (fp) {
+		// Drop a record torn by a crash while it was being written
+		long end = journal_parse(fp, -1, NULL, 0, &recorded);
+
+		// Start over once everything replayed at load is in the save files
+		if (!end || !(recorded & ~saved)) {
+			end = 0;
+			recorded = 0;
+		}
+
+		fflush(fp);
+
+		if (ftruncate(fileno(fp), end)) {
+			fprintf(stderr, "Journal: Failed to truncate %s\n", path);
+			fclose(fp);
+			return;
+		}
+
+		fseek(fp, end, SEEK_SET);
+
+		if (!end) { fwrite(JOURNAL_MAGIC, 1, 4, fp); }
+	}
+	else if ((fp = fopen(path, "wb"))) {
+		fwrite(JOURNAL_MAGIC, 1, 4, fp);
+	}
+	else {
+		fprintf(stderr, "Journal: Failed to open %s\n", path);
+		return;
+	}
+
+	fflush(fp);
+	journalfile = fp;
+	saved = 0;
+
+	User::journalCallback.Set(journal_record, NULL);
+}
+
+void journal_close() {
+	// Stop journaling. Once every journaled kind of data has been written to
+	// its save file the journal is no longer needed.
+	char path[512];
+
+	if (!journalfile) {
+		recorded = saved = 0;
+		return;
+	}
+
+	User::journalCallback.Unset();
+
+	journal_flush();
+
+	fclose(journalfile);
+	journalfile = NULL;
+
+	uint32_t unsaved = recorded & ~saved;
+	recorded = saved = 0;
+
+	if (unsaved) { return; }
+
+	#ifndef _MINGW
+	sync(); // Make sure the save files are on disk before the journal goes
+	#endif
+
+	journal_path(path, sizeof(path));
+	remove(path);
+}
+
+void journal_saved(int action) {
+	// Note that the save file for this kind of data has been written, either
+	// at load time with the journal replayed into it or since the journal opened
+	int saveaction = journal_save_action(action);
+	if (saveaction >= 0) { saved |= 1u << saveaction; }
+}
+
+bool journal_pending(int action) {
+	// Check whether the journal holds records to apply when loading
+	char path[512];
+	uint32_t mask = 0;
+	int saveaction = journal_save_action(action);
+
+	if (!conf.misc_battery_journal || saveaction < 0) { return false; }
+
+	journal_path(path, sizeof(path));
+
+	FILE *fp = fopen(path, "rb");
+
+	if (!fp) { return false; }
+
+	journal_parse(fp, -1, NULL, 0, &mask);
+	fclose(fp);
+
+	return mask & (1u << saveaction);
+}
+
+bool journal_replay(int action, unsigned char *data, unsigned long size) {
+	// Apply the journaled changes on top of the loaded save data
+	char path[512];
+	int saveaction = journal_save_action(action);
+
+	if (saveaction < 0) { return false; }
+
+	journal_path(path, sizeof(path));
+
+	FILE *fp = fopen(path, "rb");
+
+	if (!fp) { return false; }
+
+	long end = journal_parse(fp, saveaction, data, size, NULL);
+	fclose(fp);
+
+	if (!end) { return false; }
+
+	fprintf(stderr, "Journal: Replayed %s\n", path);
+
+	return true;
+}
@@ -0,0 +1,12 @@
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+void journal_init();
+void journal_deinit();
+void journal_open();
+void journal_close();
+void journal_saved(int action);
+bool journal_pending(int action);
+bool journal_replay(int action, unsigned char *data, unsigned long size);
+
+#endif
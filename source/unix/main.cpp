@@ -55,6 +55,8 @@
 #include "cli.h"
 #include "audio.h"
 #include "video.h"
+#include "capture.h"
+#include "journal.h"
 #include "input.h"
 #include "config.h"
 #include "cheats.h"
@@ -93,6 +95,9 @@ static std::ifstream *fdsbios;
 static std::ifstream *moviefile;
 static std::fstream *movierecfile;
 
+char *hashtracepath = NULL;
+static FILE *hashtrace;
+
 extern settings_t conf;
 extern bool altspeed;
 
@@ -174,7 +179,35 @@ static void NST_CALLBACK nst_cb_file(void *userData, User::File& file) {
 		{		
 			std::ifstream batteryFile(nstpaths.savename, std::ifstream::in|std::ifstream::binary);
 			
-			if (batteryFile.is_open()) { file.SetContent(batteryFile); }
+			if (journal_pending(file.GetAction())) {
+				// Rebuild the save data from the file and any changes journaled after it
+				std::vector<unsigned char> savedata(file.GetMaxSize());
+				void *raw;
+				unsigned long rawsize;
+				
+				if (savedata.empty()) { break; }
+				
+				file.GetRawStorage(raw, rawsize);
+				
+				if (raw && rawsize == savedata.size()) { memcpy(&savedata[0], raw, rawsize); }
+				if (batteryFile.is_open()) { batteryFile.read((char*)&savedata[0], savedata.size()); }
+				batteryFile.close();
+				
+				bool replayed = journal_replay(file.GetAction(), &savedata[0], savedata.size());
+				file.SetContent(&savedata[0], savedata.size());
+				
+				// The core sees no change to save at power off, so fold the
+				// replayed records into the save file now and let the journal start over
+				if (replayed) {
+					std::ofstream rebuilt(nstpaths.savename, std::ifstream::out|std::ifstream::binary);
+					if (rebuilt.is_open()) {
+						rebuilt.write((const char*)&savedata[0], savedata.size());
+						rebuilt.close();
+						if (rebuilt) { journal_saved(file.GetAction()); }
+					}
+				}
+			}
+			else if (batteryFile.is_open()) { file.SetContent(batteryFile); }
 			break;
 		}
 		
@@ -189,7 +222,11 @@ static void NST_CALLBACK nst_cb_file(void *userData, User::File& file) {
 
 			file.GetContent(savedata, savedatasize);
 
-			if (batteryFile.is_open()) { batteryFile.write((const char*) savedata, savedatasize); }
+			if (batteryFile.is_open()) {
+				batteryFile.write((const char*) savedata, savedatasize);
+				batteryFile.close();
+				if (batteryFile) { journal_saved(file.GetAction()); }
+			}
 
 			break;
 		}
@@ -207,18 +244,24 @@ static void NST_CALLBACK nst_cb_file(void *userData, User::File& file) {
 			{
 				snprintf(fdsname, sizeof(fdsname), "%s.ips", nstpaths.fdssave);
 
-				std::ifstream batteryFile( fdsname, std::ifstream::in|std::ifstream::binary );
-
-				if (!batteryFile.is_open())
-				{
-					return;
-				}
+				batteryFile.open( fdsname, std::ifstream::in|std::ifstream::binary );
+			}
 
+			if (batteryFile.is_open())
 				file.SetPatchContent(batteryFile);
-				return;
+
+			// apply any disk writes journaled after the patch was saved
+			if (journal_pending(file.GetAction()))
+			{
+				void *raw;
+				unsigned long rawsize;
+
+				file.GetRawStorage(raw, rawsize);
+
+				if (raw)
+					journal_replay(file.GetAction(), (unsigned char*)raw, rawsize);
 			}
 
-			file.SetPatchContent(batteryFile);
 			break;
 		}
 
@@ -230,26 +273,57 @@ static void NST_CALLBACK nst_cb_file(void *userData, User::File& file) {
 
 			std::ofstream fdsFile( fdsname, std::ifstream::out|std::ifstream::binary );
 
-			if (fdsFile.is_open())
-				file.GetPatchContent( User::File::PATCH_UPS, fdsFile );
+			if (fdsFile.is_open() && NES_SUCCEEDED(file.GetPatchContent( User::File::PATCH_UPS, fdsFile )))
+			{
+				fdsFile.close();
+
+				if (fdsFile)
+					journal_saved(file.GetAction());
+			}
 
 			break;
 		}
 	}
 }
 
+static void nst_hash_trace() {
+	// Log the machine state hash after each frame for desync hunting
+	Machine::StateHash hash;
+	
+	if (!hashtrace || NES_FAILED(Machine(emulator).HashState(hash))) { return; }
+	
+	fprintf(hashtrace, "%lu %08x%08x\n", emulator.Frame(), (unsigned)hash.hi, (unsigned)hash.lo);
+}
+
+static void nst_free_outputs() {
+	// Drop the pad callback before the controllers it points at are freed
+	input_set_strobe_poll(NULL);
+	
+	delete cNstVideo; cNstVideo = NULL;
+	delete cNstSound; cNstSound = NULL;
+	delete cNstPads; cNstPads = NULL;
+}
+
 static void nst_unload() {
 	// Remove the cartridge and shut down the NES
 	Machine machine(emulator);
 	
 	if (!loaded) { return; }
 	
+	// Finish any audio/video capture in progress
+	capture_stop();
+	
 	// Power down the NES
 	fprintf(stderr, "\rEmulation stopped\n");
 	machine.Power(false);
 
 	// Remove the cartridge
 	machine.Unload();
+	
+	// The save files are written, retire the journal
+	journal_close();
+	
+	nst_free_outputs();
 }
 
 void nst_pause() {
@@ -436,10 +510,14 @@ void nst_play() {
 	input_init();
 	cheats_init();
 	
+	nst_free_outputs();
+	
 	cNstVideo = new Video::Output;
 	cNstSound = new Sound::Output;
 	cNstPads  = new Input::Controllers;
 	
+	input_set_strobe_poll(cNstPads);
+	
 	audio_set_params(cNstSound);
 	audio_unpause();
 	
@@ -458,6 +536,7 @@ void nst_reset(bool hardreset) {
 	Machine machine(emulator);
 	Fds fds(emulator);
 	machine.SetRamPowerState(conf.misc_power_state);
+	machine.SetCpuFetch(conf.misc_direct_fetch ? Machine::CPU_FETCH_DIRECT : Machine::CPU_FETCH_MAPPED);
 	machine.Reset(hardreset);
 	
 	// Set the FDS disk to defaults
@@ -520,6 +599,16 @@ void nst_set_dirs() {
 		fprintf(stderr, "Failed to create %s: %d\n", dirstr, errno);
 	}
 	
+	// create captures directory if it doesn't exist
+	snprintf(dirstr, sizeof(dirstr), "%scaptures", nstpaths.nstdir);
+#ifdef _MINGW	
+	if (mkdir(dirstr) && errno != EEXIST) {
+#else
+	if (mkdir(dirstr, 0755) && errno != EEXIST) {
+#endif
+		fprintf(stderr, "Failed to create %s: %d\n", dirstr, errno);
+	}
+	
 	// Construct the custom palette path
 	snprintf(nstpaths.palettepath, sizeof(nstpaths.palettepath), "%s%s", nstpaths.nstdir, "custom.pal");
 }
@@ -749,6 +838,8 @@ void nst_load_fds_bios() {
 	Nes::Api::Fds fds(emulator);
 	char biospath[512];
 	
+	fds.SetFastLoad(conf.misc_fds_fastload);
+	
 	if (fdsbios) { return; }
 
 	snprintf(biospath, sizeof(biospath), "%sdisksys.rom", nstpaths.nstdir);
@@ -918,6 +1009,10 @@ void nst_load(const char *filename) {
 	
 	// Set the RAM's power state
 	machine.SetRamPowerState(conf.misc_power_state);
+	machine.SetCpuFetch(conf.misc_direct_fetch ? Machine::CPU_FETCH_DIRECT : Machine::CPU_FETCH_MAPPED);
+	
+	// Journal changes to the save data
+	journal_open();
 	
 	// Power on
 	machine.Power(true);
@@ -953,12 +1048,27 @@ int main(int argc, char *argv[]) {
 	// Handle command line arguments
 	cli_handle_command(argc, argv);
 	
+	// Open the state hash trace
+	if (hashtracepath) {
+		hashtrace = strcmp(hashtracepath, "-") ? fopen(hashtracepath, "w") : stdout;
+		if (!hashtrace) {
+			fprintf(stderr, "Fatal: Could not open %s\n", hashtracepath);
+			return 1;
+		}
+	}
+	
 	// Initialize SDL
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK) < 0) {
 		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
 		return 1;
 	}
 	
+	// Start the capture writer thread
+	capture_init();
+	
+	// Start the save journal writer thread
+	journal_init();
+	
 	// Detect Joysticks
 	input_joysticks_detect();
 	
@@ -1063,11 +1173,13 @@ int main(int argc, char *argv[]) {
 				// Pulse the turbo buttons
 				input_pulse_turbo(cNstPads);
 				
-				// Execute a frame
-				if (timing_frameskip()) {
+				// Execute a frame, never skipping video while capturing
+				if (timing_frameskip() && !capture_active()) {
 					emulator.Execute(NULL, cNstSound, cNstPads);
 				}
 				else { emulator.Execute(cNstVideo, cNstSound, cNstPads); }
+				
+				nst_hash_trace();
 			}
 		}
 	}
@@ -1075,11 +1187,20 @@ int main(int argc, char *argv[]) {
 	// Remove the cartridge and shut down the NES
 	nst_unload();
 	
+	// Close the state hash trace
+	if (hashtrace && hashtrace != stdout) { fclose(hashtrace); }
+	
 	// Unload the FDS BIOS, NstDatabase.xml, and the custom palette
 	if (nstdb) { delete nstdb; nstdb = NULL; }
 	if (fdsbios) { delete fdsbios; fdsbios = NULL; }
 	if (custompalette) { free(custompalette); }
 	
+	// Flush pending captures and stop the writer thread
+	capture_deinit();
+	
+	// Stop the save journal writer thread
+	journal_deinit();
+	
 	// Deinitialize audio
 	audio_deinit();
 	
@@ -0,0 +1,287 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2016 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Batch NSF rendering. Every selected track gets its own emulator instance,
+// loaded from the same in-memory image, so tracks are independent and are
+// handed out to one worker thread per CPU. Frames are run without video as
+// fast as the core allows and written straight to a WAV file per track.
+// Expansion audio is whatever the NSF header asks for, exactly as in normal
+// playback, and the configured sample rate, speaker mode and channel volumes
+// are applied to each instance.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include <SDL.h>
+
+#include "core/api/NstApiEmulator.hpp"
+#include "core/api/NstApiMachine.hpp"
+#include "core/api/NstApiSound.hpp"
+#include "core/api/NstApiNsf.hpp"
+
+#include "config.h"
+#include "audio.h"
+#include "capture.h"
+#include "nsfexport.h"
+
+using namespace Nes::Api;
+
+// Exact NTSC and PAL frame rates as fractions
+#define FPS_NTSC_NUM 39375000
+#define FPS_NTSC_DEN 655171
+#define FPS_PAL_NUM  26601712
+#define FPS_PAL_DEN  531960
+
+// Peak-to-peak amplitude below which a frame counts as silent
+#define SILENCE_LEVEL 64
+
+// Largest data chunk a WAV header can describe, RIFF size included
+#define WAV_MAX_BYTES (0xFFFFFFFFULL - 36)
+
+nsfexportopts_t nsfexportopts = { NULL, NULL, 180, 3 };
+
+extern settings_t conf;
+
+typedef struct {
+	std::string image;
+	std::string basename;
+	std::vector<unsigned int> tracks;
+	SDL_atomic_t next;
+	SDL_atomic_t failed;
+} nsfexportjob_t;
+
+static bool nsfexport_track(nsfexportjob_t *job, unsigned int track) {
+	// Render one track to its own WAV file
+	Emulator emulator;
+	Machine machine(emulator);
+	Sound sound(emulator);
+
+	std::istringstream stream(job->image);
+
+	if (NES_FAILED(machine.Load(stream, Machine::FAVORED_NES_NTSC))) { return false; }
+
+	int rate = conf.audio_sample_rate;
+	int chans = conf.audio_stereo ? 2 : 1;
+
+	sound.SetSampleBits(16);
+	sound.SetSampleRate(rate);
+	sound.SetSpeaker(conf.audio_stereo ? Sound::SPEAKER_STEREO : Sound::SPEAKER_MONO);
+	audio_set_volumes(sound);
+
+	machine.Power(true);
+
+	Nsf nsf(emulator);
+	if (NES_FAILED(nsf.SelectSong(track)) || NES_FAILED(nsf.PlaySong())) { return false; }
+
+	bool pal = machine.GetMode() == Machine::PAL;
+	uint64_t num = pal ? FPS_PAL_NUM : FPS_NTSC_NUM;
+	uint64_t den = pal ? FPS_PAL_DEN : FPS_NTSC_DEN;
+
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s-%02u.wav", nsfexportopts.outdir, job->basename.c_str(), track + 1);
+
+	FILE *fp = fopen(path, "wb");
+	if (!fp) {
+		fprintf(stderr, "NSF export: could not write %s\n", path);
+		return false;
+	}
+
+	capture_wav_header(fp, rate, chans, 0);
+
+	uint64_t maxframes = (uint64_t)nsfexportopts.length * num / den;
+	uint64_t silencelimit = (uint64_t)nsfexportopts.silence * num / den;
+	uint64_t silentframes = 0;
+	uint64_t bytes = 0;
+	bool truncated = false;
+
+	// Room for the longest frame at this rate
+	std::vector<int16_t> buf(((uint64_t)rate * den / num + 2) * chans);
+	std::vector<int16_t> pending; // Silence that is only kept if sound follows
+
+	for (uint64_t frame = 0; frame < maxframes; frame++) {
+		// Sample count for this frame at the exact frame rate
+		uint64_t count = (frame + 1) * rate * den / num - frame * rate * den / num;
+		int samples = count * chans;
+
+		Sound::Output output(&buf[0], (unsigned int)count);
+		emulator.Execute(NULL, &output, NULL);
+
+		int lo = 32767, hi = -32768;
+		for (int i = 0; i < samples; i++) {
+			if (buf[i] < lo) { lo = buf[i]; }
+			if (buf[i] > hi) { hi = buf[i]; }
+		}
+
+		if (hi - lo < SILENCE_LEVEL) {
+			pending.insert(pending.end(), buf.begin(), buf.begin() + samples);
+			if (++silentframes >= silencelimit) { break; }
+			continue;
+		}
+
+		if (bytes + (pending.size() + samples) * sizeof(int16_t) > WAV_MAX_BYTES) {
+			truncated = true;
+			break;
+		}
+
+		if (!pending.empty()) {
+			fwrite(&pending[0], sizeof(int16_t), pending.size(), fp);
+			bytes += pending.size() * sizeof(int16_t);
+			pending.clear();
+		}
+
+		fwrite(&buf[0], sizeof(int16_t), samples, fp);
+		bytes += samples * sizeof(int16_t);
+		silentframes = 0;
+	}
+
+	// Trailing silence is dropped, patch the final size into the header
+	fseek(fp, 0, SEEK_SET);
+	capture_wav_header(fp, rate, chans, (uint32_t)bytes);
+	fclose(fp);
+
+	if (truncated) { fprintf(stderr, "NSF export: %s stopped at the 4 GB WAV size limit\n", path); }
+
+	fprintf(stderr, "NSF export: %s (%.1fs)\n", path, (double)bytes / (rate * chans * sizeof(int16_t)));
+
+	return true;
+}
+
+static int nsfexport_worker(void *data) {
+	// Take tracks off the shared list until it runs out
+	nsfexportjob_t *job = (nsfexportjob_t*)data;
+
+	for (;;) {
+		unsigned int i = SDL_AtomicAdd(&job->next, 1);
+		if (i >= job->tracks.size()) { break; }
+		if (!nsfexport_track(job, job->tracks[i])) { SDL_AtomicSet(&job->failed, 1); }
+	}
+
+	return 0;
+}
+
+static bool nsfexport_parse_tracks(const char *list, unsigned int numsongs, std::vector<unsigned int>& tracks) {
+	// Parse a 1-based list such as "1,3-5,9"
+	if (!list) {
+		for (unsigned int i = 0; i < numsongs; i++) { tracks.push_back(i); }
+		return true;
+	}
+
+	while (*list) {
+		char *end;
+		long first = strtol(list, &end, 10);
+		long last = first;
+
+		if (end == list) { return false; }
+		if (*end == '-') {
+			list = end + 1;
+			last = strtol(list, &end, 10);
+			if (end == list) { return false; }
+		}
+
+		if (first < 1 || last < first || last > (long)numsongs) { return false; }
+
+		for (long i = first; i <= last; i++) { tracks.push_back(i - 1); }
+
+		if (*end == ',') { end++; }
+		else if (*end) { return false; }
+
+		list = end;
+	}
+
+	return !tracks.empty();
+}
+
+int nsfexport_run(const char *filename) {
+	// Render the selected tracks of an NSF in parallel
+	nsfexportjob_t job;
+
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "NSF export: could not open %s\n", filename);
+		return 1;
+	}
+
+	char buf[4096];
+	size_t len;
+	while ((len = fread(buf, 1, sizeof(buf), file)) > 0) { job.image.append(buf, len); }
+	fclose(file);
+
+	// Probe the header once for the song count and chips
+	unsigned int numsongs, chips;
+	{
+		Emulator emulator;
+		Machine machine(emulator);
+		std::istringstream stream(job.image);
+
+		if (NES_FAILED(machine.Load(stream, Machine::FAVORED_NES_NTSC)) || !machine.Is(Machine::SOUND)) {
+			fprintf(stderr, "NSF export: %s is not an NSF\n", filename);
+			return 1;
+		}
+
+		Nsf nsf(emulator);
+		numsongs = nsf.GetNumSongs();
+		chips = nsf.GetChips();
+	}
+
+	if (!nsfexport_parse_tracks(nsfexportopts.tracks, numsongs, job.tracks)) {
+		fprintf(stderr, "NSF export: invalid track list, %s has %u tracks\n", filename, numsongs);
+		return 1;
+	}
+
+	const char *base = strrchr(filename, '/');
+	job.basename = base ? base + 1 : filename;
+	size_t dot = job.basename.rfind('.');
+	if (dot != std::string::npos && dot) { job.basename.erase(dot); }
+
+	SDL_AtomicSet(&job.next, 0);
+	SDL_AtomicSet(&job.failed, 0);
+
+	int numthreads = SDL_GetCPUCount();
+	if (numthreads > (int)job.tracks.size()) { numthreads = job.tracks.size(); }
+	if (numthreads < 1) { numthreads = 1; }
+
+	fprintf(stderr, "NSF export: %u of %u tracks, %d threads%s%s%s%s%s%s\n",
+		(unsigned int)job.tracks.size(), numsongs, numthreads,
+		chips & Nsf::CHIP_VRC6 ? ", VRC6" : "",
+		chips & Nsf::CHIP_VRC7 ? ", VRC7" : "",
+		chips & Nsf::CHIP_FDS ? ", FDS" : "",
+		chips & Nsf::CHIP_MMC5 ? ", MMC5" : "",
+		chips & Nsf::CHIP_N163 ? ", N163" : "",
+		chips & Nsf::CHIP_S5B ? ", S5B" : "");
+
+	std::vector<SDL_Thread*> threads;
+	for (int i = 1; i < numthreads; i++) {
+		SDL_Thread *thread = SDL_CreateThread(nsfexport_worker, "nsfexport", &job);
+		if (thread) { threads.push_back(thread); }
+	}
+
+	// The calling thread works through the list as well
+	nsfexport_worker(&job);
+
+	for (size_t i = 0; i < threads.size(); i++) { SDL_WaitThread(threads[i], NULL); }
+
+	return SDL_AtomicGet(&job.failed) ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+#ifndef _NSFEXPORT_H_
+#define _NSFEXPORT_H_
+
+typedef struct {
+	const char *outdir;
+	const char *tracks;
+	int length;
+	int silence;
+} nsfexportopts_t;
+
+int nsfexport_run(const char *filename);
+
+#endif
@@ -23,6 +23,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "core/api/NstApiEmulator.hpp"
@@ -35,6 +36,7 @@
 #include "video.h"
 #include "config.h"
 #include "cursor.h"
+#include "capture.h"
 #include "font.h"
 #include "png.h"
 
@@ -56,7 +58,8 @@ char timebuf[6];
 
 int overscan_offset, overscan_height;
 
-static uint32_t videobuf[31457280]; // Maximum possible internal size
+static uint32_t *videobuf = NULL; // Sized to the active render state
+static size_t videobuf_size = 0;
 
 SDL_Window *sdlwindow;
 SDL_Window *embedwindow;
@@ -102,6 +105,13 @@ GLuint fshader;
 GLuint gl_shader_prog = 0;
 GLuint gl_texture_id = 0;
 
+// Ring of pixel unpack buffers so a texture upload never waits on the
+// previous one still being consumed by the driver
+#define NUM_PBOS 3
+GLuint gl_pbo[NUM_PBOS] = { 0 };
+int gl_pbo_index = 0;
+GLsizeiptr gl_pbo_size = 0;
+
 void ogl_init() {
 	// Initialize OpenGL
 	
@@ -166,6 +176,26 @@ void ogl_init() {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, conf.video_linear_filter ? GL_LINEAR : GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	
+	// Allocate the texture once for the current dimensions, frames are
+	// only ever uploaded into it with glTexSubImage2D
+	if (epoxy_gl_version() >= 42 || epoxy_has_gl_extension("GL_ARB_texture_storage")) {
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, basesize.w, overscan_height);
+	}
+	else {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, basesize.w, overscan_height, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+	}
+	
+	gl_pbo_size = basesize.w * overscan_height * sizeof(uint32_t);
+	gl_pbo_index = 0;
+	
+	glGenBuffers(NUM_PBOS, gl_pbo);
+	for (int i = 0; i < NUM_PBOS; i++) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl_pbo[i]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, gl_pbo_size, NULL, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	
 	conf.video_fullscreen ? 
 	glViewport(displaymode.w / 2.0f - rendersize.w / 2.0f, 0, rendersize.w, rendersize.h) :
 	glViewport(0, 0, rendersize.w, rendersize.h);
@@ -176,6 +206,7 @@ void ogl_init() {
 void ogl_deinit() {
 	// Deinitialize OpenGL
 	if (gl_texture_id) { glDeleteTextures(1, &gl_texture_id); }
+	if (gl_pbo[0]) { glDeleteBuffers(NUM_PBOS, gl_pbo); memset(gl_pbo, 0, sizeof(gl_pbo)); }
 	if (gl_shader_prog) { glDeleteProgram(gl_shader_prog); }
 	if (vshader) { glDeleteShader(vshader); }
 	if (fshader) { glDeleteShader(fshader); }
@@ -185,15 +216,33 @@ void ogl_deinit() {
 
 void ogl_render() {
 	// Render the scene
-	glTexImage2D(GL_TEXTURE_2D,
+	const GLvoid *pixels = videobuf + overscan_offset;
+	
+	// Stage the frame in the next unpack buffer. Invalidating it lets the
+	// driver hand back fresh storage instead of syncing with the GPU.
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl_pbo[gl_pbo_index]);
+	void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, gl_pbo_size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	
+	if (mapped) {
+		memcpy(mapped, pixels, gl_pbo_size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		pixels = 0; // Offset into the bound unpack buffer
+		gl_pbo_index = (gl_pbo_index + 1) % NUM_PBOS;
+	}
+	else { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); }
+	
+	glTexSubImage2D(GL_TEXTURE_2D,
+				0,
+				0,
 				0,
-				GL_RGBA,
 				basesize.w,
 				overscan_height,
-				0,
 				GL_BGRA,
 				GL_UNSIGNED_BYTE,
-		videobuf + overscan_offset);
+		pixels);
+	
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 	
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
@@ -585,6 +634,18 @@ void video_set_filter() {
 	renderstate.height = basesize.h;
 	renderstate.bits.count = 32;
 	
+	// Size the video buffer to what the core will render
+	size_t size = (size_t)renderstate.width * renderstate.height;
+	if (size != videobuf_size) {
+		free(videobuf);
+		videobuf = (uint32_t*)calloc(size, sizeof(uint32_t));
+		if (!videobuf) {
+			fprintf(stderr, "Failed to allocate video buffer\n");
+			exit(1);
+		}
+		videobuf_size = size;
+	}
+	
 	#if SDL_BYTEORDER == SDL_BIG_ENDIAN
 	renderstate.bits.mask.r = 0x000000ff;
 	renderstate.bits.mask.g = 0xff000000;
@@ -714,6 +775,8 @@ long video_lock_screen(void*& ptr) {
 
 void video_unlock_screen(void*) {
 	
+	capture_video(videobuf + overscan_offset, basesize.w, overscan_height);
+	
 	int wscale = renderstate.width / 256;
 	int hscale = renderstate.height / 240;
 	
@@ -730,51 +793,23 @@ void video_unlock_screen(void*) {
 	ogl_render();
 }
 
-void video_screenshot_flip(unsigned char *pixels, int width, int height, int bytes) {
-	// Flip the pixels
-	int rowsize = width * bytes;
-	unsigned char *row = (unsigned char*)malloc(rowsize);
-	unsigned char *low = pixels;
-	unsigned char *high = &pixels[(height - 1) * rowsize];
-	
-	for (; low < high; low += rowsize, high -= rowsize) {
-		memcpy(row, low, rowsize);
-		memcpy(low, high, rowsize);
-		memcpy(high, row, rowsize);
-	}
-	free(row);
-}
-
 void video_screenshot(const char* filename) {
-	// Take a screenshot in .png format
-	unsigned char *pixels;
-	pixels = (unsigned char*)malloc(sizeof(unsigned char) * rendersize.w * rendersize.h * 4);
-	
-	// Read the pixels and flip them vertically
-	glReadPixels(0, 0, rendersize.w, rendersize.h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-	video_screenshot_flip(pixels, rendersize.w, rendersize.h, 4);
-	
+	// Take a screenshot in .png format, encoded on the capture thread
+	// This is the filtered frame at its native size, without window scaling or on-screen text
 	if (filename == NULL) {
 		// Set the filename
 		char sshotpath[512];
 		snprintf(sshotpath, sizeof(sshotpath), "%sscreenshots/%s-%d-%d.png", nstpaths.nstdir, nstpaths.gamename, time(NULL), rand() % 899 + 100);
-		
-		// Save the file
-		lodepng_encode32_file(sshotpath, (const unsigned char*)pixels, rendersize.w, rendersize.h);
-		fprintf(stderr, "Screenshot: %s\n", sshotpath);
+		capture_screenshot(videobuf + overscan_offset, basesize.w, overscan_height, sshotpath);
 	}
 	else {
-		lodepng_encode32_file(filename, (const unsigned char*)pixels, rendersize.w, rendersize.h);
+		capture_screenshot(videobuf + overscan_offset, basesize.w, overscan_height, filename);
 	}
-	
-	free(pixels);
 }
 
 void video_clear_buffer() {
 	// Write black to the video buffer
-	for (int i = 0; i < 31457280; i++) {
-		videobuf[i] = 0x00000000;
-	}
+	if (videobuf) { memset(videobuf, 0, videobuf_size * sizeof(uint32_t)); }
 }
 
 void video_disp_nsf() {